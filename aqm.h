@@ -0,0 +1,358 @@
+// aqm.h - 병목 링크 앞의 큐와 큐 관리 방식 (router.c)
+//   droptail : 버퍼(패킷 수)가 가득 차면 도착한 패킷을 버림
+//   red      : Floyd & Jacobson RED. 도착마다 평균 큐 길이(EWMA, 유휴 시간만큼 감쇠)를 갱신하고
+//              min..max 사이에서는 선형으로 커지는 확률(직전 드롭 이후 개수로 보정)로, max 이상은 모두 버림
+//   codel    : RFC 8289 CoDel. 꺼낼 때 체류 시간(sojourn)이 interval 동안 target 을 넘으면 드롭 상태로
+//              들어가 interval/sqrt(count) 간격으로 머리 패킷을 버림
+// 세 방식 모두 버퍼가 가득 차면 tail drop 을 함께 한다. force 로 넣은 패킷(END 같은 제어 세그먼트)은
+// 버리지 않는다. 큐는 고정 크기 슬롯의 링이라 패킷마다 malloc 이 없다.
+// 통계: 체류 시간과 도착 시점 큐 길이의 히스토그램(hist.h), 시간 가중 평균 큐 길이, 드롭 원인별 수.
+//
+// 설정 문자열 예: "droptail", "red", "red:20:60:0.1:0.002" (min:max:maxp:wq, 패킷 단위),
+//                 "codel", "codel:5ms:100ms" (target:interval)
+#ifndef AQM_H
+#define AQM_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "hist.h"
+#include "impair.h"
+
+#define AQM_SLOT 2048         // 슬롯 하나 (헤더 + MSS, 텍스트 형식 포함)
+#define AQM_FORCE_EXTRA 64    // 버퍼가 가득 차도 force 패킷을 넣을 여유 슬롯
+#define AQM_CODEL_TARGET 5000 // us
+#define AQM_CODEL_INTERVAL 100000
+
+enum
+{
+    AQM_DROPTAIL,
+    AQM_RED,
+    AQM_CODEL
+};
+
+typedef struct
+{
+    int kind;
+    double red_min, red_max, red_maxp, red_wq; // 0 이면 버퍼 크기로 정하는 기본값
+    uint64_t codel_target, codel_interval;
+    uint64_t seed;
+} AqmCfg;
+
+typedef struct
+{
+    uint64_t t_enq;
+    int len;
+    int tag;   // 호출한 쪽이 붙이는 값 (router 는 송신자 번호)
+    int force; // 버리지 않을 패킷 (CoDel 도 건너뜀)
+    uint8_t *data;
+} AqmPkt;
+
+typedef struct
+{
+    AqmCfg cfg;
+    int limit; // 버퍼 (패킷)
+    AqmPkt *ring;
+    uint8_t *slab;
+    uint32_t cap; // 2의 거듭제곱, limit + AQM_FORCE_EXTRA 이상
+    uint32_t head, n;
+    uint64_t bytes;
+
+    // RED
+    double avg;
+    int count;
+    uint64_t idle_since; // 큐가 빈 시각 (0 이면 비어 있지 않음)
+    uint64_t pkt_time;   // 패킷 하나의 전송 시간 (유휴 시간 감쇠용, us)
+    uint64_t rng;
+
+    // CoDel
+    uint64_t first_above_time, drop_next;
+    uint32_t cd_count, cd_lastcount;
+    int dropping;
+
+    // 통계
+    uint64_t enq, deq, drop_tail, drop_aqm, max_n;
+    uint64_t t_last, area; // 시간 가중 평균용: area = Σ n·dt (패킷·us)
+    uint64_t t_first;
+    Hist sojourn, occupancy;
+} Aqm;
+
+static inline const char *aqm_name(int kind)
+{
+    return kind == AQM_RED ? "red" : kind == AQM_CODEL ? "codel" : "droptail";
+}
+
+// 설정 문자열 해석. 성공 0, 잘못된 형식이면 -1
+static inline int aqm_parse(AqmCfg *c, const char *spec)
+{
+    memset(c, 0, sizeof(*c));
+    c->codel_target = AQM_CODEL_TARGET;
+    c->codel_interval = AQM_CODEL_INTERVAL;
+    c->seed = 1;
+
+    char tmp[BUF];
+    snprintf(tmp, sizeof(tmp), "%s", spec);
+    char *save = NULL, *name = strtok_r(tmp, ":", &save);
+    if (!name)
+        return -1;
+    if (strcmp(name, "droptail") == 0)
+        c->kind = AQM_DROPTAIL;
+    else if (strcmp(name, "red") == 0)
+        c->kind = AQM_RED;
+    else if (strcmp(name, "codel") == 0)
+        c->kind = AQM_CODEL;
+    else
+        return -1;
+
+    double *red[4] = {&c->red_min, &c->red_max, &c->red_maxp, &c->red_wq};
+    uint64_t *codel[2] = {&c->codel_target, &c->codel_interval};
+    int k = 0;
+    for (char *x = strtok_r(NULL, ":", &save); x; x = strtok_r(NULL, ":", &save), k++)
+    {
+        if (c->kind == AQM_RED && k < 4)
+        {
+            char *end;
+            *red[k] = strtod(x, &end);
+            if (end == x || *end || *red[k] < 0)
+                return -1;
+        }
+        else if (c->kind == AQM_CODEL && k < 2)
+        {
+            if (imp_parse_us(x, codel[k]) < 0 || *codel[k] == 0)
+                return -1;
+        }
+        else
+            return -1;
+    }
+    if (c->kind == AQM_RED && (c->red_maxp > 1 || c->red_wq > 1 ||
+                               (c->red_min && c->red_max && c->red_max <= c->red_min)))
+        return -1;
+    return 0;
+}
+
+// limit 패킷 버퍼의 큐. pkt_time 은 MSS 하나의 전송 시간(us, RED 의 유휴 감쇠에 씀)
+static inline void aqm_init(Aqm *q, const AqmCfg *cfg, int limit, uint64_t pkt_time)
+{
+    memset(q, 0, sizeof(*q));
+    q->cfg = *cfg;
+    q->limit = limit;
+    q->pkt_time = pkt_time ? pkt_time : 1;
+    q->cap = 1;
+    while (q->cap < (uint32_t)limit + AQM_FORCE_EXTRA)
+        q->cap <<= 1;
+    q->ring = calloc(q->cap, sizeof(AqmPkt));
+    q->slab = malloc((size_t)q->cap * AQM_SLOT);
+    if (!q->ring || !q->slab)
+        die("malloc aqm");
+    for (uint32_t i = 0; i < q->cap; i++)
+        q->ring[i].data = q->slab + (size_t)i * AQM_SLOT;
+
+    // RED 기본값: 버퍼의 1/4 ~ 3/4, maxp 0.1, wq 0.002
+    if (!q->cfg.red_min)
+        q->cfg.red_min = limit / 4 > 1 ? limit / 4 : 1;
+    if (!q->cfg.red_max)
+        q->cfg.red_max = 3 * limit / 4 > q->cfg.red_min ? 3 * limit / 4 : q->cfg.red_min + 1;
+    if (!q->cfg.red_maxp)
+        q->cfg.red_maxp = 0.1;
+    if (!q->cfg.red_wq)
+        q->cfg.red_wq = 0.002;
+    q->count = -1;
+    q->rng = cfg->seed;
+    hist_init(&q->sojourn);
+    hist_init(&q->occupancy);
+}
+
+static inline void aqm_free(Aqm *q)
+{
+    free(q->ring);
+    free(q->slab);
+    q->ring = NULL;
+    q->slab = NULL;
+}
+
+// 큐 길이가 바뀌기 직전에 호출 (시간 가중 평균)
+static inline void aqm_account(Aqm *q, uint64_t now)
+{
+    if (q->t_last && now > q->t_last)
+        q->area += (uint64_t)q->n * (now - q->t_last);
+    if (now > q->t_last)
+        q->t_last = now;
+}
+
+// [0, 1) 균등 분포 (splitmix64)
+static inline double aqm_uniform(Aqm *q)
+{
+    uint64_t z = (q->rng += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return ((z ^ (z >> 31)) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// RED: 도착한 패킷을 미리 버릴지
+static inline int aqm_red_drop(Aqm *q, uint64_t now)
+{
+    const AqmCfg *c = &q->cfg;
+    if (q->idle_since)
+    {
+        // 비어 있던 동안 보낼 수 있었던 패킷 수만큼 평균을 줄임
+        double m = (double)(now - q->idle_since) / q->pkt_time;
+        q->avg *= pow(1 - c->red_wq, m);
+        q->idle_since = now; // 버려져 계속 비어 있으면 여기부터 다시 감쇠
+    }
+    else
+        q->avg = (1 - c->red_wq) * q->avg + c->red_wq * q->n;
+
+    if (q->avg < c->red_min)
+    {
+        q->count = -1;
+        return 0;
+    }
+    if (q->avg >= c->red_max)
+    {
+        q->count = 0;
+        return 1;
+    }
+    q->count++;
+    double pb = c->red_maxp * (q->avg - c->red_min) / (c->red_max - c->red_min);
+    double pa = q->count * pb < 1 ? pb / (1 - q->count * pb) : 1;
+    if (aqm_uniform(q) < pa)
+    {
+        q->count = 0;
+        return 1;
+    }
+    return 0;
+}
+
+// 패킷을 큐에 넣는다 (데이터는 슬롯으로 복사). 버렸으면 -1.
+// force 면 버퍼와 AQM 판단을 무시하고 넣음 (여유 슬롯까지 차 있으면 그래도 버림)
+static inline int aqm_enqueue(Aqm *q, uint64_t now, const void *data, int len, int tag, int force)
+{
+    if (!q->t_first)
+        q->t_first = now;
+    hist_add(&q->occupancy, q->n);
+    if (len > AQM_SLOT || q->n >= q->cap || (!force && (int)q->n >= q->limit))
+    {
+        q->drop_tail++;
+        return -1;
+    }
+    int early = q->cfg.kind == AQM_RED && aqm_red_drop(q, now);
+    if (early && !force)
+    {
+        q->drop_aqm++;
+        return -1;
+    }
+
+    aqm_account(q, now);
+    AqmPkt *p = &q->ring[(q->head + q->n) & (q->cap - 1)];
+    memcpy(p->data, data, len);
+    p->len = len;
+    p->tag = tag;
+    p->force = force;
+    p->t_enq = now;
+    q->idle_since = 0;
+    q->n++;
+    q->bytes += len;
+    q->enq++;
+    if (q->n > q->max_n)
+        q->max_n = q->n;
+    return 0;
+}
+
+// 머리 패킷을 꺼냄 (CoDel 의 드롭 판단 없이)
+static inline AqmPkt *aqm_pop(Aqm *q, uint64_t now)
+{
+    if (!q->n)
+        return NULL;
+    aqm_account(q, now);
+    AqmPkt *p = &q->ring[q->head];
+    q->head = (q->head + 1) & (q->cap - 1);
+    q->n--;
+    q->bytes -= p->len;
+    if (!q->n)
+        q->idle_since = now;
+    return p;
+}
+
+// CoDel 의 dodequeue: 꺼낸 패킷이 interval 이상 target 을 넘는 체류 상태에 있으면 *ok_to_drop = 1
+static inline AqmPkt *aqm_codel_pop(Aqm *q, uint64_t now, int *ok_to_drop)
+{
+    *ok_to_drop = 0;
+    AqmPkt *p = aqm_pop(q, now);
+    if (!p)
+    {
+        q->first_above_time = 0;
+        return NULL;
+    }
+    uint64_t sojourn = now > p->t_enq ? now - p->t_enq : 0;
+    if (sojourn < q->cfg.codel_target || q->bytes <= MSS) // 남은 게 한 패킷 이하면 줄일 큐가 없음
+        q->first_above_time = 0;
+    else if (!q->first_above_time)
+        q->first_above_time = now + q->cfg.codel_interval;
+    else if (now >= q->first_above_time)
+        *ok_to_drop = 1;
+    return p;
+}
+
+static inline uint64_t aqm_control_law(const Aqm *q, uint64_t t)
+{
+    return t + (uint64_t)(q->cfg.codel_interval / sqrt((double)q->cd_count));
+}
+
+// 전송할 다음 패킷. CoDel 이면 그 사이에 버릴 패킷을 버린다. 반환한 패킷은 다음 aqm_enqueue 전까지 유효
+static inline AqmPkt *aqm_dequeue(Aqm *q, uint64_t now)
+{
+    AqmPkt *p;
+    if (q->cfg.kind != AQM_CODEL)
+        p = aqm_pop(q, now);
+    else
+    {
+        int ok;
+        p = aqm_codel_pop(q, now, &ok);
+        if (!p)
+            q->dropping = 0;
+        else if (q->dropping)
+        {
+            if (!ok)
+                q->dropping = 0;
+            while (p && !p->force && q->dropping && now >= q->drop_next)
+            {
+                q->drop_aqm++;
+                q->cd_count++;
+                p = aqm_codel_pop(q, now, &ok);
+                if (!ok)
+                    q->dropping = 0;
+                else
+                    q->drop_next = aqm_control_law(q, q->drop_next);
+            }
+        }
+        else if (ok && !p->force)
+        {
+            q->drop_aqm++;
+            p = aqm_codel_pop(q, now, &ok);
+            q->dropping = 1;
+            // 직전 드롭 상태에서 멀지 않으면 그때의 드롭 빈도에서 다시 시작
+            uint32_t delta = q->cd_count - q->cd_lastcount;
+            q->cd_count = delta > 1 && (int64_t)(now - q->drop_next) < (int64_t)(16 * q->cfg.codel_interval) ? delta : 1;
+            q->drop_next = aqm_control_law(q, now);
+            q->cd_lastcount = q->cd_count;
+        }
+    }
+    if (p)
+    {
+        q->deq++;
+        hist_add(&q->sojourn, now > p->t_enq ? now - p->t_enq : 0);
+    }
+    return p;
+}
+
+// 처음 도착부터 now 까지의 시간 가중 평균 큐 길이 (패킷)
+static inline double aqm_avg_len(Aqm *q, uint64_t now)
+{
+    aqm_account(q, now);
+    return now > q->t_first ? (double)q->area / (now - q->t_first) : 0;
+}
+
+#endif
@@ -0,0 +1,384 @@
+// batch_io.h - sendmmsg/recvmmsg 기반 배치 송수신
+// 윈도우 하나 분량의 세그먼트를 sendmmsg 한 번으로 보내고, 대기 중인 ACK/DATA 를
+// recvmmsg 한 번으로 미리 할당된 iovec 배열에 모두 받아온다.
+// sendmmsg/recvmmsg 가 없는 플랫폼(macOS 등)에서는 같은 인터페이스로 한 개씩 처리한다.
+// Linux 에서는 UDP GSO/GRO(-g) 도 다룬다: 송신측은 [헤더|페이로드] 세그먼트 여러 개를 이어 붙인
+// 슈퍼 데이터그램 하나를 UDP_SEGMENT 로 넘겨 커널이 세그먼트 크기로 자르게 하고, 수신측은 UDP_GRO 로
+// 합쳐진 묶음을 한 번에 받아 cmsg 의 세그먼트 크기로 다시 나눈다.
+#ifndef BATCH_IO_H
+#define BATCH_IO_H
+
+// Linux 에서는 sendmmsg/recvmmsg 선언을 위해 포함하는 쪽 .c 파일 맨 위에 _GNU_SOURCE 가 필요하다.
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+
+#include "common.h"
+#include "segment.h"
+
+#define IO_BATCH 1024  // 한 번의 syscall 로 처리할 최대 데이터그램 수 (UIO_MAXIOV)
+#define IO_HDR_MAX BUF // 슬롯당 헤더 버퍼 (바이너리 헤더 + SACK 블록, 텍스트 디버그 형식 포함)
+
+#if defined(__linux__)
+#include <netinet/udp.h>
+#define HAVE_MMSG 1
+#define HAVE_GSO 1
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#else
+#define HAVE_GSO 0
+#define HAVE_MMSG 0
+struct mmsghdr
+{
+    struct msghdr msg_hdr;
+    unsigned int msg_len;
+};
+#endif
+
+// ------------------------------ 송신 배치 ------------------------------
+// 슬롯마다 [헤더, 페이로드] 두 개의 iovec. 페이로드는 복사하지 않고 포인터만 건다.
+// 목적지 주소는 슬롯에 복사해 두므로 flush 전에 원래 주소 버퍼가 사라져도 된다.
+typedef struct
+{
+    struct mmsghdr msgs[IO_BATCH];
+    struct iovec iov[IO_BATCH][2];
+    struct sockaddr_in addr[IO_BATCH];
+    uint8_t hdr[IO_BATCH][IO_HDR_MAX];
+    int n;
+} TxBatch;
+
+static inline TxBatch *txb_new(void)
+{
+    TxBatch *b = calloc(1, sizeof(*b));
+    if (!b)
+        die("calloc txbatch");
+    return b;
+}
+
+static inline int txb_full(const TxBatch *b)
+{
+    return b->n == IO_BATCH;
+}
+
+// 다음 슬롯의 헤더 버퍼. 채운 뒤 txb_commit 으로 확정
+static inline uint8_t *txb_hdr(TxBatch *b)
+{
+    return b->hdr[b->n];
+}
+
+static inline void txb_commit(TxBatch *b, const struct sockaddr_in *dst, int hdr_len,
+                              const void *payload, size_t len)
+{
+    struct iovec *iov = b->iov[b->n];
+    iov[0].iov_base = b->hdr[b->n];
+    iov[0].iov_len = hdr_len;
+    iov[1].iov_base = (void *)payload;
+    iov[1].iov_len = len;
+
+    struct msghdr *m = &b->msgs[b->n].msg_hdr;
+    memset(m, 0, sizeof(*m));
+    b->addr[b->n] = *dst;
+    m->msg_name = &b->addr[b->n];
+    m->msg_namelen = sizeof(*dst);
+    m->msg_iov = iov;
+    m->msg_iovlen = len ? 2 : 1;
+    b->n++;
+}
+
+// 모은 데이터그램을 전송하고 비운다. 사용한 syscall 수를 *syscalls 에 더함
+static inline int txb_flush(int s, TxBatch *b, uint64_t *syscalls)
+{
+    int done = 0;
+    while (done < b->n)
+    {
+#if HAVE_MMSG
+        int k = sendmmsg(s, b->msgs + done, b->n - done, 0);
+        (*syscalls)++;
+        if (k <= 0)
+            break;
+        done += k;
+#else
+        sendmsg(s, &b->msgs[done].msg_hdr, 0);
+        (*syscalls)++;
+        done++;
+#endif
+    }
+    b->n = 0;
+    return done;
+}
+
+// ------------------------------ UDP GSO ------------------------------
+// 세그먼트를 미리 잡아 둔 슈퍼 데이터그램 GSO_MSGS 개에 차례로 붙이고 sendmmsg 한 번으로 보낸다.
+// 한 슈퍼 데이터그램은 크기가 같은 세그먼트들이고 마지막 하나만 더 짧을 수 있다 (커널 규칙).
+// 헤더는 바이너리 형식(SEG_HDR_LEN)만, 페이로드는 txb 처럼 복사 없이 iovec 으로 건다.
+#define GSO_MAX_BYTES 65507 // UDP/IPv4 최대 페이로드
+#define GSO_MAX_SEGS 64     // 슈퍼 데이터그램 하나의 최대 세그먼트 수 (커널 UDP_MAX_SEGMENTS)
+#define GSO_MSGS 16         // 한 번의 sendmmsg 로 보내는 슈퍼 데이터그램 수
+#define GRO_CTRL CMSG_SPACE(sizeof(int))
+
+typedef struct
+{
+    struct mmsghdr msgs[GSO_MSGS];
+    struct iovec iov[GSO_MSGS][2 * GSO_MAX_SEGS];
+    struct sockaddr_in addr[GSO_MSGS];
+    union
+    {
+        char buf[CMSG_SPACE(sizeof(uint16_t))];
+        struct cmsghdr align;
+    } ctrl[GSO_MSGS];
+    uint8_t hdr[GSO_MSGS][GSO_MAX_SEGS][SEG_HDR_LEN];
+    uint16_t seg_size[GSO_MSGS]; // 메시지의 세그먼트 크기 (첫 세그먼트 기준)
+    uint32_t bytes[GSO_MSGS];
+    int segs[GSO_MSGS];
+    int closed; // 마지막 메시지에 짧은 세그먼트가 들어가 더 붙일 수 없음
+    int n;      // 사용 중인 메시지 수
+    uint64_t sends, datagrams, segments; // 통계: sendmmsg 호출, 슈퍼 데이터그램, 세그먼트
+} GsoBatch;
+
+static inline GsoBatch *gsob_new(void)
+{
+    GsoBatch *b = calloc(1, sizeof(*b));
+    if (!b)
+        die("calloc gsobatch");
+    return b;
+}
+
+// 커널이 UDP GSO 를 지원하는지 (소켓에 기본 세그먼트 크기를 걸어 봄, 실제 크기는 메시지마다 cmsg 로 줌)
+static inline int udp_gso_probe(int s)
+{
+#if HAVE_GSO
+    int v = 0;
+    return setsockopt(s, SOL_UDP, UDP_SEGMENT, &v, sizeof(v)) == 0;
+#else
+    (void)s;
+    return 0;
+#endif
+}
+
+// 수신 소켓에 UDP_GRO 를 켬. 실패하면 0 (커널 5.0 미만)
+static inline int udp_gro_enable(int s)
+{
+#if HAVE_GSO
+    int one = 1;
+    return setsockopt(s, SOL_UDP, UDP_GRO, &one, sizeof(one)) == 0;
+#else
+    (void)s;
+    return 0;
+#endif
+}
+
+// 받은 메시지의 UDP_GRO cmsg 에서 세그먼트 크기 (합쳐지지 않았으면 0)
+static inline int gro_seg_size(struct msghdr *m)
+{
+#if HAVE_GSO
+    for (struct cmsghdr *c = CMSG_FIRSTHDR(m); c; c = CMSG_NXTHDR(m, c))
+        if (c->cmsg_level == SOL_UDP && c->cmsg_type == UDP_GRO)
+        {
+            int v;
+            memcpy(&v, CMSG_DATA(c), sizeof(v));
+            return v;
+        }
+#else
+    (void)m;
+#endif
+    return 0;
+}
+
+// 길이 seg_len(헤더 포함)인 세그먼트의 헤더 버퍼. 마지막 메시지에 붙일 수 없으면 새 메시지를 열고,
+// 메시지가 모두 찼으면 NULL (gsob_flush 뒤 다시 호출). 채운 뒤 gsob_commit 으로 확정
+static inline uint8_t *gsob_hdr(GsoBatch *b, const struct sockaddr_in *dst, size_t seg_len)
+{
+    if (b->n > 0)
+    {
+        int i = b->n - 1;
+        if (!b->closed && b->segs[i] < GSO_MAX_SEGS && seg_len <= b->seg_size[i] &&
+            b->bytes[i] + seg_len <= GSO_MAX_BYTES && b->addr[i].sin_addr.s_addr == dst->sin_addr.s_addr &&
+            b->addr[i].sin_port == dst->sin_port)
+            return b->hdr[i][b->segs[i]];
+        if (b->n == GSO_MSGS)
+            return NULL;
+    }
+    int i = b->n++;
+    struct msghdr *m = &b->msgs[i].msg_hdr;
+    memset(m, 0, sizeof(*m));
+    b->addr[i] = *dst;
+    m->msg_name = &b->addr[i];
+    m->msg_namelen = sizeof(*dst);
+    m->msg_iov = b->iov[i];
+    b->seg_size[i] = (uint16_t)seg_len;
+    b->bytes[i] = 0;
+    b->segs[i] = 0;
+    b->closed = 0;
+    return b->hdr[i][0];
+}
+
+static inline void gsob_commit(GsoBatch *b, int hdr_len, const void *payload, size_t len)
+{
+    int i = b->n - 1;
+    struct iovec *iov = &b->iov[i][b->msgs[i].msg_hdr.msg_iovlen];
+    iov[0].iov_base = b->hdr[i][b->segs[i]];
+    iov[0].iov_len = hdr_len;
+    b->msgs[i].msg_hdr.msg_iovlen++;
+    if (len)
+    {
+        iov[1].iov_base = (void *)payload;
+        iov[1].iov_len = len;
+        b->msgs[i].msg_hdr.msg_iovlen++;
+    }
+    b->segs[i]++;
+    b->bytes[i] += hdr_len + len;
+    if (hdr_len + len < b->seg_size[i])
+        b->closed = 1; // 짧은 세그먼트는 메시지의 마지막이어야 함
+}
+
+// 모은 슈퍼 데이터그램을 전송하고 비운다. 세그먼트가 둘 이상인 메시지에만 UDP_SEGMENT cmsg 를 붙임
+static inline int gsob_flush(int s, GsoBatch *b, uint64_t *syscalls)
+{
+    for (int i = 0; i < b->n; i++)
+    {
+        struct msghdr *m = &b->msgs[i].msg_hdr;
+        b->segments += b->segs[i];
+        if (b->segs[i] < 2)
+            continue;
+#if HAVE_GSO
+        m->msg_control = b->ctrl[i].buf;
+        m->msg_controllen = sizeof(b->ctrl[i].buf);
+        struct cmsghdr *c = CMSG_FIRSTHDR(m);
+        c->cmsg_level = SOL_UDP;
+        c->cmsg_type = UDP_SEGMENT;
+        c->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        memcpy(CMSG_DATA(c), &b->seg_size[i], sizeof(uint16_t));
+#endif
+    }
+    int done = 0;
+    while (done < b->n)
+    {
+#if HAVE_MMSG
+        int k = sendmmsg(s, b->msgs + done, b->n - done, 0);
+        (*syscalls)++;
+        if (k <= 0)
+            break;
+        done += k;
+#else
+        sendmsg(s, &b->msgs[done].msg_hdr, 0);
+        (*syscalls)++;
+        done++;
+#endif
+    }
+    b->sends++;
+    b->datagrams += b->n;
+    b->n = 0;
+    b->closed = 0;
+    return done;
+}
+
+// ------------------------------ 수신 배치 ------------------------------
+typedef struct
+{
+    struct mmsghdr msgs[IO_BATCH];
+    struct iovec iov[IO_BATCH];
+    struct sockaddr_in addr[IO_BATCH];
+    uint8_t *buf; // IO_BATCH * slot 바이트, 한 번만 할당
+    size_t slot;
+    int vlen;     // 한 번에 받을 최대 개수
+    int used;     // 직전 수신에서 채워진 개수 (다음 수신 전에 주소 길이만 복구)
+    uint8_t *ctrl; // UDP_GRO cmsg 버퍼 (rxb_set_gro 전에는 NULL)
+} RxBatch;
+
+static inline RxBatch *rxb_new(size_t slot, int vlen)
+{
+    RxBatch *b = calloc(1, sizeof(*b));
+    if (!b)
+        die("calloc rxbatch");
+    b->slot = slot;
+    b->vlen = vlen < IO_BATCH ? vlen : IO_BATCH;
+    b->buf = malloc(slot * b->vlen);
+    if (!b->buf)
+        die("malloc rxbatch");
+    for (int i = 0; i < b->vlen; i++)
+    {
+        b->iov[i].iov_base = b->buf + i * slot;
+        b->iov[i].iov_len = slot;
+
+        struct msghdr *m = &b->msgs[i].msg_hdr;
+        m->msg_name = &b->addr[i];
+        m->msg_namelen = sizeof(b->addr[i]);
+        m->msg_iov = &b->iov[i];
+        m->msg_iovlen = 1;
+    }
+    return b;
+}
+
+static inline void rxb_free(RxBatch *b)
+{
+    free(b->ctrl);
+    free(b->buf);
+    free(b);
+}
+
+static inline uint8_t *rxb_data(RxBatch *b, int i)
+{
+    return b->iov[i].iov_base;
+}
+
+static inline int rxb_len(const RxBatch *b, int i)
+{
+    return b->msgs[i].msg_len;
+}
+
+// UDP_GRO 로 합쳐진 데이터그램의 세그먼트 크기를 받도록 메시지마다 cmsg 버퍼를 붙임
+static inline void rxb_set_gro(RxBatch *b)
+{
+    b->ctrl = calloc(b->vlen, GRO_CTRL);
+    if (!b->ctrl)
+        die("calloc rxbatch ctrl");
+    for (int i = 0; i < b->vlen; i++)
+    {
+        b->msgs[i].msg_hdr.msg_control = b->ctrl + (size_t)i * GRO_CTRL;
+        b->msgs[i].msg_hdr.msg_controllen = GRO_CTRL;
+    }
+}
+
+// i 번째로 받은 데이터그램의 GRO 세그먼트 크기 (합쳐지지 않았거나 GRO 가 꺼져 있으면 0)
+static inline int rxb_seg(RxBatch *b, int i)
+{
+    return b->ctrl ? gro_seg_size(&b->msgs[i].msg_hdr) : 0;
+}
+
+// 첫 데이터그램이 올 때까지 블록(SO_RCVTIMEO 적용)한 뒤, 이미 도착해 있는 것들을
+// 추가 대기 없이 함께 받아온다. 받은 개수 반환, 실패 시 -1 (errno 유지)
+static inline int rxb_recv(int s, RxBatch *b, uint64_t *syscalls)
+{
+    for (int i = 0; i < b->used; i++)
+    {
+        b->msgs[i].msg_hdr.msg_namelen = sizeof(b->addr[i]);
+        if (b->ctrl)
+            b->msgs[i].msg_hdr.msg_controllen = GRO_CTRL;
+    }
+
+    (*syscalls)++;
+#if HAVE_MMSG
+    int n = recvmmsg(s, b->msgs, b->vlen, MSG_WAITFORONE, NULL);
+#else
+    int n = recvmsg(s, &b->msgs[0].msg_hdr, 0);
+    if (n >= 0)
+    {
+        b->msgs[0].msg_len = n;
+        n = 1;
+    }
+#endif
+    b->used = n > 0 ? n : 0;
+    return n;
+}
+
+#endif
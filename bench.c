@@ -0,0 +1,381 @@
+// bench.c - loopback 벤치마크
+// 실행 방법:
+//   ./bench [-n bytes] [-m modes] [-w wnds] [-l losses] [-c cc] [-r repeat] [-p port]
+//           [-o out.jsonl] [-L label] [-S sender] [-R receiver]
+//   modes : round,event,batch,event+batch,shm,shm+poll 중 쉼표로 구분 (기본 round,event,batch,event+batch)
+//           shm 은 UDP 대신 공유 메모리 링(-M, +poll 은 -y busy-poll)으로 round 송신. 손실률 0 에서만 실행
+//           round/event/batch/event+batch 뒤에 +uring 을 붙이면 receiver 가 io_uring(-u, batch 는 송신측만),
+//           +sqpoll 이면 io_uring + SQPOLL(-U) 로 받음 (예: event+uring, event+batch+sqpoll).
+//           그 뒤에 +gso 를 붙이면 양쪽 -g 로 UDP GSO/GRO (예: event+batch+gso),
+//           그 뒤에 +pace 를 붙이면 sender -P timer 로 페이싱 (예: event+pace, event+gso+pace)
+//   wnds  : 최대 윈도우, MSS 개수 (0 이면 cwnd 만 적용, 기본 0,16,64,256)
+//   losses: receiver 의 Bernoulli 손실률 (-I loss=P,seed=1, 기본 0,0.001,0.01)
+// 조합마다 receiver 와 sender 를 loopback 으로 띄워 bulk 전송을 하고 sender -j 의 결과와 receiver -j 의
+// 수신 packets/s, 패킷당 CPU 를 표로 출력한다.
+// -o 를 주면 조합 정보와 -L 라벨(예: git 커밋)을 붙여 JSON Lines 로도 저장해 버전 간 비교에 쓴다.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "common.h"
+
+#define BENCH_MAX_ITEMS 16
+#define BENCH_START_US 100000     // receiver 가 bind 할 때까지 기다리는 시간
+#define BENCH_RUN_LIMIT_US 120000000 // 한 조합의 최대 실행 시간
+#define BENCH_RCV_LIMIT_US 3000000   // sender 종료 뒤 receiver 가 끝나기를 기다리는 시간
+
+// 쉼표로 구분된 목록을 잘라 items 에 넣고 개수 반환 (s 는 수정됨)
+static int split(char *s, char *items[])
+{
+    int n = 0;
+    for (char *save = NULL, *t = strtok_r(s, ",", &save); t && n < BENCH_MAX_ITEMS; t = strtok_r(NULL, ",", &save))
+        items[n++] = t;
+    return n;
+}
+
+// argv 를 실행하고 표준 출력을 out_fd 로 돌린다
+static pid_t spawn(char *const argv[], int out_fd)
+{
+    pid_t pid = fork();
+    if (pid < 0)
+        die("fork");
+    if (pid == 0)
+    {
+        dup2(out_fd, STDOUT_FILENO);
+        execv(argv[0], argv);
+        fprintf(stderr, "exec %s: %s\n", argv[0], strerror(errno));
+        _exit(127);
+    }
+    return pid;
+}
+
+// limit_us 안에 끝나기를 기다리고, 넘으면 죽인다. 정상 종료(exit 0)면 0
+static int wait_or_kill(pid_t pid, uint64_t limit_us)
+{
+    uint64_t t0 = now_us();
+    int st;
+    while (1)
+    {
+        pid_t r = waitpid(pid, &st, WNOHANG);
+        if (r == pid)
+            return WIFEXITED(st) && WEXITSTATUS(st) == 0 ? 0 : -1;
+        if (r < 0)
+            return -1;
+        if (now_us() - t0 > limit_us)
+        {
+            kill(pid, SIGKILL);
+            waitpid(pid, &st, 0);
+            return -1;
+        }
+        usleep(10000);
+    }
+}
+
+// {"key":값 형식에서 숫자 하나
+static double json_num(const char *js, const char *key)
+{
+    char pat[64];
+    snprintf(pat, sizeof(pat), "\"%s\":", key);
+    const char *p = strstr(js, pat);
+    return p ? atof(p + strlen(pat)) : 0;
+}
+
+typedef struct
+{
+    const char *sender, *receiver;
+    int port;
+    long long bytes;
+    const char *cc;
+    FILE *jsonl;
+    const char *label;
+} Bench;
+
+// 조합 하나 실행. 성공하면 sender 의 JSON 결과를 js 에, receiver 의 것을 rjs 에 (없으면 빈 문자열) 채우고 0
+static int run_one(const Bench *bn, const char *mode, int wnd, const char *loss, char *js, char *rjs, size_t cap)
+{
+    int event = strstr(mode, "event") != NULL;
+    int batch = strstr(mode, "batch") != NULL;
+    int shm = strncmp(mode, "shm", 3) == 0;
+    int poll = shm && strstr(mode, "poll") != NULL;
+    int pace = strstr(mode, "pace") != NULL;
+    int gso = strstr(mode, "gso") != NULL;
+    int sqpoll = strstr(mode, "sqpoll") != NULL;
+    int uring = sqpoll || strstr(mode, "uring") != NULL;
+    char port[16], bytes[32], wnds[16], imp[64], shm_name[32];
+    snprintf(port, sizeof(port), "%d", bn->port);
+    snprintf(bytes, sizeof(bytes), "%lld", bn->bytes);
+    snprintf(wnds, sizeof(wnds), "%d", wnd);
+    snprintf(imp, sizeof(imp), "loss=%s,seed=1", loss);
+    snprintf(shm_name, sizeof(shm_name), "/bench-%d", (int)getpid());
+
+    // receiver
+    char *rargv[14];
+    int k = 0;
+    rargv[k++] = (char *)bn->receiver;
+    rargv[k++] = "-j";
+    if (uring)
+        rargv[k++] = sqpoll ? "-U" : "-u";
+    else if (batch)
+        rargv[k++] = "-b";
+    if (gso)
+        rargv[k++] = "-g";
+    if (shm)
+    {
+        rargv[k++] = "-M";
+        rargv[k++] = shm_name;
+    }
+    if (poll)
+        rargv[k++] = "-y";
+    if (atof(loss) > 0)
+    {
+        rargv[k++] = "-I";
+        rargv[k++] = imp;
+    }
+    if (!shm)
+        rargv[k++] = port;
+    rargv[k++] = "bulk";
+    rargv[k] = NULL;
+
+    // receiver 출력은 끝난 뒤 JSON 줄만 읽으므로 파이프 대신 임시 파일로 (버퍼가 차서 멈추지 않게)
+    FILE *rout = tmpfile();
+    if (!rout)
+        die("tmpfile");
+    pid_t rpid = spawn(rargv, fileno(rout));
+    usleep(BENCH_START_US);
+
+    // sender: 표준 출력을 파이프로 받아 JSON 줄을 찾음
+    char *sargv[20];
+    k = 0;
+    sargv[k++] = (char *)bn->sender;
+    sargv[k++] = "-j";
+    if (event)
+        sargv[k++] = "-e";
+    if (batch)
+        sargv[k++] = "-b";
+    if (gso)
+        sargv[k++] = "-g";
+    if (shm)
+    {
+        sargv[k++] = "-M";
+        sargv[k++] = shm_name;
+    }
+    if (poll)
+        sargv[k++] = "-y";
+    if (pace)
+    {
+        sargv[k++] = "-P";
+        sargv[k++] = "timer";
+    }
+    sargv[k++] = "-c";
+    sargv[k++] = (char *)bn->cc;
+    sargv[k++] = "-w";
+    sargv[k++] = wnds;
+    sargv[k++] = "-n";
+    sargv[k++] = bytes;
+    if (!shm)
+    {
+        sargv[k++] = "127.0.0.1";
+        sargv[k++] = port;
+    }
+    sargv[k++] = "bulk";
+    sargv[k] = NULL;
+
+    int pfd[2];
+    if (pipe(pfd) < 0)
+        die("pipe");
+    pid_t spid = spawn(sargv, pfd[1]);
+    close(pfd[1]);
+
+    char out[16384];
+    size_t len = 0;
+    ssize_t r;
+    while ((r = read(pfd[0], out + len, sizeof(out) - 1 - len)) > 0)
+    {
+        len += r;
+        if (len == sizeof(out) - 1) // JSON 은 마지막 줄이므로 앞부분을 버림
+        {
+            memmove(out, out + len / 2, len - len / 2);
+            len -= len / 2;
+        }
+    }
+    out[len] = '\0';
+    close(pfd[0]);
+
+    int sok = wait_or_kill(spid, BENCH_RUN_LIMIT_US);
+    int rok = wait_or_kill(rpid, BENCH_RCV_LIMIT_US);
+
+    rjs[0] = '\0';
+    char line[1024];
+    rewind(rout);
+    while (fgets(line, sizeof(line), rout))
+        if (line[0] == '{')
+        {
+            snprintf(rjs, cap, "%s", line);
+            rjs[strcspn(rjs, "\n")] = '\0';
+        }
+    fclose(rout);
+
+    const char *j = strrchr(out, '{');
+    if (sok < 0 || !j)
+        return -1;
+    snprintf(js, cap, "%s", j);
+    js[strcspn(js, "\n")] = '\0';
+    if (rok < 0)
+        fprintf(stderr, "  (receiver 가 정상 종료하지 않음: %s wnd=%d loss=%s)\n", mode, wnd, loss);
+    return 0;
+}
+
+// m 이 len 바이트 안에서 suffix 로 끝나면 그만큼 줄이고 1
+static int strip_suffix(const char *m, size_t *len, const char *suffix)
+{
+    size_t n = strlen(suffix);
+    if (*len > n && strncmp(m + *len - n, suffix, n) == 0)
+    {
+        *len -= n;
+        return 1;
+    }
+    return 0;
+}
+
+// 알려진 모드인지 (+uring|+sqpoll, +gso, +pace 는 이 순서로 shm 이 아닌 모드 뒤에만)
+static int mode_ok(const char *m)
+{
+    static const char *base[] = {"round", "event", "batch", "event+batch", "shm", "shm+poll"};
+    size_t len = strlen(m);
+    int ext = strip_suffix(m, &len, "+pace");
+    ext |= strip_suffix(m, &len, "+gso");
+    ext |= strip_suffix(m, &len, "+uring") || strip_suffix(m, &len, "+sqpoll");
+    for (size_t i = 0; i < sizeof(base) / sizeof(base[0]); i++)
+        if (strlen(base[i]) == len && strncmp(m, base[i], len) == 0)
+            return !(ext && strncmp(m, "shm", 3) == 0);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    Bench bn;
+    memset(&bn, 0, sizeof(bn));
+    bn.sender = "./sender";
+    bn.receiver = "./receiver";
+    bn.port = 9700;
+    bn.bytes = 20000000;
+    bn.cc = "reno";
+    bn.label = "";
+
+    char modes_s[256] = "round,event,batch,event+batch";
+    char wnds_s[256] = "0,16,64,256";
+    char losses_s[256] = "0,0.001,0.01";
+    const char *jsonl_path = NULL;
+    int repeat = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:m:w:l:c:r:p:o:L:S:R:")) != -1)
+    {
+        if (opt == 'n')
+            bn.bytes = strtoll(optarg, NULL, 10);
+        else if (opt == 'm')
+            snprintf(modes_s, sizeof(modes_s), "%s", optarg);
+        else if (opt == 'w')
+            snprintf(wnds_s, sizeof(wnds_s), "%s", optarg);
+        else if (opt == 'l')
+            snprintf(losses_s, sizeof(losses_s), "%s", optarg);
+        else if (opt == 'c')
+            bn.cc = optarg;
+        else if (opt == 'r')
+            repeat = atoi(optarg) > 0 ? atoi(optarg) : 1;
+        else if (opt == 'p')
+            bn.port = atoi(optarg);
+        else if (opt == 'o')
+            jsonl_path = optarg;
+        else if (opt == 'L')
+            bn.label = optarg;
+        else if (opt == 'S')
+            bn.sender = optarg;
+        else if (opt == 'R')
+            bn.receiver = optarg;
+        else
+        {
+            fprintf(stderr, "usage: %s [-n bytes] [-m modes] [-w wnds] [-l losses] [-c cc] [-r repeat] [-p port] "
+                            "[-o out.jsonl] [-L label] [-S sender] [-R receiver]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    char *modes[BENCH_MAX_ITEMS], *wnds[BENCH_MAX_ITEMS], *losses[BENCH_MAX_ITEMS];
+    int nm = split(modes_s, modes), nw = split(wnds_s, wnds), nl = split(losses_s, losses);
+    for (int i = 0; i < nm; i++)
+    {
+        if (!mode_ok(modes[i]))
+        {
+            fprintf(stderr, "unknown mode: %s (round|event|batch|event+batch[+uring|+sqpoll][+gso][+pace]|shm|shm+poll)\n", modes[i]);
+            return 1;
+        }
+    }
+    if (access(bn.sender, X_OK) < 0 || access(bn.receiver, X_OK) < 0)
+    {
+        fprintf(stderr, "%s / %s 를 먼저 빌드하세요 (-S, -R 로 경로 지정 가능)\n", bn.sender, bn.receiver);
+        return 1;
+    }
+    if (jsonl_path)
+    {
+        bn.jsonl = fopen(jsonl_path, "a");
+        if (!bn.jsonl)
+            die("fopen jsonl");
+    }
+
+    printf(BOLDMAG "=== [BENCH] %lld bytes x %d 조합 (%s) ===\n" RESET, bn.bytes, nm * nw * nl * repeat, bn.cc);
+    printf("%-24s %5s %7s | %9s %8s %8s %8s %8s %7s %9s | %8s %9s %8s\n",
+           "mode", "wnd", "loss", "Mbit/s", "p50 us", "p99 us", "p99.9 us", "qdly us", "retx%", "sys/MB",
+           "rcv kpps", "rcv ns/pk", "rcv sys/pk");
+
+    int failed = 0;
+    for (int a = 0; a < nm; a++)
+        for (int b = 0; b < nw; b++)
+            for (int c = 0; c < nl; c++)
+                for (int r = 0; r < repeat; r++)
+                {
+                    char js[2048], rjs[2048];
+                    int wnd = atoi(wnds[b]);
+                    if (strncmp(modes[a], "shm", 3) == 0 && atof(losses[c]) > 0)
+                    {
+                        // 손상 엔진은 UDP 수신 경로에만 있음
+                        printf(YELLOW "%-24s %5d %7s | 건너뜀 (shm 은 손실 없이만)\n" RESET, modes[a], wnd, losses[c]);
+                        continue;
+                    }
+                    if (run_one(&bn, modes[a], wnd, losses[c], js, rjs, sizeof(js)) < 0)
+                    {
+                        printf(RED "%-24s %5d %7s | 실패\n" RESET, modes[a], wnd, losses[c]);
+                        failed++;
+                        continue;
+                    }
+                    printf("%-24s %5d %7s | %9.1f %8.0f %8.0f %8.0f %8.0f %7.3f %9.1f | %8.1f %9.0f %8.3f\n",
+                           modes[a], wnd, losses[c], json_num(js, "goodput_mbps"),
+                           json_num(js, "rtt_p50_us"), json_num(js, "rtt_p99_us"),
+                           json_num(js, "rtt_p999_us"), json_num(js, "qdelay_us"),
+                           json_num(js, "retx_ratio") * 100,
+                           json_num(js, "syscalls_per_mb"), json_num(rjs, "rx_pps") / 1e3,
+                           json_num(rjs, "cpu_ns_per_pkt"), json_num(rjs, "syscalls_per_pkt"));
+                    fflush(stdout);
+                    if (bn.jsonl)
+                    {
+                        // 조합 정보 + sender 결과 (sender 의 여는 괄호를 이어 붙임) + receiver 결과
+                        fprintf(bn.jsonl, "{\"label\":\"%s\",\"mode\":\"%s\",\"wnd_mss\":%d,\"loss\":%s,\"run\":%d,%.*s,\"rcv\":%s}\n",
+                                bn.label, modes[a], wnd, losses[c], r, (int)strlen(js + 1) - 1, js + 1,
+                                rjs[0] ? rjs : "null");
+                        fflush(bn.jsonl);
+                    }
+                }
+
+    if (bn.jsonl)
+        fclose(bn.jsonl);
+    if (failed)
+        printf(RED "%d 조합 실패\n" RESET, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,452 @@
+// cc.h - 교체 가능한 혼잡제어 알고리즘 인터페이스
+// 송신측은 ACK/중복 ACK/타임아웃/RTT 표본이 생길 때 훅만 호출하고, cwnd/ssthresh 를
+// 어떻게 바꿀지는 알고리즘이 정한다. 실행 중에 이름으로 골라 같은 경로에서 비교할 수 있다.
+// 증가량은 ACK 개수가 아니라 확인된 바이트로 센다 (ABC, RFC 3465): 수신측이 ACK 를 지연/솎아
+// 내어 ACK 하나가 여러 세그먼트를 확인해도 증가 속도가 같다. 느린시작은 ACK 하나에 abc_l MSS 까지.
+//   reno    : 느린시작 + 선형 증가, 3 중복 ACK 에 절반, 타임아웃에 1 MSS (기존 동작)
+//   newreno : Reno + 빠른 회복 중 윈도우 팽창/수축 (RFC 6582)
+//   cubic   : 마지막 손실 시점 기준 3차 함수로 증가, 손실 시 0.7 배 (RFC 8312)
+//   bbr     : 병목 대역폭(최대 전달률)과 최소 RTT 로 BDP 를 추정해 cwnd 를 맞춤 (간이판)
+#ifndef CC_H
+#define CC_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "common.h"
+
+#define CC_ABC_L 2 // 느린시작에서 ACK 하나로 늘릴 수 있는 최대 MSS 수 (RFC 3465 의 L)
+
+// on_ack 반환값: 어떤 방식으로 cwnd 를 늘렸는지 (출력용)
+#define CC_GROW_NONE 0 // 변화 없음 (손실 복구 중 등)
+#define CC_GROW_SS 1   // 느린시작
+#define CC_GROW_CA 2   // 혼잡회피
+
+typedef struct Cc Cc;
+
+typedef struct
+{
+    const char *name;
+    // 새 데이터 acked 바이트가 확인됨. in_recovery: 손실 복구 구간 안의 partial ACK
+    int (*on_ack)(Cc *cc, uint32_t acked, int in_recovery, uint64_t now);
+    // 중복 ACK. dups 는 이번 손실 구간의 연속 중복 ACK 수 (3 이면 손실 감지, 구간당 한 번)
+    void (*on_dupack)(Cc *cc, int dups, uint64_t now);
+    // 재전송 타이머 만료
+    void (*on_timeout)(Cc *cc, uint64_t now);
+    // RTT 표본 (us)
+    void (*on_rtt_sample)(Cc *cc, uint64_t rtt_us, uint64_t now);
+} CcOps;
+
+#define BBR_BW_WIN 10 // 병목 대역폭 최대값 필터 길이 (라운드 수)
+
+struct Cc
+{
+    const CcOps *ops;
+    double cwnd;     // 바이트
+    double ssthresh; // 바이트
+    uint64_t min_rtt;    // 관측한 최소 RTT (us), 0 이면 표본 없음
+    uint64_t min_rtt_at; // min_rtt 를 갱신한 시각
+    int abc_l;           // ABC 느린시작 한도 (MSS 수), 0 이면 ACK 하나를 1 MSS 로 셈 (ACK 개수 기준)
+
+    // NewReno: 빠른 회복 중 (cwnd 가 팽창된 상태)
+    int in_fr;
+
+    // CUBIC (단위: MSS, 초)
+    uint64_t epoch; // 이번 증가 구간 시작 시각, 0 이면 다음 ACK 에서 시작
+    double w_max;   // 직전 손실 시점의 윈도우
+    double k;       // w_max 로 돌아오기까지 걸리는 시간
+    double origin;  // 3차 함수의 고원 높이
+    double w_est;   // Reno 였다면 가졌을 윈도우 (TCP-friendly 구간)
+
+    // BBR
+    int state;               // BBR_STARTUP / BBR_DRAIN / BBR_PROBE_BW
+    double bw[BBR_BW_WIN];   // 라운드별 전달률 (바이트/us)
+    int bw_idx;
+    double max_bw;
+    double full_bw;          // STARTUP 종료 판정용
+    int full_cnt;
+    uint64_t delivered;      // 누적 확인 바이트
+    uint64_t rnd_start;      // 현재 라운드 시작 시각
+    uint64_t rnd_delivered;  // 라운드 시작 시점의 delivered
+    int cycle;               // PROBE_BW 이득 순환 위치
+    double pacing_rate;      // 바이트/us (이득 * 대역폭 추정치, 페이싱용)
+};
+
+static inline void cc_init(Cc *cc, const CcOps *ops, double cwnd, double ssthresh)
+{
+    memset(cc, 0, sizeof(*cc));
+    cc->ops = ops;
+    cc->cwnd = cwnd;
+    cc->ssthresh = ssthresh;
+    cc->abc_l = CC_ABC_L;
+}
+
+// 느린시작 증가량 (바이트): 확인된 바이트, ACK 하나에 abc_l MSS 까지
+static inline double cc_ss_credit(const Cc *cc, uint32_t acked)
+{
+    if (!cc->abc_l)
+        return MSS;
+    double cap = (double)cc->abc_l * MSS;
+    return acked < cap ? acked : cap;
+}
+
+// 혼잡회피 증가량 계산에 쓸 확인 바이트 (한도 없음: RTT 당 약 1 MSS 가 되도록 바이트로 셈)
+static inline uint32_t cc_ca_credit(const Cc *cc, uint32_t acked)
+{
+    return cc->abc_l ? acked : MSS;
+}
+
+static inline int cc_on_ack(Cc *cc, uint32_t acked, int in_recovery, uint64_t now)
+{
+    return cc->ops->on_ack(cc, acked, in_recovery, now);
+}
+
+static inline void cc_on_dupack(Cc *cc, int dups, uint64_t now)
+{
+    cc->ops->on_dupack(cc, dups, now);
+}
+
+static inline void cc_on_timeout(Cc *cc, uint64_t now)
+{
+    cc->ops->on_timeout(cc, now);
+}
+
+// min_rtt 는 모든 알고리즘이 공유한다. 10초 지난 값은 새 표본으로 교체
+static inline void cc_on_rtt_sample(Cc *cc, uint64_t rtt_us, uint64_t now)
+{
+    if (rtt_us == 0)
+        rtt_us = 1;
+    if (!cc->min_rtt || rtt_us <= cc->min_rtt || now - cc->min_rtt_at > 10000000)
+    {
+        cc->min_rtt = rtt_us;
+        cc->min_rtt_at = now;
+    }
+    if (cc->ops->on_rtt_sample)
+        cc->ops->on_rtt_sample(cc, rtt_us, now);
+}
+
+// ------------------------------ Reno ------------------------------
+// 혼잡회피: 확인된 MSS 하나당 MSS*MSS/cwnd 만큼 선형 증가
+static inline void reno_ca_increase(Cc *cc, uint32_t acked)
+{
+    cc->cwnd += MSS * ((double)cc_ca_credit(cc, acked) / cc->cwnd);
+}
+
+// 새 ACK 수신 시 cwnd 증가 (확인 바이트 기준, 세그먼트 하나면 기존과 같은 1 MSS / MSS*MSS/cwnd)
+static inline int reno_on_ack(Cc *cc, uint32_t acked, int in_recovery, uint64_t now)
+{
+    (void)now;
+    if (in_recovery)
+        return CC_GROW_NONE;
+    // 윈도우 크기가 임계치보다 작다면 느린시작 -> 지수적 증가
+    if (cc->cwnd < cc->ssthresh)
+    {
+        cc->cwnd += cc_ss_credit(cc, acked);
+        return CC_GROW_SS;
+    }
+    // 아니면 혼잡회피 -> 선형적 증가
+    reno_ca_increase(cc, acked);
+    return CC_GROW_CA;
+}
+
+// 3 중복 ACK: cwnd 절반, ssthresh = cwnd
+static inline void reno_on_dupack(Cc *cc, int dups, uint64_t now)
+{
+    (void)now;
+    if (dups != 3)
+        return;
+    cc->cwnd /= 2.0;
+    if (cc->cwnd < MSS)
+        cc->cwnd = MSS;
+    cc->ssthresh = cc->cwnd; // 임계치 조정
+}
+
+// 타임아웃: ssthresh = cwnd/2, cwnd = 1 MSS
+static inline void reno_on_timeout(Cc *cc, uint64_t now)
+{
+    (void)now;
+    cc->ssthresh = cc->cwnd / 2.0; // 임계치 조정
+    if (cc->ssthresh < MSS)
+        cc->ssthresh = MSS;
+    cc->cwnd = MSS; // 1 MSS로 조정
+}
+
+static const CcOps cc_reno = {"reno", reno_on_ack, reno_on_dupack, reno_on_timeout, NULL};
+
+// ------------------------------ NewReno ------------------------------
+// 손실 감지 시 ssthresh = cwnd/2, cwnd = ssthresh + 3 MSS 로 시작해 중복 ACK 마다 1 MSS 팽창,
+// partial ACK 에는 확인된 만큼 수축 후 1 MSS, 복구가 끝나면 cwnd = ssthresh
+static inline int newreno_on_ack(Cc *cc, uint32_t acked, int in_recovery, uint64_t now)
+{
+    if (in_recovery)
+    {
+        if (cc->in_fr)
+        {
+            cc->cwnd -= acked;
+            if (acked >= MSS)
+                cc->cwnd += MSS;
+            if (cc->cwnd < MSS)
+                cc->cwnd = MSS;
+        }
+        return CC_GROW_NONE;
+    }
+    if (cc->in_fr)
+    {
+        cc->in_fr = 0;
+        cc->cwnd = cc->ssthresh;
+        return CC_GROW_NONE;
+    }
+    return reno_on_ack(cc, acked, 0, now);
+}
+
+static inline void newreno_on_dupack(Cc *cc, int dups, uint64_t now)
+{
+    (void)now;
+    if (dups == 3)
+    {
+        cc->ssthresh = cc->cwnd / 2.0;
+        if (cc->ssthresh < 2 * MSS)
+            cc->ssthresh = 2 * MSS;
+        cc->cwnd = cc->ssthresh + 3 * MSS;
+        cc->in_fr = 1;
+    }
+    else if (dups > 3 && cc->in_fr)
+        cc->cwnd += MSS;
+}
+
+static inline void newreno_on_timeout(Cc *cc, uint64_t now)
+{
+    cc->in_fr = 0;
+    reno_on_timeout(cc, now);
+}
+
+static const CcOps cc_newreno = {"newreno", newreno_on_ack, newreno_on_dupack, newreno_on_timeout, NULL};
+
+// ------------------------------ CUBIC ------------------------------
+#define CUBIC_C 0.4
+#define CUBIC_BETA 0.7
+
+// libm 없이 빌드하기 위한 세제곱근 (뉴턴 반복)
+static inline double cc_cbrt(double x)
+{
+    if (x <= 0)
+        return 0;
+    double y = x > 1 ? x / 3 : 1;
+    for (int i = 0; i < 40; i++)
+    {
+        double ny = y - (y * y * y - x) / (3 * y * y);
+        if (ny == y)
+            break;
+        y = ny;
+    }
+    return y;
+}
+
+static inline int cubic_on_ack(Cc *cc, uint32_t acked, int in_recovery, uint64_t now)
+{
+    if (in_recovery)
+        return CC_GROW_NONE;
+    if (cc->cwnd < cc->ssthresh)
+    {
+        cc->cwnd += cc_ss_credit(cc, acked);
+        return CC_GROW_SS;
+    }
+    double segs = (double)cc_ca_credit(cc, acked) / MSS; // 이 ACK 가 확인한 세그먼트 몫
+
+    double w = cc->cwnd / MSS;
+    if (!cc->epoch)
+    {
+        cc->epoch = now ? now : 1;
+        if (w < cc->w_max)
+        {
+            cc->k = cc_cbrt((cc->w_max - w) / CUBIC_C);
+            cc->origin = cc->w_max;
+        }
+        else
+        {
+            cc->k = 0;
+            cc->origin = w;
+        }
+        cc->w_est = w;
+    }
+
+    // 다음 RTT 뒤의 목표 윈도우: W(t) = C (t - K)^3 + W_max
+    double t = (now + cc->min_rtt - cc->epoch) / 1e6 - cc->k;
+    double target = cc->origin + CUBIC_C * t * t * t;
+
+    // TCP-friendly 구간: Reno 보다 느리게 늘지 않도록
+    cc->w_est += segs * 3 * (1 - CUBIC_BETA) / (1 + CUBIC_BETA) / w;
+    if (cc->w_est > target)
+        target = cc->w_est;
+
+    if (target > w)
+    {
+        double step = segs * (target - w) / w;
+        w = w + step < target ? w + step : target;
+    }
+    else
+        w += segs * 0.01 / w;
+    cc->cwnd = w * MSS;
+    return CC_GROW_CA;
+}
+
+// 손실 시점 윈도우를 기억하고 (fast convergence: 직전보다 작으면 더 낮춤) 0.7 배로 감소
+static inline void cubic_on_loss(Cc *cc)
+{
+    double w = cc->cwnd / MSS;
+    cc->epoch = 0;
+    cc->w_max = w < cc->w_max ? w * (1 + CUBIC_BETA) / 2 : w;
+    cc->ssthresh = cc->cwnd * CUBIC_BETA;
+    if (cc->ssthresh < 2 * MSS)
+        cc->ssthresh = 2 * MSS;
+}
+
+static inline void cubic_on_dupack(Cc *cc, int dups, uint64_t now)
+{
+    (void)now;
+    if (dups != 3)
+        return;
+    cubic_on_loss(cc);
+    cc->cwnd = cc->ssthresh;
+}
+
+static inline void cubic_on_timeout(Cc *cc, uint64_t now)
+{
+    (void)now;
+    cubic_on_loss(cc);
+    cc->cwnd = MSS;
+}
+
+static const CcOps cc_cubic = {"cubic", cubic_on_ack, cubic_on_dupack, cubic_on_timeout, NULL};
+
+// ------------------------------ BBR (간이판) ------------------------------
+// 라운드(최소 RTT 한 번)마다 전달률을 재서 최근 BBR_BW_WIN 라운드의 최대값을 병목 대역폭으로,
+// 최소 RTT 를 전파 지연으로 보고 cwnd 를 이득 * BDP 로 맞춘다. 손실(중복 ACK)에는 반응하지 않는다.
+//   STARTUP  : 이득 2.885, 대역폭이 3 라운드 연속 25% 이상 늘지 않으면 파이프가 찼다고 판단
+//   DRAIN    : 이득 1/2.885 로 한 라운드 동안 STARTUP 에서 쌓인 큐를 비움
+//   PROBE_BW : 이득 1.25, 0.75, 1 x 6 을 라운드마다 순환
+// cwnd 는 페이싱 여부(sender -P, pacer.h)와 상관없이 따로 둔 이득(STARTUP/DRAIN 2.885, PROBE_BW 2) * BDP 로
+// 잡는다. 전달률 표본은 min_rtt 길이의 라운드로 재므로 실제 RTT 가 더 길면 대역폭을 낮게 보는데,
+// cwnd 가 1 BDP 뿐이면 그만큼 덜 보내 다음 표본이 더 낮아지며 BBR_MIN_CWND 까지 줄어든다.
+// PROBE_RTT 는 생략했다 (min_rtt 는 10초가 지나면 새 표본으로 교체).
+#define BBR_STARTUP 0
+#define BBR_DRAIN 1
+#define BBR_PROBE_BW 2
+#define BBR_HIGH_GAIN 2.885
+#define BBR_CWND_GAIN 2 // PROBE_BW 의 cwnd 이득
+#define BBR_MIN_CWND (4 * MSS)
+
+static const double bbr_cycle_gain[8] = {1.25, 0.75, 1, 1, 1, 1, 1, 1};
+
+static inline double bbr_gain(const Cc *cc)
+{
+    if (cc->state == BBR_STARTUP)
+        return BBR_HIGH_GAIN;
+    if (cc->state == BBR_DRAIN)
+        return 1 / BBR_HIGH_GAIN;
+    return bbr_cycle_gain[cc->cycle];
+}
+
+// cwnd 목표 = 이 이득 * BDP
+static inline double bbr_cwnd_gain(const Cc *cc)
+{
+    return cc->state == BBR_PROBE_BW ? BBR_CWND_GAIN : BBR_HIGH_GAIN;
+}
+
+// 라운드 하나가 끝남: 전달률 표본을 필터에 넣고 상태 전이
+static inline void bbr_round_end(Cc *cc, uint64_t now)
+{
+    double rate = (double)(cc->delivered - cc->rnd_delivered) / (double)(now - cc->rnd_start);
+    cc->bw[cc->bw_idx] = rate;
+    cc->bw_idx = (cc->bw_idx + 1) % BBR_BW_WIN;
+    cc->max_bw = 0;
+    for (int i = 0; i < BBR_BW_WIN; i++)
+        if (cc->bw[i] > cc->max_bw)
+            cc->max_bw = cc->bw[i];
+
+    if (cc->state == BBR_STARTUP)
+    {
+        if (cc->max_bw >= cc->full_bw * 1.25)
+        {
+            cc->full_bw = cc->max_bw;
+            cc->full_cnt = 0;
+        }
+        else if (++cc->full_cnt >= 3)
+            cc->state = BBR_DRAIN;
+    }
+    else if (cc->state == BBR_DRAIN)
+        cc->state = BBR_PROBE_BW;
+    else
+        cc->cycle = (cc->cycle + 1) % 8;
+
+    cc->rnd_start = now;
+    cc->rnd_delivered = cc->delivered;
+}
+
+static inline int bbr_on_ack(Cc *cc, uint32_t acked, int in_recovery, uint64_t now)
+{
+    (void)in_recovery;
+    cc->delivered += acked;
+    if (!cc->rnd_start)
+    {
+        cc->rnd_start = now;
+        cc->rnd_delivered = cc->delivered - acked;
+    }
+    else if (cc->min_rtt && now - cc->rnd_start >= cc->min_rtt)
+        bbr_round_end(cc, now);
+
+    cc->pacing_rate = bbr_gain(cc) * cc->max_bw;
+
+    // RTT 표본이 없으면 (텍스트 형식 등) 모델을 세울 수 없으므로 Reno 처럼 동작
+    if (!cc->min_rtt)
+        return reno_on_ack(cc, acked, 0, now);
+    // 첫 라운드가 끝나기 전에는 느린시작처럼 증가
+    if (cc->max_bw <= 0)
+    {
+        cc->cwnd += acked;
+        return CC_GROW_SS;
+    }
+
+    double target = bbr_cwnd_gain(cc) * cc->max_bw * cc->min_rtt;
+    if (target < BBR_MIN_CWND)
+        target = BBR_MIN_CWND;
+    if (cc->state == BBR_STARTUP && cc->cwnd + acked < target)
+    {
+        cc->cwnd += acked;
+        return CC_GROW_SS;
+    }
+    // 목표보다 작으면 확인된 만큼씩 다가가고, 크면 바로 목표로
+    cc->cwnd = cc->cwnd + acked < target ? cc->cwnd + acked : target;
+    return CC_GROW_CA;
+}
+
+static inline void bbr_on_dupack(Cc *cc, int dups, uint64_t now)
+{
+    (void)cc;
+    (void)dups;
+    (void)now;
+}
+
+// 타임아웃 뒤에는 1 MSS 부터 다시 채우되 대역폭 모델은 유지
+static inline void bbr_on_timeout(Cc *cc, uint64_t now)
+{
+    (void)now;
+    cc->ssthresh = cc->cwnd;
+    cc->cwnd = MSS;
+}
+
+static const CcOps cc_bbr = {"bbr", bbr_on_ack, bbr_on_dupack, bbr_on_timeout, NULL};
+
+// ------------------------------ 선택 ------------------------------
+static const CcOps *const cc_algos[] = {&cc_reno, &cc_newreno, &cc_cubic, &cc_bbr};
+
+// 이름으로 알고리즘 찾기, 없으면 NULL
+static inline const CcOps *cc_find(const char *name)
+{
+    for (size_t i = 0; i < sizeof(cc_algos) / sizeof(cc_algos[0]); i++)
+        if (strcmp(cc_algos[i]->name, name) == 0)
+            return cc_algos[i];
+    return NULL;
+}
+
+#endif
@@ -0,0 +1,123 @@
+// common.h - sender/receiver 공통 설정
+#ifndef COMMON_H
+#define COMMON_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+// 기본 설정
+#define MSS 1500 // 세그먼트 크기(바이트)
+#define BUF 256
+#define DGRAM_BUF 65536 // 데이터그램 수신 버퍼 (헤더 + 페이로드)
+#define SLEEP_US 1500000
+
+// 컬러 코드
+#define RESET "\033[0m"
+#define RED "\033[31m"
+#define GREEN "\033[32m"
+#define YELLOW "\033[33m"
+#define BLUE "\033[34m"
+#define MAGENTA "\033[35m"
+#define CYAN "\033[36m"
+#define WHITE "\033[37m"
+#define BOLDRED "\033[1;31m"
+#define BOLDYEL "\033[1;33m"
+#define BOLDMAG "\033[1;35m"
+#define BOLDCYN "\033[1;36m"
+
+typedef enum // 시나리오 구분을 위한 구조체
+{
+    MODE_NORMAL,
+    MODE_DUP3,
+    MODE_TIMEOUT,
+    MODE_BULK // 대량 전송(처리량 측정)
+} Mode;
+
+// 에러 발생 시 프로그램 종료을 위한 함수
+static inline void die(const char *msg)
+{
+    perror(msg);
+    exit(1);
+}
+
+// 단조 증가 시계 (us)
+static inline uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// 프로세스 CPU 시간 (user + sys, 초)
+static inline double cpu_seconds(void)
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 +
+           ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+// 크기 뒤의 단위 (k/m/g, 1000 배수). 알 수 없는 단위면 0
+static inline double unit_scale(const char *u)
+{
+    if (!*u)
+        return 1;
+    if (u[1])
+        return 0;
+    switch (*u | 0x20)
+    {
+    case 'k':
+        return 1e3;
+    case 'm':
+        return 1e6;
+    case 'g':
+        return 1e9;
+    }
+    return 0;
+}
+
+// -B 인자를 대역폭-지연 곱(바이트)으로: "<rate bit/s>:<rtt ms>" (예 10g:80) 또는 "<bytes>" (예 100m).
+// 잘못된 형식이면 -1
+static inline int64_t parse_bdp(const char *s)
+{
+    char *e;
+    double v = strtod(s, &e);
+    const char *colon = strchr(e, ':');
+    char unit[8] = {0};
+    size_t ul = colon ? (size_t)(colon - e) : strlen(e);
+    if (e == s || v <= 0 || ul >= sizeof(unit))
+        return -1;
+    memcpy(unit, e, ul);
+    double scale = unit_scale(unit);
+    if (scale == 0)
+        return -1;
+    if (!colon)
+        return (int64_t)(v * scale);
+    double rtt_ms = strtod(colon + 1, &e);
+    if (e == colon + 1 || *e || rtt_ms <= 0)
+        return -1;
+    return (int64_t)(v * scale / 8 * rtt_ms / 1e3);
+}
+
+// BDP 만큼의 윈도우에 필요한 세그먼트 수 (손실 복구 중 윈도우가 두 배까지 부풀 수 있어 2배)
+static inline uint32_t bdp_segs(int64_t bdp)
+{
+    int64_t n = 2 * ((bdp + MSS - 1) / MSS);
+    return n > (1 << 24) ? (1 << 24) : (uint32_t)n;
+}
+
+// bulk 모드 결과 출력: goodput, packets/s, CPU 시간
+static inline void report_throughput(const char *who, uint64_t bytes, uint64_t pkts, uint64_t elapsed_us)
+{
+    double sec = elapsed_us / 1e6;
+    if (sec <= 0)
+        sec = 1e-6;
+    printf(BOLDMAG "[%s] %llu bytes / %.3fs  goodput %.2f Mbit/s  %.0f pkts/s  CPU %.3fs\n" RESET,
+           who, (unsigned long long)bytes, sec, bytes * 8 / sec / 1e6, pkts / sec, cpu_seconds());
+}
+
+#endif
@@ -0,0 +1,159 @@
+// crc32c.h - CRC32C (Castagnoli, iSCSI/SCTP 와 같은 다항식 0x82F63B78) 계산
+// 시작할 때 crc32c_init() 한 번으로 구현을 고른다:
+//   sse4.2 : x86-64 의 crc32 명령으로 8바이트씩
+//   armv8  : aarch64 CRC 확장의 crc32cx 명령으로 8바이트씩
+//   slice8 : slice-by-8 테이블 (8KB), 하드웨어 명령이 없을 때
+// 하드웨어 경로는 target 속성으로 그 함수만 해당 명령을 쓰도록 컴파일하므로 -msse4.2 같은 플래그 없이
+// 빌드해도 되고, 실행 중인 CPU 가 지원할 때만 고른다.
+// crc32c_extend(crc, p, n) 은 이어서 계산할 수 있다: extend(extend(0, a), b) == extend(0, a||b)
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define CRC32C_X86 1
+#elif defined(__aarch64__) && defined(__linux__) && (defined(__GNUC__) || defined(__clang__))
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#define CRC32C_ARM 1
+#endif
+
+#define CRC32C_POLY 0x82F63B78u // 반사(reflected) 다항식
+
+typedef uint32_t (*Crc32cFn)(uint32_t state, const uint8_t *p, size_t n);
+
+static uint32_t crc32c_tab[8][256];
+static Crc32cFn crc32c_fn;
+static const char *crc32c_impl = "none";
+
+// 기준 구현: 비트 단위 (테이블 생성과 crcbench 의 검증용)
+static inline uint32_t crc32c_bitwise(uint32_t s, const uint8_t *p, size_t n)
+{
+    while (n--)
+    {
+        s ^= *p++;
+        for (int k = 0; k < 8; k++)
+            s = s & 1 ? (s >> 1) ^ CRC32C_POLY : s >> 1;
+    }
+    return s;
+}
+
+static inline uint32_t crc32c_slice8(uint32_t s, const uint8_t *p, size_t n)
+{
+    // 정렬되지 않은 앞부분은 한 바이트씩
+    while (n && ((uintptr_t)p & 7))
+    {
+        s = crc32c_tab[0][(s ^ *p++) & 0xff] ^ (s >> 8);
+        n--;
+    }
+    while (n >= 8)
+    {
+        uint32_t lo, hi;
+        memcpy(&lo, p, 4);
+        memcpy(&hi, p + 4, 4);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        lo = __builtin_bswap32(lo);
+        hi = __builtin_bswap32(hi);
+#endif
+        lo ^= s;
+        s = crc32c_tab[7][lo & 0xff] ^ crc32c_tab[6][(lo >> 8) & 0xff] ^
+            crc32c_tab[5][(lo >> 16) & 0xff] ^ crc32c_tab[4][lo >> 24] ^
+            crc32c_tab[3][hi & 0xff] ^ crc32c_tab[2][(hi >> 8) & 0xff] ^
+            crc32c_tab[1][(hi >> 16) & 0xff] ^ crc32c_tab[0][hi >> 24];
+        p += 8;
+        n -= 8;
+    }
+    while (n--)
+        s = crc32c_tab[0][(s ^ *p++) & 0xff] ^ (s >> 8);
+    return s;
+}
+
+#if CRC32C_X86
+__attribute__((target("sse4.2"))) static inline uint32_t crc32c_sse42(uint32_t s, const uint8_t *p, size_t n)
+{
+    uint64_t s64 = s;
+    while (n >= 8)
+    {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        s64 = _mm_crc32_u64(s64, w);
+        p += 8;
+        n -= 8;
+    }
+    s = (uint32_t)s64;
+    while (n--)
+        s = _mm_crc32_u8(s, *p++);
+    return s;
+}
+#endif
+
+#if CRC32C_ARM
+__attribute__((target("+crc"))) static inline uint32_t crc32c_armv8(uint32_t s, const uint8_t *p, size_t n)
+{
+    while (n >= 8)
+    {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        s = __crc32cd(s, w);
+        p += 8;
+        n -= 8;
+    }
+    while (n--)
+        s = __crc32cb(s, *p++);
+    return s;
+}
+#endif
+
+// 테이블을 만들고 CPU 에 맞는 구현을 고른다. force_sw 면 하드웨어 명령을 쓰지 않음
+static inline void crc32c_init_ex(int force_sw)
+{
+    for (int i = 0; i < 256; i++)
+    {
+        uint8_t b = (uint8_t)i;
+        crc32c_tab[0][i] = crc32c_bitwise(0, &b, 1);
+    }
+    for (int i = 0; i < 256; i++)
+        for (int k = 1; k < 8; k++)
+            crc32c_tab[k][i] = crc32c_tab[0][crc32c_tab[k - 1][i] & 0xff] ^ (crc32c_tab[k - 1][i] >> 8);
+
+    crc32c_fn = crc32c_slice8;
+    crc32c_impl = "slice8";
+    if (force_sw)
+        return;
+#if CRC32C_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2"))
+    {
+        crc32c_fn = crc32c_sse42;
+        crc32c_impl = "sse4.2";
+    }
+#elif CRC32C_ARM
+    if (getauxval(AT_HWCAP) & HWCAP_CRC32)
+    {
+        crc32c_fn = crc32c_armv8;
+        crc32c_impl = "armv8";
+    }
+#endif
+}
+
+static inline void crc32c_init(void)
+{
+    crc32c_init_ex(0);
+}
+
+static inline uint32_t crc32c_extend(uint32_t crc, const void *p, size_t n)
+{
+    return ~crc32c_fn(~crc, p, n);
+}
+
+static inline uint32_t crc32c(const void *p, size_t n)
+{
+    return crc32c_extend(0, p, n);
+}
+
+#endif
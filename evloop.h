@@ -0,0 +1,160 @@
+// evloop.h - 소켓 + 재전송 타이머 하나를 기다리는 이벤트 루프
+// Linux 에서는 epoll 에 소켓과 timerfd 를 함께 등록하고, 그 외 플랫폼에서는
+// poll() 의 timeout 을 타이머 만료 시각까지로 잡아 같은 동작을 흉내낸다.
+#ifndef EVLOOP_H
+#define EVLOOP_H
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+
+#include "common.h"
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#define HAVE_EPOLL 1
+#else
+#include <poll.h>
+#define HAVE_EPOLL 0
+#endif
+
+// ev_wait 결과 비트
+#define EV_READABLE 1 // 소켓에 읽을 데이터 있음
+#define EV_TIMER 2    // 타이머 만료
+
+typedef struct
+{
+    int sock;
+    uint64_t deadline; // 타이머 만료 시각 (now_us 기준), 0 이면 해제 상태
+#if HAVE_EPOLL
+    int ep;
+    int tfd;
+#endif
+} EvLoop;
+
+static inline void ev_init(EvLoop *ev, int sock)
+{
+    ev->sock = sock;
+    ev->deadline = 0;
+
+    // 이벤트 루프에서는 소켓을 논블로킹으로 두고 EAGAIN 까지 비운다
+    int fl = fcntl(sock, F_GETFL, 0);
+    fcntl(sock, F_SETFL, fl | O_NONBLOCK);
+
+#if HAVE_EPOLL
+    ev->ep = epoll_create1(0);
+    if (ev->ep < 0)
+        die("epoll_create1");
+    ev->tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if (ev->tfd < 0)
+        die("timerfd_create");
+
+    struct epoll_event e;
+    memset(&e, 0, sizeof(e));
+    e.events = EPOLLIN;
+    e.data.u32 = EV_READABLE;
+    if (epoll_ctl(ev->ep, EPOLL_CTL_ADD, sock, &e) < 0)
+        die("epoll_ctl sock");
+    e.data.u32 = EV_TIMER;
+    if (epoll_ctl(ev->ep, EPOLL_CTL_ADD, ev->tfd, &e) < 0)
+        die("epoll_ctl timerfd");
+#endif
+}
+
+static inline void ev_close(EvLoop *ev)
+{
+    int fl = fcntl(ev->sock, F_GETFL, 0);
+    fcntl(ev->sock, F_SETFL, fl & ~O_NONBLOCK);
+#if HAVE_EPOLL
+    close(ev->tfd);
+    close(ev->ep);
+#endif
+}
+
+// 지금부터 us 뒤에 만료되도록 타이머 (재)설정
+static inline void ev_timer_arm(EvLoop *ev, uint64_t us)
+{
+    if (us == 0)
+        us = 1;
+    ev->deadline = now_us() + us;
+#if HAVE_EPOLL
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = us / 1000000;
+    its.it_value.tv_nsec = (us % 1000000) * 1000;
+    timerfd_settime(ev->tfd, 0, &its, NULL);
+#endif
+}
+
+static inline void ev_timer_disarm(EvLoop *ev)
+{
+    if (!ev->deadline)
+        return;
+    ev->deadline = 0;
+#if HAVE_EPOLL
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    timerfd_settime(ev->tfd, 0, &its, NULL);
+#endif
+}
+
+static inline int ev_timer_armed(const EvLoop *ev)
+{
+    return ev->deadline != 0;
+}
+
+// 소켓이 읽을 수 있게 되거나 타이머가 만료될 때까지 대기. EV_* 비트 조합 반환
+static inline int ev_wait(EvLoop *ev)
+{
+    int ready = 0;
+#if HAVE_EPOLL
+    struct epoll_event es[2];
+    int n;
+    do
+        n = epoll_wait(ev->ep, es, 2, -1);
+    while (n < 0 && errno == EINTR);
+    if (n < 0)
+        die("epoll_wait");
+
+    for (int i = 0; i < n; i++)
+    {
+        if (es[i].data.u32 == EV_TIMER)
+        {
+            uint64_t expirations;
+            if (read(ev->tfd, &expirations, sizeof(expirations)) > 0 && ev->deadline)
+            {
+                ev->deadline = 0;
+                ready |= EV_TIMER;
+            }
+        }
+        else
+            ready |= EV_READABLE;
+    }
+#else
+    int timeout_ms = -1;
+    if (ev->deadline)
+    {
+        uint64_t now = now_us();
+        timeout_ms = ev->deadline > now ? (int)((ev->deadline - now + 999) / 1000) : 0;
+    }
+    struct pollfd p;
+    p.fd = ev->sock;
+    p.events = POLLIN;
+    int n = poll(&p, 1, timeout_ms);
+    if (n < 0 && errno != EINTR)
+        die("poll");
+    if (n > 0)
+        ready |= EV_READABLE;
+    if (ev->deadline && now_us() >= ev->deadline)
+    {
+        ev->deadline = 0;
+        ready |= EV_TIMER;
+    }
+#endif
+    return ready;
+}
+
+#endif
@@ -0,0 +1,129 @@
+// fileio.h - bulk 파일 전송 (sender -F / receiver -F)
+// 송신측은 입력 파일을 mmap 하고, 재전송 큐(sndq.h)가 슬랩에 복사하는 대신 매핑 안의 위치를
+// 가리키게 해 페이로드를 iovec 으로 바로 보낸다 (재전송도 매핑에서 다시 읽음).
+// 수신측은 재정렬 버퍼에 받아들여진 세그먼트를 도착 순서와 상관없이 pwrite 로 파일의 바이트
+// 오프셋에 바로 쓴다. 송신측은 END 에 파일 크기와 내용 해시를 실어 보내고(SEG_F_FILE),
+// 수신측은 다 쓴 파일을 다시 매핑해 같은 해시로 확인한다.
+#ifndef FILEIO_H
+#define FILEIO_H
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "common.h"
+
+typedef struct
+{
+    int fd;
+    const uint8_t *data; // 읽기 전용 매핑
+    int64_t size;
+} FileSrc;
+
+static inline uint64_t fio_rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+// 파일 내용 해시: MurmurHash3 (x64) 의 블록 섞기를 64비트 상태 하나로, 8바이트 단위.
+// 워드마다 곱셈 뒤에 회전을 넣어 어느 비트의 차이든 다른 비트로 퍼지게 하고(곱셈만으로는 위로만
+// 올라가 비트 63 의 차이 두 개가 서로 지워짐), 마지막에 fmix64 로 섞는다. 꼬리는 0 으로 채운 워드 하나
+static inline uint64_t fio_hash(const uint8_t *p, size_t n)
+{
+    const uint64_t c1 = 0x87c37b91114253d5ULL, c2 = 0x4cf5ad432745937fULL;
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ n;
+    size_t i = 0;
+    for (; i < n; i += 8)
+    {
+        uint64_t w = 0;
+        memcpy(&w, p + i, n - i < 8 ? n - i : 8);
+        w = fio_rotl(w * c1, 31) * c2;
+        h = fio_rotl(h ^ w, 27) * 5 + 0x52dce729;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    return h ^ (h >> 33);
+}
+
+// 입력 파일을 읽기 전용으로 매핑. 빈 파일이면 -1
+static inline int fio_map_src(FileSrc *fs, const char *path)
+{
+    memset(fs, 0, sizeof(*fs));
+    fs->fd = open(path, O_RDONLY);
+    if (fs->fd < 0)
+        die(path);
+    struct stat st;
+    if (fstat(fs->fd, &st) < 0)
+        die("fstat");
+    if (st.st_size == 0)
+    {
+        close(fs->fd);
+        return -1;
+    }
+    void *m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fs->fd, 0);
+    if (m == MAP_FAILED)
+        die("mmap source");
+    madvise(m, st.st_size, MADV_SEQUENTIAL);
+    fs->data = m;
+    fs->size = st.st_size;
+    return 0;
+}
+
+static inline void fio_unmap_src(FileSrc *fs)
+{
+    if (fs->data)
+        munmap((void *)fs->data, fs->size);
+    if (fs->fd >= 0)
+        close(fs->fd);
+    memset(fs, 0, sizeof(*fs));
+    fs->fd = -1;
+}
+
+static inline int fio_open_sink(const char *path)
+{
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        die(path);
+    return fd;
+}
+
+// 세그먼트 하나를 파일의 off 위치에 쓴다
+static inline void fio_put(int fd, uint64_t off, const uint8_t *p, size_t n)
+{
+    while (n > 0)
+    {
+        ssize_t w = pwrite(fd, p, n, (off_t)off);
+        if (w < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            die("pwrite");
+        }
+        p += w;
+        off += w;
+        n -= w;
+    }
+}
+
+// 받은 파일을 size 로 맞추고 내용 해시가 hash 와 같으면 1
+static inline int fio_verify(int fd, int64_t size, uint64_t hash)
+{
+    if (ftruncate(fd, size) < 0)
+        die("ftruncate");
+    if (size == 0)
+        return hash == fio_hash(NULL, 0);
+    void *m = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (m == MAP_FAILED)
+        die("mmap sink");
+    int ok = fio_hash(m, size) == hash;
+    munmap(m, size);
+    return ok;
+}
+
+#endif
@@ -0,0 +1,192 @@
+// flow.h - 수신측 플로우(연결) 테이블
+// (송신측 IP, 포트, 헤더의 conn id) 를 키로 플로우별 수신 상태를 open addressing 해시 테이블
+// (선형 탐사)에 보관한다. 삭제는 툼스톤 없이 뒤따르는 항목을 당겨 오는 backward-shift 방식이라
+// 오래 돌아도 탐사 길이가 늘어나지 않는다. 일정 시간 동안 세그먼트가 없던 플로우는 ft_evict_idle 로 정리한다.
+// 주의: ft_get 으로 새 플로우가 생기거나 ft_remove 가 호출되면 기존 Flow 포인터는 무효가 된다.
+#ifndef FLOW_H
+#define FLOW_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netinet/in.h>
+
+#include "common.h"
+#include "rcv_logic.h"
+
+#define FT_INIT_CAP 64 // 초기 슬롯 수 (2의 거듭제곱)
+
+typedef struct
+{
+    uint32_t ip;   // 네트워크 바이트 순서 그대로
+    uint16_t port; // 네트워크 바이트 순서 그대로
+    uint32_t conn; // 세그먼트 헤더의 연결 id
+} FlowKey;
+
+typedef struct
+{
+    FlowKey key;
+    int used;
+    uint64_t last_seen; // 마지막 세그먼트 도착 시각 (idle 판정)
+
+    RcvState st;
+    uint64_t rx_pkts, rx_bytes, t_first;
+
+    // 지연 ACK (receiver -d/-k): 아직 보내지 않은 누적 ACK
+    SegHdr dack;        // 마지막으로 미룬 ACK
+    SegFmt dack_fmt;
+    uint32_t dack_segs;  // ACK 없이 받은 세그먼트 수
+    uint32_t dack_tsecr; // 그중 가장 먼저 온 세그먼트의 송신 시각 (RFC 7323, 에코는 가장 오래된 것)
+    uint64_t dack_due;   // 늦어도 이 시각에 보냄
+
+    int out_fd; // receiver -F: 받은 바이트를 쓰는 파일 (없으면 -1)
+} Flow;
+
+typedef struct
+{
+    Flow *slots;
+    uint32_t cap; // 2의 거듭제곱
+    uint32_t n;
+    uint32_t ro_cap; // 새 플로우의 재정렬 버퍼 용량 (블록 수, 0 이면 기본값)
+    uint64_t created, evicted;
+} FlowTable;
+
+static inline FlowKey flow_key(const struct sockaddr_in *from, uint32_t conn)
+{
+    FlowKey k;
+    k.ip = from->sin_addr.s_addr;
+    k.port = from->sin_port;
+    k.conn = conn;
+    return k;
+}
+
+static inline int flow_key_eq(const FlowKey *a, const FlowKey *b)
+{
+    return a->ip == b->ip && a->port == b->port && a->conn == b->conn;
+}
+
+static inline uint32_t flow_hash(const FlowKey *k)
+{
+    uint64_t x = ((uint64_t)k->ip << 32 | (uint64_t)k->port << 16) ^ ((uint64_t)k->conn * 0x9e3779b97f4a7c15ULL);
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return (uint32_t)x;
+}
+
+static inline void ft_init(FlowTable *ft)
+{
+    memset(ft, 0, sizeof(*ft));
+    ft->cap = FT_INIT_CAP;
+    ft->slots = calloc(ft->cap, sizeof(Flow));
+    if (!ft->slots)
+        die("calloc flow table");
+}
+
+static inline void ft_free(FlowTable *ft)
+{
+    for (uint32_t i = 0; i < ft->cap; i++)
+        if (ft->slots[i].used)
+            rcv_free(&ft->slots[i].st);
+    free(ft->slots);
+    ft->slots = NULL;
+    ft->cap = ft->n = 0;
+}
+
+// 키가 있으면 그 슬롯, 없으면 들어갈 빈 슬롯의 인덱스
+static inline uint32_t ft_probe(const FlowTable *ft, const FlowKey *k)
+{
+    uint32_t mask = ft->cap - 1;
+    uint32_t i = flow_hash(k) & mask;
+    while (ft->slots[i].used && !flow_key_eq(&ft->slots[i].key, k))
+        i = (i + 1) & mask;
+    return i;
+}
+
+static inline Flow *ft_find(FlowTable *ft, const FlowKey *k)
+{
+    Flow *f = &ft->slots[ft_probe(ft, k)];
+    return f->used ? f : NULL;
+}
+
+// 부하율 1/2 을 넘으면 두 배로 늘려 다시 배치
+static inline void ft_grow(FlowTable *ft)
+{
+    Flow *old = ft->slots;
+    uint32_t old_cap = ft->cap;
+    ft->cap *= 2;
+    ft->slots = calloc(ft->cap, sizeof(Flow));
+    if (!ft->slots)
+        die("calloc flow table");
+    for (uint32_t i = 0; i < old_cap; i++)
+        if (old[i].used)
+            ft->slots[ft_probe(ft, &old[i].key)] = old[i];
+    free(old);
+}
+
+// 키의 플로우를 찾고, 없으면 mode 의 초기 상태로 새로 만든다
+static inline Flow *ft_get(FlowTable *ft, const FlowKey *k, Mode mode)
+{
+    uint32_t i = ft_probe(ft, k);
+    if (ft->slots[i].used)
+        return &ft->slots[i];
+
+    if ((ft->n + 1) * 2 > ft->cap)
+    {
+        ft_grow(ft);
+        i = ft_probe(ft, k);
+    }
+    Flow *f = &ft->slots[i];
+    memset(f, 0, sizeof(*f));
+    f->used = 1;
+    f->key = *k;
+    f->out_fd = -1;
+    rcv_init(&f->st, mode, ft->ro_cap);
+    ft->n++;
+    ft->created++;
+    return f;
+}
+
+// 플로우 삭제: 뒤이은 클러스터 항목 중 원래 자리가 빈칸 이전인 것을 당겨 와 탐사 사슬을 유지
+static inline void ft_remove(FlowTable *ft, Flow *f)
+{
+    uint32_t mask = ft->cap - 1;
+    uint32_t hole = f - ft->slots;
+    rcv_free(&f->st);
+    f->used = 0;
+    ft->n--;
+
+    for (uint32_t j = (hole + 1) & mask; ft->slots[j].used; j = (j + 1) & mask)
+    {
+        uint32_t home = flow_hash(&ft->slots[j].key) & mask;
+        // home 이 (hole, j] 구간 밖이면 hole 로 옮겨도 탐사로 찾을 수 있다
+        if (((j - home) & mask) >= ((j - hole) & mask))
+        {
+            ft->slots[hole] = ft->slots[j];
+            ft->slots[j].used = 0;
+            hole = j;
+        }
+    }
+}
+
+// idle_us 이상 세그먼트가 없던 플로우를 정리하고 그 수를 반환.
+// 당겨 온 항목을 다시 검사하도록 같은 슬롯을 한 번 더 본다
+static inline int ft_evict_idle(FlowTable *ft, uint64_t now, uint64_t idle_us)
+{
+    int k = 0;
+    for (uint32_t i = 0; i < ft->cap;)
+    {
+        Flow *f = &ft->slots[i];
+        if (f->used && now - f->last_seen >= idle_us)
+        {
+            ft_remove(ft, f);
+            ft->evicted++;
+            k++;
+            continue;
+        }
+        i++;
+    }
+    return k;
+}
+
+#endif
@@ -0,0 +1,194 @@
+// fluid.c - 대량 cwnd 궤적 계산 (용량 계획용 유체 모델)
+// 실행 방법:
+//   ./fluid [-n flows] [-t steps] [-p p_dup3] [-T p_timeout] [-i init_cwnd] [-s ssthresh] [-W max_wnd]
+//           [-j threads] [-S seed] [-x check]
+//   p_dup3, p_timeout : ACK 하나마다 3 중복 ACK / 타임아웃이 날 확률 (기본 0.001, 0.0001)
+//   init_cwnd, max_wnd : MSS 개수 (기본 1, 1000),  ssthresh : 바이트 (기본 15000)
+//   check : 기준 경로(cc.h reno 를 플로우 하나씩 호출)로 다시 계산해 비교할 플로우 수 (기본 10000, 0 이면 생략)
+// fluid.h 의 SoA 벡터 커널로 모든 플로우를 steps 단계 진행한 뒤 cwnd 시간 평균의 분포와
+// 마지막 상태 비율, 처리 속도(플로우·단계/s)를 출력한다. 플로우 묶음은 pool.h 스레드 풀로 나눈다.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "common.h"
+#include "fluid.h"
+#include "pool.h"
+
+#define FLUID_CHUNK 1024 // 작업 하나가 맡는 플로우 수 (FLUID_LANES 배수)
+
+typedef struct
+{
+    Fleet *fleet;
+    int steps;
+    FluidParams p;
+    int simd;
+} Job;
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// 정렬된 v 의 q 분위수 (가장 가까운 순위)
+static double quantile_sorted(const double *v, long n, double q)
+{
+    return v[(long)(q * (n - 1) + 0.5)];
+}
+
+static void fluid_task(void *arg, uint32_t task, int worker)
+{
+    (void)worker;
+    Job *job = arg;
+    size_t lo = (size_t)task * FLUID_CHUNK, hi = lo + FLUID_CHUNK;
+    if (hi > job->fleet->cap)
+        hi = job->fleet->cap;
+    if (job->simd)
+        fluid_run_simd(job->fleet, lo, hi, job->steps, &job->p);
+    else
+        fluid_run_generic(job->fleet, lo, hi, job->steps, &job->p);
+}
+
+// 처리 시간 (us) 반환
+static uint64_t run_fleet(Fleet *f, int steps, const FluidParams *p, int simd, int threads)
+{
+    Job job = {f, steps, *p, simd};
+    uint32_t ntasks = (uint32_t)((f->cap + FLUID_CHUNK - 1) / FLUID_CHUNK);
+    uint64_t t0 = now_us();
+    pool_run(ntasks, threads, fluid_task, &job);
+    return now_us() - t0;
+}
+
+int main(int argc, char **argv)
+{
+    long n = 1000000;
+    int steps = 1000;
+    double p_dup = 0.001, p_to = 0.0001;
+    double init_cwnd = 1, ssthresh = 15000, max_wnd = 1000;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t seed = 1;
+    long check = 10000;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:p:T:i:s:W:j:S:x:")) != -1)
+    {
+        if (opt == 'n')
+            n = atol(optarg);
+        else if (opt == 't')
+            steps = atoi(optarg);
+        else if (opt == 'p')
+            p_dup = atof(optarg);
+        else if (opt == 'T')
+            p_to = atof(optarg);
+        else if (opt == 'i')
+            init_cwnd = atof(optarg);
+        else if (opt == 's')
+            ssthresh = atof(optarg);
+        else if (opt == 'W')
+            max_wnd = atof(optarg);
+        else if (opt == 'j')
+            threads = atoi(optarg);
+        else if (opt == 'S')
+            seed = strtoull(optarg, NULL, 10);
+        else if (opt == 'x')
+            check = atol(optarg);
+        else
+        {
+            fprintf(stderr, "usage: %s [-n flows] [-t steps] [-p p_dup3] [-T p_timeout] [-i init_cwnd] "
+                            "[-s ssthresh] [-W max_wnd] [-j threads] [-S seed] [-x check]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (n < 1 || steps < 1 || threads < 1 || init_cwnd < 1 || max_wnd < 1 || p_dup < 0 || p_to < 0 ||
+        p_dup + p_to > 1)
+    {
+        fprintf(stderr, "-n, -t, -j 는 양수, -i, -W 는 1 이상, 확률은 0 이상이고 합이 1 이하여야 합니다\n");
+        return 1;
+    }
+    if (check > n)
+        check = n;
+
+    FluidParams p = fluid_params(p_dup, p_to, max_wnd * MSS);
+    Fleet fleet;
+    fleet_init(&fleet, (size_t)n, init_cwnd * MSS, ssthresh, seed);
+
+    printf(BOLDMAG "=== [FLUID] %ld 플로우 x %d 단계, 커널 %s, 스레드 %ld ===\n" RESET,
+           n, steps, FLUID_KERNEL, threads);
+    printf("  p_dup3=%g p_timeout=%g  초기 cwnd=%.0f MSS ssthresh=%.0f  최대 윈도우=%.0f MSS\n",
+           p_dup, p_to, init_cwnd, ssthresh, max_wnd);
+
+    uint64_t us = run_fleet(&fleet, steps, &p, 1, (int)threads);
+    double rate = (double)n * steps / (us ? us : 1);
+    printf(GREEN "  %s 커널: %.3f s, %.1f M 플로우·단계/s\n" RESET, FLUID_KERNEL, us / 1e6, rate);
+
+    // 교차 검증: 같은 플로우를 분기 없는 스칼라 경로와 cc.h 기준 경로로 다시 계산
+    if (check > 0)
+    {
+        Fleet gen;
+        fleet_init(&gen, (size_t)check, init_cwnd * MSS, ssthresh, seed);
+        uint64_t gus = run_fleet(&gen, steps, &p, 0, 1);
+        long bad_gen = 0, bad_ref = 0;
+        uint64_t t0 = now_us();
+        for (long i = 0; i < check; i++)
+        {
+            double cw, th, sm;
+            int64_t st;
+            fluid_reference((size_t)i, init_cwnd * MSS, ssthresh, seed, steps, &p, &cw, &th, &sm, &st);
+            if (cw != fleet.cwnd[i] || th != fleet.ssthresh[i] || sm != fleet.sum[i] || st != fleet.state[i])
+            {
+                if (!bad_ref)
+                    printf(RED "  플로우 %ld 불일치: cwnd %.17g/%.17g ssthresh %.17g/%.17g sum %.17g/%.17g\n" RESET,
+                           i, fleet.cwnd[i], cw, fleet.ssthresh[i], th, fleet.sum[i], sm);
+                bad_ref++;
+            }
+            if (gen.cwnd[i] != fleet.cwnd[i] || gen.ssthresh[i] != fleet.ssthresh[i] ||
+                gen.sum[i] != fleet.sum[i] || gen.state[i] != fleet.state[i])
+                bad_gen++;
+        }
+        uint64_t rus = now_us() - t0;
+        printf("  스칼라 경로(1 스레드): %.1f M/s, 기준 경로(cc.h): %.1f M/s\n",
+               (double)check * steps / (gus ? gus : 1), (double)check * steps / (rus ? rus : 1));
+        if (bad_gen || bad_ref)
+            printf(BOLDRED "  교차 검증 실패: %ld 플로우 중 스칼라 %ld, 기준 %ld 불일치\n" RESET, check, bad_gen, bad_ref);
+        else
+            printf(GREEN "  교차 검증: %ld 플로우 모두 비트 단위로 일치\n" RESET, check);
+        fleet_free(&gen);
+        if (bad_gen || bad_ref)
+        {
+            fleet_free(&fleet);
+            return 1;
+        }
+    }
+
+    // 시간 평균 cwnd 분포 (플로우별 값을 정렬한 정확한 분위수) 와 마지막 상태
+    double *avgs = malloc(sizeof(double) * n);
+    if (!avgs)
+        die("malloc");
+    long states[FL_STATES] = {0};
+    double mean = 0;
+    for (long i = 0; i < n; i++)
+    {
+        avgs[i] = fleet.sum[i] / steps / MSS;
+        mean += avgs[i];
+        states[fleet.state[i]]++;
+    }
+    mean /= n;
+    qsort(avgs, n, sizeof(double), cmp_double);
+    printf("  평균 cwnd (MSS): 평균 %.2f, p10 %.2f, p50 %.2f, p90 %.2f, p99 %.2f\n", mean,
+           quantile_sorted(avgs, n, 0.1), quantile_sorted(avgs, n, 0.5), quantile_sorted(avgs, n, 0.9),
+           quantile_sorted(avgs, n, 0.99));
+    free(avgs);
+    if (p_dup > 0 && p_to == 0)
+        printf("  (참고: 정상 상태 Reno 근사 sqrt(3/(2p)) = %.2f MSS)\n", sqrt(1.5 / p_dup));
+    printf("  마지막 단계: SS %.1f%%, CA %.1f%%, 3DUP %.2f%%, TIMEOUT %.2f%%\n",
+           100.0 * states[FL_SS] / n, 100.0 * states[FL_CA] / n, 100.0 * states[FL_DUP3] / n,
+           100.0 * states[FL_TIMEOUT] / n);
+
+    fleet_free(&fleet);
+    return 0;
+}
@@ -0,0 +1,290 @@
+// fluid.h - 다수 플로우의 cwnd 궤적을 한꺼번에 계산하는 SoA 벡터 엔진
+// 플로우마다 Cc 구조체를 두는 대신 cwnd, ssthresh, 누적 cwnd, 난수 상태, 마지막 사건을
+// 배열 하나씩(structure of arrays)에 두고, 한 단계(ACK 하나)마다 모든 플로우에 같은 규칙을 적용한다.
+//   - 느린시작: cwnd += MSS, 혼잡회피: cwnd += MSS*MSS/cwnd (cc.h 의 reno 와 같은 연산 순서)
+//   - 3 중복 ACK: cwnd = ssthresh = max(cwnd/2, MSS), 타임아웃: ssthresh = max(cwnd/2, MSS), cwnd = MSS
+//   - 사건은 플로우별 xorshift64 난수로 ACK 마다 확률 p_dup3 / p_timeout 으로 고름
+// 분기 없이 비교 마스크와 blend 로만 상태를 바꾸므로 AVX2 (4 lane), NEON (2 lane) 으로 그대로 옮겨진다.
+// 어느 경로든 결과는 플로우 하나씩 cc.h 를 호출하는 fluid_reference 와 비트 단위로 같아야 한다
+// (FMA 축약이 끼면 달라지므로 -ffp-contract=off 로 빌드).
+#ifndef FLUID_H
+#define FLUID_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FLUID_KERNEL "avx2"
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define FLUID_KERNEL "neon"
+#else
+#define FLUID_KERNEL "generic"
+#endif
+
+#include "common.h"
+#include "cc.h"
+
+#define FLUID_LANES 8 // 배열 길이는 이 배수로 올림 (AVX2 4, NEON 2 의 공배수)
+
+// 플로우의 마지막 단계 사건. blend 마스크와 폭을 맞추려고 64비트
+enum
+{
+    FL_SS,      // 느린시작 증가
+    FL_CA,      // 혼잡회피 증가
+    FL_DUP3,    // 3 중복 ACK
+    FL_TIMEOUT, // 타임아웃
+    FL_STATES
+};
+
+typedef struct
+{
+    size_t n; // 실제 플로우 수 (배열은 FLUID_LANES 배수)
+    size_t cap;
+    double *cwnd;     // 바이트
+    double *ssthresh; // 바이트
+    double *sum;      // 단계마다 cwnd 누적 (시간 평균용)
+    uint64_t *rng;    // xorshift64 상태
+    int64_t *state;   // FL_*
+} Fleet;
+
+typedef struct
+{
+    double cwnd_max;   // 수신 윈도우 (바이트)
+    uint64_t t_to;     // 난수 (63비트) 가 이 값보다 작으면 타임아웃
+    uint64_t t_dup;    // t_to 이상 이 값 미만이면 3 중복 ACK
+} FluidParams;
+
+static inline FluidParams fluid_params(double p_dup3, double p_timeout, double cwnd_max)
+{
+    FluidParams p;
+    p.cwnd_max = cwnd_max;
+    p.t_to = (uint64_t)(p_timeout * 9223372036854775808.0);
+    p.t_dup = p.t_to + (uint64_t)(p_dup3 * 9223372036854775808.0);
+    return p;
+}
+
+static inline uint64_t fluid_xorshift(uint64_t x)
+{
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return x;
+}
+
+// 플로우 i 의 초기 난수 상태 (splitmix64, 0 이 되지 않게)
+static inline uint64_t fluid_seed(uint64_t seed, size_t i)
+{
+    uint64_t z = seed + (i + 1) * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z ^= z >> 31;
+    return z ? z : 1;
+}
+
+static inline void *fluid_alloc(size_t bytes)
+{
+    void *p = aligned_alloc(64, (bytes + 63) & ~(size_t)63);
+    if (!p)
+        die("alloc fleet");
+    return p;
+}
+
+static inline void fleet_init(Fleet *f, size_t n, double cwnd, double ssthresh, uint64_t seed)
+{
+    f->n = n;
+    f->cap = (n + FLUID_LANES - 1) / FLUID_LANES * FLUID_LANES;
+    f->cwnd = fluid_alloc(sizeof(double) * f->cap);
+    f->ssthresh = fluid_alloc(sizeof(double) * f->cap);
+    f->sum = fluid_alloc(sizeof(double) * f->cap);
+    f->rng = fluid_alloc(sizeof(uint64_t) * f->cap);
+    f->state = fluid_alloc(sizeof(int64_t) * f->cap);
+    for (size_t i = 0; i < f->cap; i++)
+    {
+        f->cwnd[i] = cwnd;
+        f->ssthresh[i] = ssthresh;
+        f->sum[i] = 0;
+        f->rng[i] = fluid_seed(seed, i);
+        f->state[i] = FL_SS;
+    }
+}
+
+static inline void fleet_free(Fleet *f)
+{
+    free(f->cwnd);
+    free(f->ssthresh);
+    free(f->sum);
+    free(f->rng);
+    free(f->state);
+    memset(f, 0, sizeof(*f));
+}
+
+// ------------------------------ 커널 ------------------------------
+// 플로우 [lo, hi) 를 steps 단계 진행. lo, hi 는 FLUID_LANES 배수.
+// 플로우 묶음을 레지스터에 올린 채 모든 단계를 돌고 나서 저장하므로 메모리 왕복은 묶음당 한 번
+
+// 분기 없는 스칼라 경로 (벡터 명령이 없을 때, 그리고 커널들이 따르는 규칙의 원형)
+static inline void fluid_run_generic(Fleet *f, size_t lo, size_t hi, int steps, const FluidParams *p)
+{
+    for (size_t i = lo; i < hi; i++)
+    {
+        double cw = f->cwnd[i], th = f->ssthresh[i], sm = f->sum[i];
+        uint64_t x = f->rng[i];
+        int64_t st = f->state[i];
+        for (int s = 0; s < steps; s++)
+        {
+            x = fluid_xorshift(x);
+            uint64_t u = x >> 1;
+            int to = u < p->t_to;
+            int dup = !to & (u < p->t_dup);
+            int ss = cw < th;
+            double inc = ss ? MSS : MSS * ((double)MSS / cw);
+            double grown = cw + inc;
+            grown = grown < p->cwnd_max ? grown : p->cwnd_max;
+            double half = cw * 0.5;
+            half = half > MSS ? half : MSS;
+            th = (to | dup) ? half : th;
+            cw = to ? MSS : dup ? half : grown;
+            st = to ? FL_TIMEOUT : dup ? FL_DUP3 : ss ? FL_SS : FL_CA;
+            sm += cw;
+        }
+        f->cwnd[i] = cw;
+        f->ssthresh[i] = th;
+        f->sum[i] = sm;
+        f->rng[i] = x;
+        f->state[i] = st;
+    }
+}
+
+#if defined(__AVX2__)
+static inline void fluid_run_simd(Fleet *f, size_t lo, size_t hi, int steps, const FluidParams *p)
+{
+    const __m256d mss = _mm256_set1_pd(MSS), cmax = _mm256_set1_pd(p->cwnd_max), k_half = _mm256_set1_pd(0.5);
+    const __m256i t_to = _mm256_set1_epi64x((int64_t)p->t_to), t_dup = _mm256_set1_epi64x((int64_t)p->t_dup);
+    const __m256i s_ss = _mm256_set1_epi64x(FL_SS), s_ca = _mm256_set1_epi64x(FL_CA);
+    const __m256i s_dup = _mm256_set1_epi64x(FL_DUP3), s_to = _mm256_set1_epi64x(FL_TIMEOUT);
+    for (size_t i = lo; i < hi; i += 4)
+    {
+        __m256d cw = _mm256_load_pd(&f->cwnd[i]), th = _mm256_load_pd(&f->ssthresh[i]);
+        __m256d sm = _mm256_load_pd(&f->sum[i]);
+        __m256i x = _mm256_load_si256((const __m256i *)&f->rng[i]);
+        __m256i st = _mm256_load_si256((const __m256i *)&f->state[i]);
+        for (int s = 0; s < steps; s++)
+        {
+            x = _mm256_xor_si256(x, _mm256_slli_epi64(x, 13));
+            x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 7));
+            x = _mm256_xor_si256(x, _mm256_slli_epi64(x, 17));
+            __m256i u = _mm256_srli_epi64(x, 1); // 63비트라 부호 있는 비교로 충분
+            __m256i to = _mm256_cmpgt_epi64(t_to, u);
+            __m256i dup = _mm256_andnot_si256(to, _mm256_cmpgt_epi64(t_dup, u));
+            __m256d to_d = _mm256_castsi256_pd(to), dup_d = _mm256_castsi256_pd(dup);
+
+            __m256d ss = _mm256_cmp_pd(cw, th, _CMP_LT_OQ);
+            __m256d inc = _mm256_blendv_pd(_mm256_mul_pd(mss, _mm256_div_pd(mss, cw)), mss, ss);
+            __m256d grown = _mm256_min_pd(_mm256_add_pd(cw, inc), cmax);
+            __m256d half = _mm256_max_pd(_mm256_mul_pd(cw, k_half), mss);
+            th = _mm256_blendv_pd(th, half, _mm256_or_pd(to_d, dup_d));
+            cw = _mm256_blendv_pd(_mm256_blendv_pd(grown, half, dup_d), mss, to_d);
+
+            st = _mm256_blendv_epi8(s_ca, s_ss, _mm256_castpd_si256(ss));
+            st = _mm256_blendv_epi8(st, s_dup, dup);
+            st = _mm256_blendv_epi8(st, s_to, to);
+            sm = _mm256_add_pd(sm, cw);
+        }
+        _mm256_store_pd(&f->cwnd[i], cw);
+        _mm256_store_pd(&f->ssthresh[i], th);
+        _mm256_store_pd(&f->sum[i], sm);
+        _mm256_store_si256((__m256i *)&f->rng[i], x);
+        _mm256_store_si256((__m256i *)&f->state[i], st);
+    }
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+static inline void fluid_run_simd(Fleet *f, size_t lo, size_t hi, int steps, const FluidParams *p)
+{
+    const float64x2_t mss = vdupq_n_f64(MSS), cmax = vdupq_n_f64(p->cwnd_max), k_half = vdupq_n_f64(0.5);
+    const uint64x2_t t_to = vdupq_n_u64(p->t_to), t_dup = vdupq_n_u64(p->t_dup);
+    const int64x2_t s_ss = vdupq_n_s64(FL_SS), s_ca = vdupq_n_s64(FL_CA);
+    const int64x2_t s_dup = vdupq_n_s64(FL_DUP3), s_to = vdupq_n_s64(FL_TIMEOUT);
+    for (size_t i = lo; i < hi; i += 2)
+    {
+        float64x2_t cw = vld1q_f64(&f->cwnd[i]), th = vld1q_f64(&f->ssthresh[i]), sm = vld1q_f64(&f->sum[i]);
+        uint64x2_t x = vld1q_u64(&f->rng[i]);
+        int64x2_t st = vld1q_s64(&f->state[i]);
+        for (int s = 0; s < steps; s++)
+        {
+            x = veorq_u64(x, vshlq_n_u64(x, 13));
+            x = veorq_u64(x, vshrq_n_u64(x, 7));
+            x = veorq_u64(x, vshlq_n_u64(x, 17));
+            uint64x2_t u = vshrq_n_u64(x, 1);
+            uint64x2_t to = vcltq_u64(u, t_to);
+            uint64x2_t dup = vbicq_u64(vcltq_u64(u, t_dup), to);
+
+            uint64x2_t ss = vcltq_f64(cw, th);
+            float64x2_t inc = vbslq_f64(ss, mss, vmulq_f64(mss, vdivq_f64(mss, cw)));
+            float64x2_t grown = vminq_f64(vaddq_f64(cw, inc), cmax);
+            float64x2_t half = vmaxq_f64(vmulq_f64(cw, k_half), mss);
+            th = vbslq_f64(vorrq_u64(to, dup), half, th);
+            cw = vbslq_f64(to, mss, vbslq_f64(dup, half, grown));
+
+            st = vbslq_s64(ss, s_ss, s_ca);
+            st = vbslq_s64(dup, s_dup, st);
+            st = vbslq_s64(to, s_to, st);
+            sm = vaddq_f64(sm, cw);
+        }
+        vst1q_f64(&f->cwnd[i], cw);
+        vst1q_f64(&f->ssthresh[i], th);
+        vst1q_f64(&f->sum[i], sm);
+        vst1q_u64(&f->rng[i], x);
+        vst1q_s64(&f->state[i], st);
+    }
+}
+#else
+static inline void fluid_run_simd(Fleet *f, size_t lo, size_t hi, int steps, const FluidParams *p)
+{
+    fluid_run_generic(f, lo, hi, steps, p);
+}
+#endif
+
+// ------------------------------ 기준 경로 ------------------------------
+// 플로우 i 하나를 송신측과 같은 cc.h reno 훅으로 진행한다 (분기 그대로, 교차 검증용).
+// fleet 의 초기값과 같은 cwnd/ssthresh/seed 에서 시작해 결과를 out_* 에 채움
+static inline void fluid_reference(size_t i, double cwnd, double ssthresh, uint64_t seed, int steps,
+                                   const FluidParams *p, double *out_cwnd, double *out_ssthresh,
+                                   double *out_sum, int64_t *out_state)
+{
+    Cc cc;
+    cc_init(&cc, &cc_reno, cwnd, ssthresh);
+    uint64_t x = fluid_seed(seed, i);
+    double sum = 0;
+    int64_t st = FL_SS;
+    for (int s = 0; s < steps; s++)
+    {
+        x = fluid_xorshift(x);
+        uint64_t u = x >> 1;
+        if (u < p->t_to)
+        {
+            cc_on_timeout(&cc, 0);
+            st = FL_TIMEOUT;
+        }
+        else if (u < p->t_dup)
+        {
+            cc_on_dupack(&cc, 3, 0);
+            st = FL_DUP3;
+        }
+        else
+        {
+            st = cc_on_ack(&cc, MSS, 0, 0) == CC_GROW_SS ? FL_SS : FL_CA;
+            if (cc.cwnd > p->cwnd_max)
+                cc.cwnd = p->cwnd_max;
+        }
+        sum += cc.cwnd;
+    }
+    *out_cwnd = cc.cwnd;
+    *out_ssthresh = cc.ssthresh;
+    *out_sum = sum;
+    *out_state = st;
+}
+
+#endif
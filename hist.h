@@ -0,0 +1,90 @@
+// hist.h - HDR 스타일 로그 버킷 히스토그램
+// 값(us 등 음이 아닌 정수)을 2의 거듭제곱 구간마다 HIST_SUB 개의 균등 하위 버킷으로 나눠 센다.
+// 64 미만은 정확히, 그 이상은 상대 오차 1/HIST_SUB(약 3%) 이내로 기록되며 메모리는 값 범위와 무관하게 고정.
+// 분위수는 해당 버킷의 상한값(그 버킷에 들어갈 수 있는 가장 큰 값)으로 보고한다.
+#ifndef HIST_H
+#define HIST_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define HIST_SUB_BITS 5
+#define HIST_SUB (1 << HIST_SUB_BITS)                       // 구간당 하위 버킷 수
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS + 1) * HIST_SUB) // uint64 전체 범위
+
+typedef struct
+{
+    uint64_t count[HIST_BUCKETS];
+    uint64_t n;
+    uint64_t min, max;
+} Hist;
+
+static inline void hist_init(Hist *h)
+{
+    memset(h, 0, sizeof(*h));
+}
+
+static inline int hist_index(uint64_t v)
+{
+    if (v < 2 * HIST_SUB)
+        return (int)v;
+    int e = 63 - __builtin_clzll(v); // floor(log2 v), HIST_SUB_BITS+1 이상
+    int shift = e - HIST_SUB_BITS;
+    return shift * HIST_SUB + (int)(v >> shift); // (v >> shift) 는 [HIST_SUB, 2*HIST_SUB)
+}
+
+// 버킷 i 에 들어갈 수 있는 가장 큰 값
+static inline uint64_t hist_upper(int i)
+{
+    if (i < 2 * HIST_SUB)
+        return i;
+    int shift = i / HIST_SUB - 1;
+    uint64_t sub = i % HIST_SUB + HIST_SUB;
+    return ((sub + 1) << shift) - 1;
+}
+
+static inline void hist_add(Hist *h, uint64_t v)
+{
+    h->count[hist_index(v)]++;
+    if (!h->n || v < h->min)
+        h->min = v;
+    if (v > h->max)
+        h->max = v;
+    h->n++;
+}
+
+static inline void hist_merge(Hist *dst, const Hist *src)
+{
+    if (!src->n)
+        return;
+    for (int i = 0; i < HIST_BUCKETS; i++)
+        dst->count[i] += src->count[i];
+    if (!dst->n || src->min < dst->min)
+        dst->min = src->min;
+    if (src->max > dst->max)
+        dst->max = src->max;
+    dst->n += src->n;
+}
+
+// q (0~1) 분위수. 표본이 없으면 0
+static inline uint64_t hist_quantile(const Hist *h, double q)
+{
+    if (!h->n)
+        return 0;
+    uint64_t rank = (uint64_t)(q * h->n + 0.999999); // ceil, 최소 1
+    if (rank < 1)
+        rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++)
+    {
+        seen += h->count[i];
+        if (seen >= rank)
+        {
+            uint64_t v = hist_upper(i);
+            return v < h->max ? v : h->max; // 마지막 버킷은 실제 최대값을 넘지 않게
+        }
+    }
+    return h->max;
+}
+
+#endif
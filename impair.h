@@ -0,0 +1,349 @@
+// impair.h - 경로 손상(impairment) 엔진
+// 수신측에 도착한 DATA 데이터그램을 처리하기 전에 통과시키는 단계로, 시드를 고정한 난수로
+// 손실, 지연/지터, 순서 뒤바뀜, 중복을 재현 가능하게 만든다. (netem 과 비슷한 역할)
+//   손실 모델 : Bernoulli (패킷마다 독립적으로 loss 확률)
+//               Gilbert-Elliott (좋음/나쁨 두 상태 마르코프 체인, 나쁨 상태에서 연속 손실)
+//   지연      : delay + [-jitter, +jitter] 균등 분포 (지터가 간격보다 크면 자연스럽게 순서가 바뀜)
+//   재정렬    : reorder 확률로 gap 만큼 더 늦게 전달
+//   중복      : dup 확률로 같은 데이터그램을 한 번 더 전달
+//   손상      : corrupt 확률로 페이로드의 비트 하나를 뒤집어 전달 (CRC32C 검사 확인용)
+// 지연된 데이터그램은 복사해서 (전달 시각, 도착 순서) 최소 힙에 보관하고,
+// 수신 루프가 imp_next_due 시각에 타이머를 걸어 imp_pop 으로 꺼낸다.
+//
+// 설정 문자열 예: "loss=0.01,delay=5ms,jitter=1ms,reorder=0.02,dup=0.001,seed=7"
+//                 "ge=0.01:0.3,delay=2ms"  (ge=p:r[:나쁨 손실률[:좋음 손실률]])
+#ifndef IMPAIR_H
+#define IMPAIR_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netinet/in.h>
+
+#include "common.h"
+#include "segment.h"
+
+#define IMP_REORDER_GAP_US 1000 // reorder 된 패킷의 기본 추가 지연
+
+typedef struct
+{
+    double loss;           // Bernoulli 손실률
+    int ge;                // Gilbert-Elliott 사용 여부
+    double ge_p, ge_r;     // 좋음→나쁨, 나쁨→좋음 전이 확률
+    double ge_loss_bad;    // 나쁨 상태 손실률 (기본 1)
+    double ge_loss_good;   // 좋음 상태 손실률 (기본 0)
+    uint64_t delay_us;     // 고정 지연
+    uint64_t jitter_us;    // 지연 변동 폭 (±)
+    double reorder;        // 재정렬 확률
+    uint64_t gap_us;       // 재정렬 시 추가 지연
+    double dup;            // 중복 확률
+    double corrupt;        // 페이로드 비트 손상 확률
+    uint64_t seed;
+} ImpairCfg;
+
+// 지연 중인 데이터그램
+typedef struct
+{
+    uint64_t t;  // 전달 시각 (now_us 기준)
+    uint64_t id; // 같은 시각이면 먼저 들어온 것부터
+    struct sockaddr_in from;
+    uint8_t *data; // imp_pop 으로 꺼낸 쪽에서 free
+    int n;
+} ImpPkt;
+
+typedef struct
+{
+    ImpairCfg cfg;
+    uint64_t rng;
+    int bad; // Gilbert-Elliott 현재 상태
+
+    ImpPkt *heap;
+    int n, cap;
+    uint64_t next_id;
+
+    uint64_t seen, dropped, dropped_bad, duplicated, reordered, delayed, corrupted;
+} Impair;
+
+// ------------------------------ 설정 파싱 ------------------------------
+// "5ms", "300us", "2s" 또는 단위 없는 us 값
+static inline int imp_parse_us(const char *s, uint64_t *out)
+{
+    char *end;
+    double v = strtod(s, &end);
+    if (end == s || v < 0)
+        return -1;
+    if (*end == '\0' || strcmp(end, "us") == 0)
+        *out = (uint64_t)v;
+    else if (strcmp(end, "ms") == 0)
+        *out = (uint64_t)(v * 1000);
+    else if (strcmp(end, "s") == 0)
+        *out = (uint64_t)(v * 1000000);
+    else
+        return -1;
+    return 0;
+}
+
+static inline int imp_parse_prob(const char *s, double *out)
+{
+    char *end;
+    double v = strtod(s, &end);
+    if (end == s || *end != '\0' || v < 0 || v > 1)
+        return -1;
+    *out = v;
+    return 0;
+}
+
+// key=value 를 쉼표로 이은 설정 문자열 해석. 성공 0, 잘못된 항목이 있으면 -1
+static inline int imp_parse(ImpairCfg *c, const char *spec)
+{
+    memset(c, 0, sizeof(*c));
+    c->ge_loss_bad = 1;
+    c->gap_us = IMP_REORDER_GAP_US;
+    c->seed = 1;
+
+    char tmp[BUF];
+    snprintf(tmp, sizeof(tmp), "%s", spec);
+    for (char *save = NULL, *kv = strtok_r(tmp, ",", &save); kv; kv = strtok_r(NULL, ",", &save))
+    {
+        char *v = strchr(kv, '=');
+        if (!v)
+            return -1;
+        *v++ = '\0';
+
+        int bad = 0;
+        if (strcmp(kv, "loss") == 0)
+            bad = imp_parse_prob(v, &c->loss);
+        else if (strcmp(kv, "ge") == 0)
+        {
+            // p:r[:나쁨 손실률[:좋음 손실률]]
+            double f[4] = {0, 0, 1, 0};
+            int k = 0;
+            for (char *s2 = NULL, *x = strtok_r(v, ":", &s2); x && !bad; x = strtok_r(NULL, ":", &s2))
+                bad = k < 4 ? imp_parse_prob(x, &f[k++]) : -1;
+            if (k < 2)
+                bad = -1;
+            c->ge = 1;
+            c->ge_p = f[0];
+            c->ge_r = f[1];
+            c->ge_loss_bad = f[2];
+            c->ge_loss_good = f[3];
+        }
+        else if (strcmp(kv, "delay") == 0)
+            bad = imp_parse_us(v, &c->delay_us);
+        else if (strcmp(kv, "jitter") == 0)
+            bad = imp_parse_us(v, &c->jitter_us);
+        else if (strcmp(kv, "reorder") == 0)
+            bad = imp_parse_prob(v, &c->reorder);
+        else if (strcmp(kv, "gap") == 0)
+            bad = imp_parse_us(v, &c->gap_us);
+        else if (strcmp(kv, "dup") == 0)
+            bad = imp_parse_prob(v, &c->dup);
+        else if (strcmp(kv, "corrupt") == 0)
+            bad = imp_parse_prob(v, &c->corrupt);
+        else if (strcmp(kv, "seed") == 0)
+            c->seed = strtoull(v, NULL, 10);
+        else
+            bad = -1;
+
+        if (bad)
+            return -1;
+    }
+    return 0;
+}
+
+// ------------------------------ 난수 ------------------------------
+// splitmix64: 시드 하나로 재현 가능한 수열
+static inline uint64_t imp_next(Impair *im)
+{
+    uint64_t z = (im->rng += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// [0, 1) 균등 분포
+static inline double imp_uniform(Impair *im)
+{
+    return (imp_next(im) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static inline int imp_chance(Impair *im, double p)
+{
+    return p > 0 && imp_uniform(im) < p;
+}
+
+// ------------------------------ 엔진 ------------------------------
+static inline void imp_init(Impair *im, const ImpairCfg *cfg)
+{
+    memset(im, 0, sizeof(*im));
+    im->cfg = *cfg;
+    im->rng = cfg->seed;
+    im->cap = 64;
+    im->heap = malloc(sizeof(ImpPkt) * im->cap);
+    if (!im->heap)
+        die("malloc impair");
+}
+
+static inline void imp_free(Impair *im)
+{
+    for (int i = 0; i < im->n; i++)
+        free(im->heap[i].data);
+    free(im->heap);
+    im->heap = NULL;
+    im->n = im->cap = 0;
+}
+
+// 패킷 하나에 대해 손실 모델을 한 단계 진행. 잃으면 1
+static inline int imp_lost(Impair *im)
+{
+    if (im->cfg.ge)
+    {
+        // 상태 전이 후 현재 상태의 손실률 적용
+        if (im->bad ? imp_chance(im, im->cfg.ge_r) : imp_chance(im, im->cfg.ge_p))
+            im->bad = !im->bad;
+        if (imp_chance(im, im->bad ? im->cfg.ge_loss_bad : im->cfg.ge_loss_good))
+        {
+            if (im->bad)
+                im->dropped_bad++;
+            return 1;
+        }
+    }
+    return imp_chance(im, im->cfg.loss);
+}
+
+// 이번 패킷에 줄 지연 (고정 지연 + 지터 + 재정렬)
+static inline uint64_t imp_delay(Impair *im)
+{
+    int64_t d = im->cfg.delay_us;
+    if (im->cfg.jitter_us)
+        d += (int64_t)(imp_next(im) % (2 * im->cfg.jitter_us + 1)) - (int64_t)im->cfg.jitter_us;
+    if (imp_chance(im, im->cfg.reorder))
+    {
+        d += im->cfg.gap_us;
+        im->reordered++;
+    }
+    return d > 0 ? (uint64_t)d : 0;
+}
+
+static inline int imp_before(const ImpPkt *a, const ImpPkt *b)
+{
+    return a->t < b->t || (a->t == b->t && a->id < b->id);
+}
+
+// 데이터그램 복사본을 전달 시각 t 로 큐에 넣는다. flip 이 0 이상이면 복사본의 그 비트를 뒤집음
+static inline void imp_push(Impair *im, uint64_t t, const uint8_t *buf, int n,
+                            const struct sockaddr_in *from, long flip)
+{
+    if (im->n == im->cap)
+    {
+        im->cap *= 2;
+        ImpPkt *h = realloc(im->heap, sizeof(ImpPkt) * im->cap);
+        if (!h)
+            die("realloc impair");
+        im->heap = h;
+    }
+
+    ImpPkt p;
+    p.t = t;
+    p.id = im->next_id++;
+    p.from = *from;
+    p.n = n;
+    p.data = malloc(n);
+    if (!p.data)
+        die("malloc impair pkt");
+    memcpy(p.data, buf, n);
+    if (flip >= 0)
+        p.data[flip / 8] ^= 1 << (flip % 8);
+
+    // sift-up
+    int i = im->n++;
+    while (i > 0)
+    {
+        int parent = (i - 1) / 2;
+        if (!imp_before(&p, &im->heap[parent]))
+            break;
+        im->heap[i] = im->heap[parent];
+        i = parent;
+    }
+    im->heap[i] = p;
+    im->delayed++;
+}
+
+// 도착한 데이터그램 하나를 통과시킨다.
+// 지금 바로 처리해야 하면 1, 버렸거나 지연 큐에 넣었으면 0 (중복본은 항상 큐로 감)
+static inline int imp_admit(Impair *im, const uint8_t *buf, int n,
+                            const struct sockaddr_in *from, uint64_t now)
+{
+    im->seen++;
+    if (imp_lost(im))
+    {
+        im->dropped++;
+        return 0;
+    }
+
+    if (imp_chance(im, im->cfg.dup))
+    {
+        im->duplicated++;
+        imp_push(im, now + imp_delay(im), buf, n, from, -1);
+    }
+
+    // 손상: 헤더는 두고 페이로드의 비트 하나 (손상된 사본은 지연 0 이라도 큐를 거쳐 전달)
+    long flip = -1;
+    if (n > SEG_HDR_LEN && imp_chance(im, im->cfg.corrupt))
+    {
+        flip = SEG_HDR_LEN * 8 + (long)(imp_next(im) % ((uint64_t)(n - SEG_HDR_LEN) * 8));
+        im->corrupted++;
+    }
+
+    uint64_t d = imp_delay(im);
+    if (d == 0 && im->n == 0 && flip < 0)
+        return 1;
+    // 앞서 지연된 패킷이 있으면 지연 0 이라도 큐를 거쳐 (전달 시각, 도착 순서)를 지킴
+    imp_push(im, now + d, buf, n, from, flip);
+    return 0;
+}
+
+// 가장 이른 전달 시각, 큐가 비면 0
+static inline uint64_t imp_next_due(const Impair *im)
+{
+    return im->n ? im->heap[0].t : 0;
+}
+
+// 전달 시각이 된 데이터그램 하나를 꺼낸다. 없으면 0. 꺼낸 out->data 는 호출한 쪽에서 free
+static inline int imp_pop(Impair *im, uint64_t now, ImpPkt *out)
+{
+    if (im->n == 0 || im->heap[0].t > now)
+        return 0;
+
+    *out = im->heap[0];
+    ImpPkt last = im->heap[--im->n];
+
+    // sift-down
+    int i = 0;
+    while (1)
+    {
+        int c = 2 * i + 1;
+        if (c >= im->n)
+            break;
+        if (c + 1 < im->n && imp_before(&im->heap[c + 1], &im->heap[c]))
+            c++;
+        if (!imp_before(&im->heap[c], &last))
+            break;
+        im->heap[i] = im->heap[c];
+        i = c;
+    }
+    if (im->n > 0)
+        im->heap[i] = last;
+    return 1;
+}
+
+static inline void imp_report(const Impair *im)
+{
+    printf("  impair: seen %llu, dropped %llu (burst %llu), duplicated %llu, reordered %llu, delayed %llu, corrupted %llu, seed %llu\n",
+           (unsigned long long)im->seen, (unsigned long long)im->dropped,
+           (unsigned long long)im->dropped_bad, (unsigned long long)im->duplicated,
+           (unsigned long long)im->reordered, (unsigned long long)im->delayed,
+           (unsigned long long)im->corrupted, (unsigned long long)im->cfg.seed);
+}
+
+#endif
@@ -0,0 +1,153 @@
+// pacer.h - 송신 페이싱: 윈도우를 한꺼번에 쏟지 않고 RTT 에 걸쳐 고르게 나눠 보냄
+// 속도 = 이득 * cwnd / SRTT. 이득은 느린시작 2, 혼잡회피 1.2 (Linux 의 tcp_pacing_ss/ca_ratio 와 같음).
+// 알고리즘이 직접 속도를 내면(bbr 의 pacing_rate) 그것을 쓴다. RTT 표본이 없으면 페이싱하지 않는다.
+// 세그먼트마다 출발 예정 시각(EDT)을 두고, 보낼 때마다 다음 시각을 len / 속도 만큼 뒤로 민다.
+// 쉬었다가 다시 보낼 때 밀린 시간을 한꺼번에 쓰지 않도록 적립은 PACE_BURST 세그먼트 분량까지만.
+//   PACE_TIMER: 사용자 공간에서 출발 시각까지 기다림 (이벤트 루프는 timerfd, 라운드 방식은 clock_nanosleep)
+//   PACE_FQ   : 속도를 SO_MAX_PACING_RATE 로 커널에 알리고 바로 보냄. 실제 간격은 fq qdisc 가 둔다
+//               (tc qdisc add dev <if> root fq). fq 가 없는 장치(기본 loopback 등)에서는 효과 없음
+#ifndef PACER_H
+#define PACER_H
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/socket.h>
+
+#include "cc.h"
+#include "common.h"
+
+#ifndef SO_MAX_PACING_RATE
+#define SO_MAX_PACING_RATE 47
+#endif
+
+#define PACE_SS_GAIN 2.0
+#define PACE_CA_GAIN 1.2
+#define PACE_BURST 4      // 밀린 시간으로 한 번에 몰아 보낼 수 있는 최대 세그먼트 수
+#define PACE_SLACK_US 20  // 출발 시각까지 이보다 적게 남았으면 기다리지 않고 보냄 (타이머 오차)
+
+enum
+{
+    PACE_OFF,
+    PACE_TIMER,
+    PACE_FQ
+};
+
+typedef struct
+{
+    int mode;
+    double rate;      // 바이트/us, 0 이면 제한 없음
+    uint64_t next_at; // 다음 세그먼트의 출발 예정 시각 (us)
+    uint64_t fq_rate; // 마지막으로 커널에 알린 속도 (바이트/s)
+
+    uint64_t waits;    // 출발 시각을 기다린 횟수
+    uint64_t wait_us;  // 기다린 시간 합
+    double rate_sum;   // 평균 속도 계산용 (세그먼트마다 더함)
+    uint64_t paced;    // 속도가 정해진 상태에서 보낸 세그먼트 수
+    uint64_t setsockopts;
+} Pacer;
+
+static inline const char *pace_name(int mode)
+{
+    return mode == PACE_TIMER ? "timer" : mode == PACE_FQ ? "fq" : "off";
+}
+
+static inline int pace_parse(const char *s)
+{
+    if (strcmp(s, "timer") == 0)
+        return PACE_TIMER;
+    if (strcmp(s, "fq") == 0)
+        return PACE_FQ;
+    if (strcmp(s, "off") == 0)
+        return PACE_OFF;
+    return -1;
+}
+
+static inline void pace_init(Pacer *p, int mode)
+{
+    memset(p, 0, sizeof(*p));
+    p->mode = mode;
+}
+
+// cwnd 와 SRTT(us) 로 속도 갱신 (ACK 처리 뒤에 호출)
+static inline void pace_update(Pacer *p, const Cc *cc, uint64_t srtt)
+{
+    if (p->mode == PACE_OFF)
+        return;
+    if (cc->pacing_rate > 0)
+        p->rate = cc->pacing_rate;
+    else if (srtt)
+        p->rate = (cc->cwnd < cc->ssthresh ? PACE_SS_GAIN : PACE_CA_GAIN) * cc->cwnd / srtt;
+    else
+        p->rate = 0;
+}
+
+// 지금 보내도 되면 0, 아니면 출발 시각까지 남은 us. PACE_FQ 는 커널이 간격을 두므로 항상 0
+static inline uint64_t pace_delay(const Pacer *p, uint64_t now)
+{
+    if (p->mode != PACE_TIMER || p->rate <= 0 || p->next_at <= now + PACE_SLACK_US)
+        return 0;
+    return p->next_at - now;
+}
+
+// 세그먼트 하나를 now 에 보냈음: 다음 출발 시각을 len / 속도 만큼 뒤로
+static inline void pace_sent(Pacer *p, uint32_t len, uint64_t now)
+{
+    if (p->mode == PACE_OFF || p->rate <= 0)
+        return;
+    double gap = len / p->rate;
+    uint64_t floor = now > (uint64_t)(PACE_BURST * gap) ? now - (uint64_t)(PACE_BURST * gap) : 0;
+    if (p->next_at < floor)
+        p->next_at = floor; // 쉬는 동안 쌓인 여유는 PACE_BURST 분량까지만
+    p->next_at += (uint64_t)gap;
+    p->rate_sum += p->rate;
+    p->paced++;
+}
+
+// PACE_FQ: 속도가 1/8 이상 바뀌었을 때만 SO_MAX_PACING_RATE 다시 설정
+static inline void pace_apply_fq(Pacer *p, int fd)
+{
+    if (p->mode != PACE_FQ || p->rate <= 0 || fd < 0)
+        return;
+    uint64_t r = (uint64_t)(p->rate * 1e6);
+    uint64_t d = r > p->fq_rate ? r - p->fq_rate : p->fq_rate - r;
+    if (p->fq_rate && d < p->fq_rate / 8)
+        return;
+    // 커널 인터페이스는 unsigned int(바이트/s) 또는 64비트. 32비트 범위면 int 크기로 넘김
+    if (r > UINT32_MAX)
+    {
+        if (setsockopt(fd, SOL_SOCKET, SO_MAX_PACING_RATE, &r, sizeof(r)) < 0)
+            die("setsockopt SO_MAX_PACING_RATE");
+    }
+    else
+    {
+        uint32_t r32 = (uint32_t)r;
+        if (setsockopt(fd, SOL_SOCKET, SO_MAX_PACING_RATE, &r32, sizeof(r32)) < 0)
+            die("setsockopt SO_MAX_PACING_RATE");
+    }
+    p->fq_rate = r;
+    p->setsockopts++;
+}
+
+// PACE_TIMER 라운드 방식: 출발 시각까지 고해상도 타이머로 잠듦
+static inline void pace_sleep(Pacer *p)
+{
+    uint64_t now = now_us();
+    uint64_t d = pace_delay(p, now);
+    if (!d)
+        return;
+    struct timespec ts = {(time_t)(p->next_at / 1000000), (long)(p->next_at % 1000000) * 1000};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+        ;
+    p->waits++;
+    p->wait_us += d;
+}
+
+// 평균 속도 (Mbit/s)
+static inline double pace_avg_mbps(const Pacer *p)
+{
+    return p->paced ? p->rate_sum / p->paced * 8 : 0;
+}
+
+#endif
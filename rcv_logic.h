@@ -0,0 +1,142 @@
+// rcv_logic.h - 시나리오별 수신측 처리 로직
+// 실제 receiver 와 sender 의 시뮬레이션 모드(-s)가 같은 로직을 공유한다.
+#ifndef RCV_LOGIC_H
+#define RCV_LOGIC_H
+
+#include "common.h"
+#include "reorder.h"
+
+typedef struct
+{
+    int64_t next_expected;
+    int dup_drop_count;     // dup3 모드에서 손실/중복 처리용
+    int timeout_drop_count; // timeout 모드에서 손실 처리용
+    Reorder ro;             // bulk 모드: 순서 밖 세그먼트 재정렬 버퍼
+    int quiet;              // 1 이면 처리 과정 출력 생략 (sender -s -q)
+} RcvState;
+
+#define rcv_say(r, ...)          \
+    do                           \
+    {                            \
+        if (!(r)->quiet)         \
+            printf(__VA_ARGS__); \
+    } while (0)
+
+// ro_cap: bulk 모드 재정렬 버퍼 용량 (블록 수, 0 이면 RO_DEFAULT_CAP)
+static inline void rcv_init(RcvState *r, Mode mode, uint32_t ro_cap)
+{
+    memset(r, 0, sizeof(*r));
+    if (mode == MODE_BULK)
+        ro_init(&r->ro, ro_cap ? ro_cap : RO_DEFAULT_CAP);
+}
+
+static inline void rcv_free(RcvState *r)
+{
+    if (r->ro.bits)
+        ro_free(&r->ro);
+}
+
+// DATA 세그먼트 하나를 처리한다.
+// ACK 를 보내야 하면 *ack 에 값을 채우고 1, 손실로 가정해 ACK 를 보내지 않으면 0 을 반환
+static inline int rcv_on_data(RcvState *r, Mode mode, int64_t seq, int len, int64_t *ack)
+{
+    // ================= BULK 모드 =================
+    // 처리량 측정용: 출력 없이 누적 ACK. 순서 밖 세그먼트는 재정렬 버퍼에 보관하고
+    // 구멍이 채워지면 next_expected 를 한 번에 전진 (SACK 블록은 ro_sack 으로 조회)
+    if (mode == MODE_BULK)
+    {
+        r->next_expected = ro_insert(&r->ro, seq, len);
+        *ack = r->next_expected;
+        return 1;
+    }
+
+    // ================= NORMAL 모드 =================
+    if (mode == MODE_NORMAL)
+    {
+        if (seq == r->next_expected)
+        {
+            r->next_expected += len;
+        }
+        else
+        {
+            rcv_say(r, YELLOW "[RCV] out-of-order (next_expected=%lld) → 누적 ACK만 보냄\n" RESET,
+                       (long long)r->next_expected);
+        }
+
+        *ack = r->next_expected;
+        rcv_say(r, GREEN "[RCV] ACK 송신   ▶▶▶   ACK %lld (누적)\n" RESET, (long long)*ack);
+        return 1;
+    }
+
+    // ================= 3 DUP ACK 모드 =================
+    if (mode == MODE_DUP3)
+    {
+        // 시나리오:
+        //  - seq=1500: 정상 수신 → ACK=3000
+        //  - seq=3000,4500,6000: 손실/순서오류 → 계속 ACK 3000 (dup 3회)
+        //  - 마지막 재전송된 패킷: 손실 구간 복구 완료 → ACK=7500
+        if (seq == 1500 && r->dup_drop_count == 0)
+        {
+            r->next_expected = 3000;
+            *ack = r->next_expected;
+            rcv_say(r, GREEN "[RCV] 첫 패킷 정상 수신 → ACK %lld 송신\n" RESET, (long long)*ack);
+        }
+        else if (r->dup_drop_count < 3 &&
+                 (seq == 3000 || seq == 4500 || seq == 6000))
+        {
+            r->dup_drop_count++;
+            *ack = 3000;
+            rcv_say(r, YELLOW "[RCV] 손실/순서 오류 가정 → 중복 ACK %lld (dup=%d)\n" RESET,
+                       (long long)*ack, r->dup_drop_count);
+        }
+        else
+        {
+            // 재전송된 패킷 도착 → 손실 구간 복구 완료라고 가정
+            r->next_expected = 7500;
+            *ack = r->next_expected;
+            rcv_say(r, GREEN "[RCV] 재전송 패킷 수신 → 손실 구간 복구 → ACK %lld 송신\n" RESET,
+                       (long long)*ack);
+        }
+        return 1;
+    }
+
+    // ================= TIMEOUT 모드 =================
+    // 시나리오:
+    //  - seq=0: 정상 수신 → ACK=1500
+    //  - seq=1500,3000,4500,6000: 손실로 가정 → ACK 안 보냄
+    //  - 이후(회복 구간): 정상 수신 → 누적 ACK 동작
+    if (seq == 0)
+    {
+        r->next_expected = MSS;
+        *ack = r->next_expected;
+        rcv_say(r, GREEN "[RCV] 첫 패킷 정상 수신 → ACK %lld 송신\n" RESET, (long long)*ack);
+        return 1;
+    }
+    if (r->timeout_drop_count < 4 &&
+        (seq == 1500 || seq == 3000 || seq == 4500 || seq == 6000))
+    {
+        r->timeout_drop_count++;
+        rcv_say(r, RED "[RCV] 손실로 가정 → ACK 전송 안 함 (drop #%d)\n" RESET,
+                   r->timeout_drop_count);
+        return 0; // 아무 것도 안 보냄
+    }
+
+    // 회복 구간: 정상 누적 ACK
+    if (seq == r->next_expected)
+    {
+        r->next_expected += len;
+        rcv_say(r, GREEN "[RCV] in-order 수신 → next_expected=%lld\n" RESET,
+                   (long long)r->next_expected);
+    }
+    else if (seq > r->next_expected)
+    {
+        rcv_say(r, YELLOW "[RCV] out-of-order (next_expected=%lld) → 기존 ACK 유지\n" RESET,
+                   (long long)r->next_expected);
+    }
+
+    *ack = r->next_expected;
+    rcv_say(r, GREEN "[RCV] 회복 구간 ACK 송신   ▶▶▶   ACK %lld\n" RESET, (long long)*ack);
+    return 1;
+}
+
+#endif
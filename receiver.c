@@ -1,7 +1,36 @@
 // receiver.c - TCP 혼잡제어 수신자
 // 실행 방법:
-//   ./receiver <listen_port> <normal|dup3|timeout>
+//   ./receiver [-b] [-n flows] [-i idle_sec] <listen_port> <normal|dup3|timeout|bulk>
+//   송신측마다 (주소, 헤더의 conn id) 로 플로우 상태를 따로 두므로 여러 sender 가 동시에 보낼 수 있다.
+//   -n: 플로우 END 를 이만큼 받으면 종료 (기본 1, 0 이면 계속 실행)
+//   -i: 이 시간(초) 동안 세그먼트가 없던 플로우는 정리 (기본 10초)
+//   -b: recvmmsg 로 대기 중인 DATA 를 한꺼번에 받고 ACK 는 sendmmsg 로 모아 보냄
+//   -I: bulk 모드에서 도착한 DATA 에 손실/지연/재정렬/중복을 가함 (impair.h 설정 문자열)
+//       예) -I loss=0.01,delay=5ms,jitter=1ms,seed=7   -I ge=0.01:0.3,reorder=0.02
+//   -w: bulk 모드에서 워커 스레드 N 개로 수신. 워커마다 SO_REUSEPORT 소켓을 같은 포트에 bind 하고
+//       코어 하나에 고정되며, 커널이 4-tuple 해시로 나눠 준 플로우의 상태만 소유한다 (공유 락 없음)
+//   -M: UDP 대신 공유 메모리 세그먼트를 만들고 그 안의 SPSC 링으로 sender -M 과 통신 (transport.h)
+//       포트 인자 없이 ./receiver -M <name> <mode>. sender 는 하나씩, -b/-w/-I 와는 함께 못 씀
+//   -y: -M 에서 DATA 를 기다릴 때 잠들지 않고 busy-poll
+//   -d: bulk 모드 지연 ACK (RFC 1122). 순서대로 온 full 세그먼트는 두 개마다 한 번, 늦어도 이 시간
+//       (예: 1ms, 500us) 안에 ACK. 순서 밖/중복/구멍을 채운 세그먼트와 짧은 세그먼트는 바로 ACK.
+//       sender 의 RTO 하한(2ms)보다 길면 마지막 세그먼트의 ACK 를 기다리다 타임아웃이 날 수 있다
+//   -k: ACK 솎아내기 비율. 순서대로 온 full 세그먼트 N 개마다 ACK 하나 (-d 없이 쓰면 타이머 1ms)
+//   -F: bulk 모드에서 받은 데이터를 파일로 저장 (sender -F). 재정렬 버퍼에 받아들인 세그먼트는
+//       순서와 상관없이 pwrite 로 바이트 오프셋에 바로 쓰고, END 의 크기/해시로 결과를 확인.
+//       -n 1 이 아니거나 -w 면 플로우마다 <file>.<conn> 에 씀
+//   -B: 경로의 대역폭-지연 곱 ("<rate bit/s>:<rtt ms>" 예 10g:80, 또는 바이트 수 예 100m).
+//       재정렬 버퍼 용량(기본 4096 세그먼트)과 소켓 수신 버퍼를 BDP 의 두 배로 잡는다 (sender -B 와 같은 값)
+//   -g: UDP_GRO 로 커널이 합친 DATA 묶음(sender -g 의 GSO 슈퍼 데이터그램 등)을 한 번에 받고, cmsg 의
+//       세그먼트 크기로 다시 나눠 세그먼트마다 재정렬/ACK 를 처리. 한 묶음의 ACK 는 sendmmsg 로 모아 보냄
+//   -u: bulk 모드에서 io_uring 으로 수신 (uring.h). multishot recvmsg 가 등록한 provided buffer 링에
+//       데이터그램을 받고, ACK 는 SENDMSG SQE 로 쌓았다가 다음 대기 때 io_uring_enter 한 번으로 제출
+//   -U: -u 에 SQPOLL 을 더함. 커널 스레드가 SQ 를 가져가므로 ACK 제출에 syscall 이 없음
+//   -j: bulk 종료 시 수신 결과를 JSON 한 줄로 출력 (bench.c 가 packets/s, 패킷당 CPU 비교에 사용)
+//   CRC32C 가 실린 DATA(sender -K)는 재정렬 버퍼와 next_expected 에 반영하기 전에 확인하고,
+//   맞지 않으면 ACK 없이 버린다 (손실과 같게 복구됨)
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,38 +38,21 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 
-// 기본 설정
-#define MSS 1500 // 초기 임계치
-#define BUF 256
-#define SLEEP_US 1500000
-
-// 컬러 코드
-#define RESET "\033[0m"
-#define RED "\033[31m"
-#define GREEN "\033[32m"
-#define YELLOW "\033[33m"
-#define BLUE "\033[34m"
-#define MAGENTA "\033[35m"
-#define CYAN "\033[36m"
-#define WHITE "\033[37m"
-#define BOLDRED "\033[1;31m"
-#define BOLDYEL "\033[1;33m"
-#define BOLDMAG "\033[1;35m"
-#define BOLDCYN "\033[1;36m"
-
-typedef enum
-{
-    MODE_NORMAL,
-    MODE_DUP3,
-    MODE_TIMEOUT
-} Mode;
-
-void die(const char *msg)
-{
-    perror(msg);
-    exit(1);
-}
+#include "batch_io.h"
+#include "common.h"
+#include "evloop.h"
+#include "fileio.h"
+#include "flow.h"
+#include "impair.h"
+#include "rcv_logic.h"
+#include "segment.h"
+#include "transport.h"
+#include "uring.h"
 
 Mode parse_mode(const char *s)
 {
@@ -50,196 +62,1097 @@ Mode parse_mode(const char *s)
         return MODE_DUP3;
     if (strcmp(s, "timeout") == 0)
         return MODE_TIMEOUT;
-    fprintf(stderr, "unknown mode: %s (use normal|dup3|timeout)\n", s);
+    if (strcmp(s, "bulk") == 0)
+        return MODE_BULK;
+    fprintf(stderr, "unknown mode: %s (use normal|dup3|timeout|bulk)\n", s);
     exit(1);
 }
 
-int main(int argc, char **argv)
+#define FLOW_IDLE_US 10000000 // 기본 idle 플로우 정리 기준
+#define FLOW_SWEEP_US 1000000 // idle 검사 주기
+#define WORKER_POLL_US 100000 // 워커가 종료 플래그를 확인하는 주기 (수신 대기 timeout)
+#define DACK_US 1000          // -k 만 주었을 때의 지연 ACK 타이머 (sender 의 RTO 하한 2ms 보다 짧게)
+#define DACK_QUICK 16         // 플로우의 처음 이만큼은 바로 ACK (느린시작 초반에 타이머를 기다리지 않게)
+
+// bulk 소켓 수신 버퍼 (-B 가 더 크면 2 * BDP)
+#define RCV_SOCKBUF (4 * 1024 * 1024)
+
+// -w: 워커들이 함께 보는 종료 조건. END 를 받을 때만 갱신하므로 데이터 경로에는 공유 쓰기가 없다
+typedef struct
+{
+    atomic_uint_fast64_t flows_done;
+    atomic_int stop;
+    uint64_t max_flows; // 0 이면 계속
+} Shared;
+
+typedef struct
+{
+    Mode mode;
+    FlowTable flows;     // (송신 주소, conn) 별 수신 상태
+    uint64_t idle_us;    // -i
+    uint64_t last_sweep;
+    uint64_t max_flows;  // -n: 이만큼 끝나면 종료 (0 이면 계속)
+    uint64_t flows_done; // END 로 끝난 플로우 수
+
+    // bulk 모드 전체 통계
+    uint64_t rx_pkts, rx_bytes, delivered, t_first;
+    uint64_t syscalls;
+
+    // 지연 ACK: dack_ratio 개마다 ACK, 늦어도 dack_us 안에 (dack_ratio 가 1 이면 꺼짐)
+    int dack_ratio;
+    uint64_t dack_us;
+    uint64_t dack_next; // 미뤄 둔 ACK 중 가장 이른 마감 시각 (0 이면 없음)
+    int timed;          // 소켓과 함께 ev 의 타이머를 기다림 (손상 엔진 또는 UDP 지연 ACK)
+    uint64_t acks, acks_delayed, acks_timer;
+
+    // -I: 손상 엔진과 지연 큐를 깨울 타이머 (없으면 NULL)
+    Impair *imp;
+    EvLoop ev;
+
+    Shared *shared; // 워커 모드일 때만, 단일 스레드면 NULL
+
+    const char *out_path; // -F: 받은 데이터를 저장할 파일 (NULL 이면 버림)
+    uint64_t file_writes, files_ok, files_bad;
+    uint64_t csum_checked, csum_bad; // CRC32C 를 확인한 / 맞지 않아 버린 DATA 수
+    int gro;                         // -g: 소켓에 UDP_GRO 가 켜져 있음
+    uint64_t gro_bursts, gro_segs;   // 합쳐져 도착한 묶음 수와 그 안의 세그먼트 수
+    int uring;                       // -u: 1, -U: 2 (SQPOLL)
+    Uring *ur;                       // loop_uring 이 도는 동안의 링 (ACK 를 SQE 로)
+    UrStats ur_st;
+} Receiver;
+
+static int json_out; // -j
+
+static void rv_init(Receiver *rv, Mode mode, uint64_t idle_us, uint64_t max_flows)
+{
+    memset(rv, 0, sizeof(*rv));
+    rv->mode = mode;
+    ft_init(&rv->flows);
+    rv->idle_us = idle_us;
+    rv->max_flows = max_flows;
+    rv->last_sweep = now_us();
+    rv->dack_ratio = 1;
+}
+
+// 다른 워커가 종료 조건을 채웠는지
+static int stopped(const Receiver *rv)
+{
+    return rv->shared && atomic_load_explicit(&rv->shared->stop, memory_order_relaxed);
+}
+
+// 플로우 하나가 끝남. 전체 종료 조건을 채웠으면 1
+static int flow_ended(Receiver *rv)
 {
-    if (argc < 3)
+    rv->flows_done++;
+    if (!rv->shared)
+        return rv->max_flows && rv->flows_done >= rv->max_flows;
+
+    uint64_t done = atomic_fetch_add(&rv->shared->flows_done, 1) + 1;
+    if (rv->shared->max_flows && done >= rv->shared->max_flows)
     {
-        fprintf(stderr, "usage: %s <listen_port> <normal|dup3|timeout>\n", argv[0]);
+        atomic_store(&rv->shared->stop, 1);
         return 1;
     }
+    return 0;
+}
 
-    int port = atoi(argv[1]);
-    Mode mode = parse_mode(argv[2]);
-
-    int s = socket(AF_INET, SOCK_DGRAM, 0);
-    if (s < 0)
-        die("socket");
+static void flow_name(const Flow *f, char *buf, size_t cap)
+{
+    char ip[INET_ADDRSTRLEN];
+    struct in_addr a;
+    a.s_addr = f->key.ip;
+    inet_ntop(AF_INET, &a, ip, sizeof(ip));
+    snprintf(buf, cap, "%s:%u#%u", ip, ntohs(f->key.port), f->key.conn);
+}
 
-    struct sockaddr_in me;
-    memset(&me, 0, sizeof(me));
-    me.sin_family = AF_INET;
-    me.sin_addr.s_addr = htonl(INADDR_ANY);
-    me.sin_port = htons(port);
+// bulk 플로우 하나의 결과
+static void flow_report(const Flow *f, const char *why)
+{
+    char name[64];
+    flow_name(f, name, sizeof(name));
+    flockfile(stdout); // 워커 여럿이 동시에 출력해도 보고가 섞이지 않게
+    printf(BOLDMAG "[RCV] flow %s %s\n" RESET, name, why);
+    printf("  recv %llu pkts, %llu bytes on wire, delivered %lld bytes in order\n",
+           (unsigned long long)f->rx_pkts, (unsigned long long)f->rx_bytes, (long long)f->st.next_expected);
+    printf("  reorder: %u segs, buffered %llu out-of-order, %llu duplicate, %llu beyond window\n",
+           f->st.ro.cap, (unsigned long long)f->st.ro.buffered, (unsigned long long)f->st.ro.dups,
+           (unsigned long long)f->st.ro.out_of_window);
+    report_throughput("RCV", f->st.next_expected, f->rx_pkts, f->last_seen - f->t_first);
+    funlockfile(stdout);
+}
 
-    if (bind(s, (struct sockaddr *)&me, sizeof(me)) < 0)
-        die("bind");
+// -F: 플로우의 출력 파일 열기. 플로우가 하나뿐이면 경로 그대로, 아니면 conn 을 붙임
+static void sink_open(Receiver *rv, Flow *f)
+{
+    char path[512];
+    if (rv->max_flows == 1 && !rv->shared)
+        snprintf(path, sizeof(path), "%s", rv->out_path);
+    else
+        snprintf(path, sizeof(path), "%s.%u", rv->out_path, f->key.conn);
+    f->out_fd = fio_open_sink(path);
+}
 
-    printf(BOLDMAG "=== [RCV] Receiver 시작 (port=%d, mode=%s) ===\n" RESET,
-           port,
-           mode == MODE_NORMAL ? "normal" : mode == MODE_DUP3 ? "dup3"
-                                                              : "timeout");
+// END 를 받은 플로우의 파일 확인: 크기/해시가 송신측(END 에 실린 값)과 같은지
+static void sink_close(Receiver *rv, Flow *f, const SegHdr *end)
+{
+    if (f->out_fd < 0)
+        return;
+    if (end && (end->flags & SEG_F_FILE))
+    {
+        double sec = (f->last_seen - f->t_first) / 1e6;
+        int ok = (int64_t)end->seq == f->st.next_expected &&
+                 fio_verify(f->out_fd, (int64_t)end->seq, end->ack);
+        flockfile(stdout);
+        printf(BOLDMAG "[RCV] file: %lld bytes in %.3fs  %.1f MB/s  " RESET "%s\n",
+               (long long)f->st.next_expected, sec, sec > 0 ? f->st.next_expected / sec / 1e6 : 0.0,
+               ok ? GREEN "verify OK" RESET : RED "verify FAILED" RESET);
+        if (!ok)
+            printf(RED "  expected %llu bytes, hash %016llx\n" RESET,
+                   (unsigned long long)end->seq, (unsigned long long)end->ack);
+        funlockfile(stdout);
+        if (ok)
+            rv->files_ok++;
+        else
+            rv->files_bad++;
+    }
+    close(f->out_fd);
+    f->out_fd = -1;
+}
 
-    int next_expected = 0;
-    int dup_drop_count = 0;     // dup3 모드에서 손실/중복 처리용
-    int timeout_drop_count = 0; // timeout 모드에서 손실 처리용
+// 주기적으로 idle 플로우 정리
+static void sweep_idle(Receiver *rv, uint64_t now)
+{
+    if (now - rv->last_sweep < FLOW_SWEEP_US)
+        return;
+    rv->last_sweep = now;
+    for (uint32_t i = 0; i < rv->flows.cap; i++)
+    {
+        Flow *f = &rv->flows.slots[i];
+        if (f->used && now - f->last_seen >= rv->idle_us && rv->mode == MODE_BULK)
+        {
+            flow_report(f, "idle → 정리");
+            sink_close(rv, f, NULL);
+        }
+    }
+    ft_evict_idle(&rv->flows, now, rv->idle_us);
+}
 
-    while (1)
+// 데이터그램 하나 처리.
+// ACK 를 보내야 하면 *a 와 *fmt(응답 형식)를 채우고 1, 종료할 때가 되면 -1, 그 외 0 반환
+static int on_datagram(Receiver *rv, const uint8_t *buf, int n, const struct sockaddr_in *from,
+                       SegHdr *a, SegFmt *fmt)
+{
+    // 바이너리/텍스트 형식 자동 구분, 응답도 같은 형식으로 보냄
+    SegHdr h;
+    *fmt = seg_decode(buf, n, &h);
+    if (*fmt == SEG_FMT_INVALID || h.type == SEG_ACK)
     {
-        char buf[BUF];
-        struct sockaddr_in cli;
-        socklen_t clen = sizeof(cli);
+        printf(RED "[RCV] 알 수 없는 메시지 (%d bytes)\n" RESET, n);
+        return 0;
+    }
 
-        int n = recvfrom(s, buf, sizeof(buf) - 1, 0,
-                         (struct sockaddr *)&cli, &clen);
-        if (n < 0)
-            die("recvfrom");
-        buf[n] = 0;
+    uint64_t now = now_us();
+    sweep_idle(rv, now);
+    FlowKey key = flow_key(from, h.conn);
 
-        // 종료 메시지
-        if (strncmp(buf, "END", 3) == 0)
+    // 종료 메시지: 해당 플로우만 정리
+    if (h.type == SEG_END)
+    {
+        Flow *f = ft_find(&rv->flows, &key);
+        if (!f)
+            return 0; // 이미 정리된 플로우
+        if (rv->mode == MODE_BULK)
         {
-            printf(BOLDMAG "\n=== [RCV] END 수신 → 시나리오 종료 ===\n" RESET);
-            break;
+            flow_report(f, "END");
+            sink_close(rv, f, &h);
+            rv->delivered += f->st.next_expected;
         }
+        ft_remove(&rv->flows, f);
+        return flow_ended(rv) ? -1 : 0;
+    }
 
-        int seq = -1, len = -1;
-        if (sscanf(buf, "DATA seq=%d len=%d", &seq, &len) != 2)
+    // 헤더에 적힌 길이만큼 페이로드가 실제로 왔는지 확인
+    if (n - seg_payload_off(*fmt, buf, n) < h.len)
+    {
+        printf(RED "[RCV] 잘린 세그먼트 (seq=%llu len=%u, %d bytes)\n" RESET,
+               (unsigned long long)h.seq, h.len, n);
+        return 0;
+    }
+
+    // CRC32C 가 실려 있으면 플로우 상태를 건드리기 전에 확인. 손상된 세그먼트는 잃은 것으로 봄
+    if (*fmt == SEG_FMT_BIN && (h.flags & SEG_F_CRC))
+    {
+        rv->csum_checked++;
+        if (!seg_csum_ok(buf, h.len))
         {
-            printf(RED "[RCV] 알 수 없는 메시지: %s\n" RESET, buf);
-            continue;
+            rv->csum_bad++;
+            return 0;
         }
+    }
+
+    int64_t seq = (int64_t)h.seq;
+    int len = (int)h.len;
+    Flow *f = ft_get(&rv->flows, &key, rv->mode);
+    f->last_seen = now;
 
+    if (rv->mode == MODE_BULK)
+    {
+        if (f->rx_pkts++ == 0)
+        {
+            f->t_first = now;
+            if (rv->out_path)
+                sink_open(rv, f);
+        }
+        if (rv->rx_pkts++ == 0)
+            rv->t_first = now;
+        f->rx_bytes += n;
+        rv->rx_bytes += n;
+    }
+    else
+    {
         printf("\n" CYAN "--------------------------------------------------------\n" RESET);
         printf(BLUE "[RCV] DATA 수신   ◀◀◀   " RESET
-                    "seq=%d, len=%d\n",
-               seq, len);
+                    "seq=%lld, len=%d\n",
+               (long long)seq, len);
+    }
+
+    int64_t prev = f->st.next_expected;
+    uint64_t buffered = f->st.ro.buffered;
+    int64_t ack = 0;
+    if (!rcv_on_data(&f->st, rv->mode, seq, len, &ack))
+        return 0;
 
-        // ================= NORMAL 모드 =================
-        if (mode == MODE_NORMAL)
+    // -F: 재정렬 버퍼가 받아들인 세그먼트(next_expected 전진 또는 새로 보관)만 제자리에 씀.
+    // 중복과 윈도우 밖 세그먼트는 다시 쓰지 않는다
+    if (f->out_fd >= 0 && (ack > prev || f->st.ro.buffered > buffered))
+    {
+        fio_put(f->out_fd, h.seq, buf + seg_payload_off(*fmt, buf, n), len);
+        rv->file_writes++;
+    }
+
+    memset(a, 0, sizeof(*a));
+    a->type = SEG_ACK;
+    a->ack = ack;
+    a->tsval = (uint32_t)now;
+    a->tsecr = h.tsval; // RTT 측정을 위해 DATA 의 송신 시각을 되돌려 줌
+    a->conn = h.conn;
+    if (rv->mode == MODE_BULK)
+        a->nsack = ro_sack(&f->st.ro, a->sack, SEG_MAX_SACK);
+
+    if (rv->dack_ratio > 1)
+    {
+        // 순서대로 온 full 세그먼트이고 뒤에 남은 구멍이 없을 때만 미룸. 그 외(순서 밖, 중복,
+        // 구멍을 채워 ACK 가 뛴 경우, 짧은 세그먼트)는 중복 ACK 감지가 늦어지지 않게 바로 보냄
+        int plain = seq == prev && len == MSS && ack == prev + len && a->nsack == 0 &&
+                    f->rx_pkts > DACK_QUICK;
+        if (plain && f->dack_segs + 1 < (uint32_t)rv->dack_ratio)
         {
-            if (seq == next_expected)
+            if (f->dack_segs == 0)
             {
-                next_expected += len;
+                f->dack_tsecr = h.tsval;
+                f->dack_due = now + rv->dack_us;
+                if (!rv->dack_next || f->dack_due < rv->dack_next)
+                    rv->dack_next = f->dack_due;
             }
-            else
-            {
-                printf(YELLOW "[RCV] out-of-order (next_expected=%d) → 누적 ACK만 보냄\n" RESET,
-                       next_expected);
-            }
-
-            int ack = next_expected;
-            printf(GREEN "[RCV] ACK 송신   ▶▶▶   ACK %d (누적)\n" RESET, ack);
+            f->dack = *a;
+            f->dack.tsecr = f->dack_tsecr;
+            f->dack_fmt = *fmt;
+            f->dack_segs++;
+            rv->acks_delayed++;
+            return 0;
+        }
+        // 이번 ACK 가 미뤄 둔 것까지 누적으로 확인
+        if (f->dack_segs)
+        {
+            a->tsecr = f->dack_tsecr;
+            f->dack_segs = 0;
+        }
+    }
+    return 1;
+}
 
-            char ackbuf[BUF];
-            int m = snprintf(ackbuf, sizeof(ackbuf), "ACK %d", ack);
-            sendto(s, ackbuf, m, 0, (struct sockaddr *)&cli, clen);
+// ACK 하나를 바로 보내거나(tx == NULL) 배치에 넣는다. io_uring 루프에서는 SQE 로 쌓음
+static void reply(Receiver *rv, Transport *tp, TxBatch *tx, const SegHdr *a, SegFmt fmt,
+                  const struct sockaddr_in *to)
+{
+    rv->acks++;
+    uint8_t *slot = rv->ur ? ur_ack_buf(rv->ur) : NULL;
+    if (slot)
+    {
+        ur_ack_commit(rv->ur, to, seg_encode_fmt(fmt, a, slot, IO_HDR_MAX));
+        return;
+    }
+    if (rv->ur)
+        rv->ur->st.acks_sync++; // 완료되지 않은 송신이 슬롯을 모두 차지함
+    if (tx)
+    {
+        if (txb_full(tx))
+            txb_flush(tp->fd, tx, &rv->syscalls);
+        int m = seg_encode_fmt(fmt, a, txb_hdr(tx), IO_HDR_MAX);
+        txb_commit(tx, to, m, NULL, 0);
+        return;
+    }
+    uint8_t ackbuf[BUF];
+    int m = seg_encode_fmt(fmt, a, ackbuf, sizeof(ackbuf));
+    tp_sendv(tp, to, ackbuf, m, NULL, 0);
+}
 
-            usleep(SLEEP_US);
+// 마감 시각이 지난 지연 ACK 를 보내고 다음 마감 시각을 다시 구한다
+static void dack_flush(Receiver *rv, Transport *tp, TxBatch *tx)
+{
+    if (!rv->dack_next)
+        return;
+    uint64_t now = now_us();
+    if (now < rv->dack_next)
+        return;
+    uint64_t next = 0;
+    for (uint32_t i = 0; i < rv->flows.cap; i++)
+    {
+        Flow *f = &rv->flows.slots[i];
+        if (!f->used || !f->dack_segs)
+            continue;
+        if (f->dack_due <= now)
+        {
+            struct sockaddr_in to;
+            memset(&to, 0, sizeof(to));
+            to.sin_family = AF_INET;
+            to.sin_addr.s_addr = f->key.ip;
+            to.sin_port = f->key.port;
+            f->dack_segs = 0;
+            rv->acks_timer++;
+            reply(rv, tp, tx, &f->dack, f->dack_fmt, &to);
         }
+        else if (!next || f->dack_due < next)
+            next = f->dack_due;
+    }
+    rv->dack_next = next;
+}
 
-        // ================= 3 DUP ACK 모드 =================
-        else if (mode == MODE_DUP3)
-        {
-            char ackbuf[BUF];
-            int ack = 0;
+// 데이터그램 하나를 처리하고 필요하면 ACK 전송. END 면 -1
+static int handle(Receiver *rv, Transport *tp, TxBatch *tx, const uint8_t *buf, int n,
+                  const struct sockaddr_in *from)
+{
+    SegHdr a;
+    SegFmt fmt;
+    int r = on_datagram(rv, buf, n, from, &a, &fmt);
+    if (r > 0)
+        reply(rv, tp, tx, &a, fmt, from);
+    return r;
+}
 
-            // 시나리오:
-            //  - seq=1500: 정상 수신 → ACK=3000
-            //  - seq=3000,4500,6000: 손실/순서오류 → 계속 ACK 3000 (dup 3회)
-            //  - 마지막 재전송된 패킷: 손실 구간 복구 완료 → ACK=7500
-            if (seq == 1500 && dup_drop_count == 0)
-            {
-                next_expected = 3000;
-                ack = next_expected;
-                printf(GREEN "[RCV] 첫 패킷 정상 수신 → ACK %d 송신\n" RESET, ack);
+// 도착한 데이터그램을 손상 단계에 통과시킨 뒤 처리. DATA 만 손상시키고 END 등은 그대로 처리
+static int ingress(Receiver *rv, Transport *tp, TxBatch *tx, const uint8_t *buf, int n,
+                   const struct sockaddr_in *from)
+{
+    SegHdr h;
+    if (rv->imp && seg_decode(buf, n, &h) != SEG_FMT_INVALID && h.type == SEG_DATA &&
+        !imp_admit(rv->imp, buf, n, from, now_us()))
+        return 0;
+    return handle(rv, tp, tx, buf, n, from);
+}
 
-                int m = snprintf(ackbuf, sizeof(ackbuf), "ACK %d", ack);
-                sendto(s, ackbuf, m, 0, (struct sockaddr *)&cli, clen);
-            }
-            else if (dup_drop_count < 3 &&
-                     (seq == 3000 || seq == 4500 || seq == 6000))
-            {
-                dup_drop_count++;
-                ack = 3000;
-                printf(YELLOW "[RCV] 손실/순서 오류 가정 → 중복 ACK %d (dup=%d)\n" RESET,
-                       ack, dup_drop_count);
+// GRO 로 합쳐진 묶음을 세그먼트 크기 seg 로 나눠 하나씩 통과시킴 (seg 가 0 이면 데이터그램 하나).
+// 세그먼트마다 자기 헤더를 달고 있으므로 따로 온 것과 똑같이 처리된다. END 면 -1
+static int ingress_gro(Receiver *rv, Transport *tp, TxBatch *tx, const uint8_t *buf, int n, int seg,
+                       const struct sockaddr_in *from)
+{
+    if (seg <= 0 || seg >= n)
+        return ingress(rv, tp, tx, buf, n, from);
+    rv->gro_bursts++;
+    for (int off = 0; off < n; off += seg)
+    {
+        rv->gro_segs++;
+        if (ingress(rv, tp, tx, buf + off, n - off < seg ? n - off : seg, from) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+// 손상 엔진/지연 ACK 사용 시: 전달 시각이 된 지연 데이터그램과 마감된 ACK 를 처리하고, 다음
+// 마감 시각에 타이머를 건 뒤 소켓 또는 타이머를 기다린다. 소켓에 읽을 데이터가 있으면 1
+// (SO_RCVTIMEO 는 jiffy 단위라 ms 이하 마감을 지키지 못함)
+static int wait_input(Receiver *rv, Transport *tp, TxBatch *tx)
+{
+    ImpPkt p;
+    uint64_t now = now_us();
+    while (rv->imp && imp_pop(rv->imp, now, &p))
+    {
+        handle(rv, tp, tx, p.data, p.n, &p.from);
+        free(p.data);
+    }
+    dack_flush(rv, tp, tx);
+    if (tx)
+        txb_flush(tp->fd, tx, &rv->syscalls);
 
-                int m = snprintf(ackbuf, sizeof(ackbuf), "ACK %d", ack);
-                sendto(s, ackbuf, m, 0, (struct sockaddr *)&cli, clen);
+    uint64_t due = rv->imp ? imp_next_due(rv->imp) : 0;
+    if (rv->dack_next && (!due || rv->dack_next < due))
+        due = rv->dack_next;
+    if (due)
+        ev_timer_arm(&rv->ev, due > now ? due - now : 1);
+    else if (rv->shared)
+        ev_timer_arm(&rv->ev, WORKER_POLL_US); // 종료 플래그를 보러 주기적으로 깨어남
+    else
+        ev_timer_disarm(&rv->ev);
+    return ev_wait(&rv->ev) & EV_READABLE;
+}
+
+// 기본 루프: 데이터그램 하나 받고 ACK 하나 보냄 (UDP 는 recvfrom/sendto, -M 은 공유 메모리 링).
+// -g 면 합쳐진 묶음 하나를 받아 그 안의 세그먼트들에 대한 ACK 를 sendmmsg 한 번으로 보냄
+static void loop_plain(Transport *tp, Receiver *rv)
+{
+    TxBatch *tx = tp->gro ? txb_new() : NULL;
+    while (!stopped(rv))
+    {
+        if (rv->timed && !wait_input(rv, tp, tx))
+            continue;
+
+        const uint8_t *buf;
+        struct sockaddr_in cli;
+        int n = tp_recv(tp, &buf, &cli);
+        if (n < 0)
+        {
+            if ((rv->imp || rv->shared || rv->dack_ratio > 1) && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                dack_flush(rv, tp, tx);
+                if (tx)
+                    txb_flush(tp->fd, tx, &rv->syscalls);
+                continue;
             }
-            else
+            die("recvfrom");
+        }
+
+        int r = ingress_gro(rv, tp, tx, buf, n, tp->gro_seg, &cli);
+        tp_recv_done(tp);
+        if (r >= 0)
+            dack_flush(rv, tp, tx);
+        if (tx)
+            txb_flush(tp->fd, tx, &rv->syscalls);
+        if (r < 0)
+            break;
+
+        if (rv->mode != MODE_BULK)
+            usleep(SLEEP_US);
+    }
+    free(tx);
+}
+
+// 배치 루프(-b): 대기 중인 DATA 를 recvmmsg 로 모두 받고, 그에 대한 ACK 를 sendmmsg 한 번으로 보냄
+static void loop_batch(Transport *tp, Receiver *rv)
+{
+    RxBatch *rx = rxb_new(DGRAM_BUF, IO_BATCH / 16); // 64 x 64KB
+    TxBatch *tx = txb_new();
+    if (rv->gro)
+        rxb_set_gro(rx);
+    int done = 0;
+
+    while (!done && !stopped(rv))
+    {
+        if (rv->timed && !wait_input(rv, tp, tx))
+            continue;
+
+        int k = rxb_recv(tp->fd, rx, &rv->syscalls);
+        if (k < 0)
+        {
+            if ((rv->imp || rv->shared || rv->dack_ratio > 1) && (errno == EAGAIN || errno == EWOULDBLOCK))
             {
-                // 재전송된 패킷 도착 → 손실 구간 복구 완료라고 가정
-                next_expected = 7500;
-                ack = next_expected;
-                printf(GREEN "[RCV] 재전송 패킷 수신 → 손실 구간 복구 → ACK %d 송신\n" RESET,
-                       ack);
-
-                int m = snprintf(ackbuf, sizeof(ackbuf), "ACK %d", ack);
-                sendto(s, ackbuf, m, 0, (struct sockaddr *)&cli, clen);
+                dack_flush(rv, tp, tx);
+                txb_flush(tp->fd, tx, &rv->syscalls);
+                continue;
             }
+            die("recvmmsg");
+        }
+
+        for (int i = 0; i < k && !done; i++)
+        {
+            if (ingress_gro(rv, tp, tx, rxb_data(rx, i), rxb_len(rx, i), rxb_seg(rx, i), &rx->addr[i]) < 0)
+                done = 1;
+        }
+        dack_flush(rv, tp, tx);
+        txb_flush(tp->fd, tx, &rv->syscalls);
 
+        if (!done && rv->mode != MODE_BULK)
             usleep(SLEEP_US);
+    }
+
+    rxb_free(rx);
+    free(tx);
+}
+
+// io_uring 루프(-u/-U): multishot recvmsg 가 낸 CQE 를 모두 처리하고, 그동안 쌓인 ACK SENDMSG SQE 는
+// 다음 대기의 io_uring_enter 한 번으로 함께 제출. 손상 엔진/지연 ACK 의 마감은 대기 timeout 으로 지킴.
+// 링은 이 스레드에서 만든다 (SINGLE_ISSUER). 만들 수 없으면 기본 루프로
+static void loop_uring(Transport *tp, Receiver *rv)
+{
+    Uring *u = ur_new(tp->fd, rv->uring == 2, rv->gro, &rv->syscalls);
+    if (!u)
+    {
+        printf(YELLOW "[RCV] io_uring 을 쓸 수 없음, recvfrom/sendto 로 받음\n" RESET);
+        rv->uring = 0;
+        loop_plain(tp, rv);
+        return;
+    }
+    if (rv->uring == 2 && !u->sqpoll)
+        rv->uring = 1;
+    rv->ur = u;
+    ur_arm_recv(u);
+    int done = 0;
+
+    while (!done && !stopped(rv))
+    {
+        ImpPkt p;
+        uint64_t now = now_us();
+        while (rv->imp && imp_pop(rv->imp, now, &p))
+        {
+            handle(rv, tp, NULL, p.data, p.n, &p.from);
+            free(p.data);
         }
+        dack_flush(rv, tp, NULL);
 
-        // ================= TIMEOUT 모드 =================
-        else if (mode == MODE_TIMEOUT)
+        uint64_t due = rv->imp ? imp_next_due(rv->imp) : 0;
+        if (rv->dack_next && (!due || rv->dack_next < due))
+            due = rv->dack_next;
+        ur_wait(u, due ? (due > now ? due - now : 1) : rv->shared ? WORKER_POLL_US : 0);
+
+        UrRecv r;
+        int k;
+        while (!done && (k = ur_next(u, &r)) >= 0)
         {
-            char ackbuf[BUF];
-            int ack = 0;
+            if (k == 0)
+                continue;
+            if (ingress_gro(rv, tp, NULL, r.data, r.len, r.seg, &r.from) < 0)
+                done = 1;
+            ur_recycle(u, &r);
+        }
+        ur_refill(u);
+    }
 
-            // 시나리오:
-            //  - seq=0: 정상 수신 → ACK=1500
-            //  - seq=1500,3000,4500,6000: 손실로 가정 → ACK 안 보냄
-            //  - 이후(회복 구간): 정상 수신 → 누적 ACK 동작
+    // END 의 ACK 등 아직 제출하지 않은 SQE 를 내보내고 완료를 확인한 뒤 닫음
+    uint64_t t0 = now_us();
+    while (u->nfree < UR_ACK_SLOTS && now_us() - t0 < WORKER_POLL_US)
+    {
+        UrRecv r;
+        int k;
+        ur_wait(u, 1000);
+        while ((k = ur_next(u, &r)) >= 0)
+            if (k > 0)
+                ur_recycle(u, &r);
+    }
+    rv->ur_st = u->st;
+    rv->ur = NULL;
+    ur_free(u);
+}
 
-            if (seq == 0)
-            {
-                next_expected = MSS;
-                ack = next_expected;
-                printf(GREEN "[RCV] 첫 패킷 정상 수신 → ACK %d 송신\n" RESET, ack);
+// 수신 소켓. 워커 모드면 SO_REUSEPORT 로 같은 포트를 여러 소켓이 나눠 가진다.
+// (Linux 는 4-tuple 해시로 소켓을 골라 한 플로우는 항상 같은 워커로 간다)
+static int open_socket(int port, Mode mode, int reuseport, int64_t bdp)
+{
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    if (s < 0)
+        die("socket");
 
-                int m = snprintf(ackbuf, sizeof(ackbuf), "ACK %d", ack);
-                sendto(s, ackbuf, m, 0, (struct sockaddr *)&cli, clen);
-            }
-            else if (timeout_drop_count < 4 &&
-                     (seq == 1500 || seq == 3000 || seq == 4500 || seq == 6000))
+    if (reuseport)
+    {
+        int one = 1;
+        if (setsockopt(s, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0)
+            die("setsockopt SO_REUSEPORT");
+        // 다른 워커가 종료 조건을 채운 것을 알아채도록 수신 대기에 timeout
+        struct timeval tv = {0, WORKER_POLL_US};
+        setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+
+    struct sockaddr_in me;
+    memset(&me, 0, sizeof(me));
+    me.sin_family = AF_INET;
+    me.sin_addr.s_addr = htonl(INADDR_ANY);
+    me.sin_port = htons(port);
+
+    if (bind(s, (struct sockaddr *)&me, sizeof(me)) < 0)
+        die("bind");
+
+    if (mode == MODE_BULK)
+    {
+        int64_t want = 2 * bdp > RCV_SOCKBUF ? 2 * bdp : RCV_SOCKBUF;
+        int sz = want > INT32_MAX / 2 ? INT32_MAX / 2 : (int)want;
+        // 커널 상한(rmem_max)에 막히면 권한이 있을 때 FORCE 로
+        if (setsockopt(s, SOL_SOCKET, SO_RCVBUFFORCE, &sz, sizeof(sz)) < 0)
+            setsockopt(s, SOL_SOCKET, SO_RCVBUF, &sz, sizeof(sz));
+    }
+    return s;
+}
+
+// 워커 하나: 자기 소켓, 자기 플로우 테이블, 자기 통계. 이웃 워커와 캐시 라인을 나눠 쓰지 않게 정렬
+typedef struct
+{
+    Receiver rv;
+    Impair imp;
+    int sock;
+    Transport tp;
+    int cpu;
+    int batch;
+    pthread_t tid;
+} __attribute__((aligned(64))) Worker;
+
+static void pin_cpu(int cpu)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu; // 코어 고정은 Linux 에서만
+#endif
+}
+
+static void *worker_main(void *arg)
+{
+    Worker *w = arg;
+    pin_cpu(w->cpu);
+    if (w->rv.uring)
+        loop_uring(&w->tp, &w->rv);
+    else if (w->batch)
+        loop_batch(&w->tp, &w->rv);
+    else
+        loop_plain(&w->tp, &w->rv);
+    atomic_store(&w->rv.shared->stop, 1); // 나머지 워커도 멈춤
+    return NULL;
+}
+
+// bulk 종료 요약. 워커 모드면 워커들의 합계로 호출
+static void print_summary(const Receiver *rv, const char *io)
+{
+    printf("  flows: %llu created, %llu ended, %llu evicted idle, %u still open\n",
+           (unsigned long long)rv->flows.created, (unsigned long long)rv->flows_done,
+           (unsigned long long)rv->flows.evicted, rv->flows.n);
+    if (rv->imp)
+        imp_report(rv->imp);
+    if (rv->flows_done > 1)
+        report_throughput("RCV total", rv->delivered, rv->rx_pkts, now_us() - rv->t_first);
+    double delivered = rv->delivered > 0 ? rv->delivered : 1;
+    printf("  syscalls %llu (%s)  %.2f per MB  %.3g per byte\n",
+           (unsigned long long)rv->syscalls, io,
+           rv->syscalls / (delivered / 1e6), rv->syscalls / delivered);
+    printf("  acks %llu for %llu data segments (%.2f per segment)",
+           (unsigned long long)rv->acks, (unsigned long long)rv->rx_pkts,
+           rv->rx_pkts ? (double)rv->acks / rv->rx_pkts : 0.0);
+    if (rv->dack_ratio > 1)
+        printf(", delayed ACK every %d segs / %.3f ms: %llu deferred, %llu sent by timer",
+               rv->dack_ratio, rv->dack_us / 1e3, (unsigned long long)rv->acks_delayed,
+               (unsigned long long)rv->acks_timer);
+    printf("\n");
+    if (rv->csum_checked)
+        printf("  crc32c (%s): %llu segments checked, %llu corrupted (dropped)\n", crc32c_impl,
+               (unsigned long long)rv->csum_checked, (unsigned long long)rv->csum_bad);
+    if (rv->out_path)
+        printf("  file: %llu pwrite, %llu verified, %llu failed\n", (unsigned long long)rv->file_writes,
+               (unsigned long long)rv->files_ok, (unsigned long long)rv->files_bad);
+    if (rv->gro)
+        printf("  gro: %llu coalesced datagrams carrying %llu segments (%.1f per datagram), %llu single\n",
+               (unsigned long long)rv->gro_bursts, (unsigned long long)rv->gro_segs,
+               rv->gro_bursts ? (double)rv->gro_segs / rv->gro_bursts : 0.0,
+               (unsigned long long)(rv->rx_pkts > rv->gro_segs ? rv->rx_pkts - rv->gro_segs : 0));
+    if (rv->uring)
+    {
+        const UrStats *u = &rv->ur_st;
+        printf("  io_uring%s: %llu recv CQEs, %llu ACK SQEs (%llu sent directly), %llu io_uring_enter "
+               "(%.3f per packet), %llu multishot re-arms",
+               rv->uring == 2 ? " SQPOLL" : "", (unsigned long long)u->recv_cqes, (unsigned long long)u->acks_sqe,
+               (unsigned long long)u->acks_sync, (unsigned long long)u->enters,
+               u->recv_cqes ? (double)u->enters / u->recv_cqes : 0.0, (unsigned long long)u->rearms);
+        if (rv->uring == 2)
+            printf(", %llu wakeups", (unsigned long long)u->wakeups);
+        if (u->send_errs || u->truncated)
+            printf(", %llu send errors, %llu truncated", (unsigned long long)u->send_errs,
+                   (unsigned long long)u->truncated);
+        printf("\n");
+    }
+    if (json_out)
+    {
+        // 기계가 읽는 결과 한 줄 (bench.c). CPU 는 프로세스 전체 (SQPOLL 커널 스레드 포함)
+        double sec = rv->t_first ? (now_us() - rv->t_first) / 1e6 : 0;
+        double cpu = cpu_seconds();
+        printf("{\"io\":\"%s\",\"rx_pkts\":%llu,\"delivered\":%llu,\"elapsed_s\":%.3f,\"rx_pps\":%.0f,"
+               "\"cpu_s\":%.3f,\"cpu_ns_per_pkt\":%.1f,\"syscalls\":%llu,\"syscalls_per_pkt\":%.4f,\"acks\":%llu}\n",
+               io, (unsigned long long)rv->rx_pkts, (unsigned long long)rv->delivered, sec,
+               sec > 0 ? rv->rx_pkts / sec : 0.0, cpu, rv->rx_pkts ? cpu * 1e9 / rv->rx_pkts : 0.0,
+               (unsigned long long)rv->syscalls, rv->rx_pkts ? (double)rv->syscalls / rv->rx_pkts : 0.0,
+               (unsigned long long)rv->acks);
+        fflush(stdout);
+    }
+}
+
+// 종료 요약에 쓰는 수신 경로 이름
+static const char *io_name(const Receiver *rv, const Transport *tp, int batch)
+{
+    if (rv->uring)
+        return rv->uring == 2 ? (rv->gro ? "io_uring+SQPOLL+GRO" : "io_uring+SQPOLL")
+                              : (rv->gro ? "io_uring+GRO" : "io_uring");
+    if (batch)
+        return rv->gro ? "recvmmsg+GRO/sendmmsg" : "recvmmsg/sendmmsg";
+    if (tp && tp->kind == TP_SHM)
+        return tp_name(tp);
+    return rv->gro ? "recvmsg+GRO/sendmmsg" : "recvfrom/sendto";
+}
+
+// -w: 워커 n 개를 띄우고 모두 끝날 때까지 기다린 뒤 합계를 출력
+static void run_workers(int n, int port, Mode mode, int batch, uint64_t idle_us, uint64_t max_flows,
+                        const ImpairCfg *icfg, int dack_ratio, uint64_t dack_us, const char *out_path,
+                        int64_t bdp, int gro, int uring)
+{
+    Shared sh;
+    atomic_init(&sh.flows_done, 0);
+    atomic_init(&sh.stop, 0);
+    sh.max_flows = max_flows;
+
+    Worker *w = aligned_alloc(64, sizeof(Worker) * n);
+    if (!w)
+        die("aligned_alloc workers");
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpu < 1)
+        ncpu = 1;
+
+    // 소켓을 모두 bind 한 뒤에 스레드를 띄워야 커널의 분배 대상이 처음부터 고정된다
+    for (int i = 0; i < n; i++)
+    {
+        rv_init(&w[i].rv, mode, idle_us, 0);
+        w[i].rv.shared = &sh;
+        w[i].rv.flows.ro_cap = bdp ? bdp_segs(bdp) : 0;
+        w[i].sock = open_socket(port, mode, 1, bdp);
+        tp_udp(&w[i].tp, w[i].sock, DGRAM_BUF, &w[i].rv.syscalls);
+        if (gro)
+            w[i].rv.gro = tp_udp_gro(&w[i].tp);
+        w[i].rv.dack_ratio = dack_ratio;
+        w[i].rv.dack_us = dack_us;
+        w[i].rv.out_path = out_path;
+        w[i].rv.uring = uring;
+        w[i].cpu = i % ncpu;
+        w[i].batch = batch;
+        if (icfg)
+        {
+            ImpairCfg c = *icfg;
+            c.seed += i; // 워커마다 다른 수열, 같은 seed 면 재현 가능
+            imp_init(&w[i].imp, &c);
+            w[i].rv.imp = &w[i].imp;
+        }
+        if (icfg || dack_ratio > 1)
+        {
+            w[i].rv.timed = 1;
+            ev_init(&w[i].rv.ev, w[i].sock);
+        }
+    }
+    for (int i = 0; i < n; i++)
+        if (pthread_create(&w[i].tid, NULL, worker_main, &w[i]) != 0)
+            die("pthread_create");
+    for (int i = 0; i < n; i++)
+        pthread_join(w[i].tid, NULL);
+
+    printf(BOLDMAG "\n=== [RCV] END 수신 → 시나리오 종료 ===\n" RESET);
+    Receiver tot;
+    memset(&tot, 0, sizeof(tot));
+    tot.dack_ratio = dack_ratio;
+    tot.dack_us = dack_us;
+    tot.out_path = out_path;
+    tot.gro = gro;
+    tot.uring = uring;
+    for (int i = 0; i < n; i++)
+    {
+        const Receiver *rv = &w[i].rv;
+        printf("  worker %d (cpu %d): %llu pkts, %llu flows, delivered %llu bytes, syscalls %llu\n",
+               i, w[i].cpu, (unsigned long long)rv->rx_pkts, (unsigned long long)rv->flows.created,
+               (unsigned long long)rv->delivered, (unsigned long long)rv->syscalls);
+        if (rv->imp)
+        {
+            printf("  ");
+            imp_report(rv->imp);
+        }
+        tot.flows.created += rv->flows.created;
+        tot.flows.evicted += rv->flows.evicted;
+        tot.flows.n += rv->flows.n;
+        tot.flows_done += rv->flows_done;
+        tot.rx_pkts += rv->rx_pkts;
+        tot.rx_bytes += rv->rx_bytes;
+        tot.delivered += rv->delivered;
+        tot.syscalls += rv->syscalls;
+        tot.acks += rv->acks;
+        tot.acks_delayed += rv->acks_delayed;
+        tot.acks_timer += rv->acks_timer;
+        tot.file_writes += rv->file_writes;
+        tot.files_ok += rv->files_ok;
+        tot.files_bad += rv->files_bad;
+        tot.csum_checked += rv->csum_checked;
+        tot.csum_bad += rv->csum_bad;
+        tot.gro_bursts += rv->gro_bursts;
+        tot.gro_segs += rv->gro_segs;
+        ur_stats_add(&tot.ur_st, &rv->ur_st);
+        if (!rv->uring)
+            tot.uring = 0; // 링을 만들지 못한 워커가 있으면 기본 경로로 표시
+        if (rv->rx_pkts && (!tot.t_first || rv->t_first < tot.t_first))
+            tot.t_first = rv->t_first;
+    }
+    print_summary(&tot, io_name(&tot, NULL, batch));
+
+    for (int i = 0; i < n; i++)
+    {
+        if (w[i].rv.timed)
+            ev_close(&w[i].rv.ev);
+        if (w[i].rv.imp)
+            imp_free(w[i].rv.imp);
+        ft_free(&w[i].rv.flows);
+        tp_close(&w[i].tp);
+        close(w[i].sock);
+    }
+    free(w);
+}
+
+int main(int argc, char **argv)
+{
+    int batch = 0;
+    const char *impair = NULL; // -I: 손상 엔진 설정 문자열
+    long max_flows = 1;        // -n
+    double idle_sec = FLOW_IDLE_US / 1e6; // -i
+    int workers = 0;           // -w: 0 이면 단일 스레드
+    const char *shm_name = NULL; // -M: 공유 메모리 전송
+    int busy_poll = 0;         // -y
+    uint64_t dack_us = 0;      // -d: 지연 ACK 타이머
+    int dack_ratio = 0;        // -k: ACK 하나가 덮는 full 세그먼트 수
+    const char *out_path = NULL; // -F: 받은 데이터를 저장할 파일
+    int64_t bdp = 0;           // -B: 대역폭-지연 곱 (바이트)
+    int gro = 0;               // -g: UDP_GRO
+    int uring = 0;             // -u: io_uring, -U: io_uring + SQPOLL
+    int opt;
+    crc32c_init(); // sender -K 의 CRC32C 는 옵션 없이 항상 확인
+    while ((opt = getopt(argc, argv, "bI:n:i:w:M:yd:k:F:B:guUj")) != -1)
+    {
+        if (opt == 'b')
+            batch = 1;
+        else if (opt == 'I')
+            impair = optarg;
+        else if (opt == 'n')
+            max_flows = atol(optarg);
+        else if (opt == 'i')
+            idle_sec = atof(optarg);
+        else if (opt == 'w')
+            workers = atoi(optarg);
+        else if (opt == 'M')
+            shm_name = optarg;
+        else if (opt == 'y')
+            busy_poll = 1;
+        else if (opt == 'd')
+        {
+            if (imp_parse_us(optarg, &dack_us) < 0 || dack_us == 0)
             {
-                timeout_drop_count++;
-                printf(RED "[RCV] 손실로 가정 → ACK 전송 안 함 (drop #%d)\n" RESET,
-                       timeout_drop_count);
-                // 아무 것도 안 보냄
+                fprintf(stderr, "잘못된 지연 ACK 시간: %s (예: 40ms, 500us)\n", optarg);
+                return 1;
             }
-            else
+        }
+        else if (opt == 'k')
+            dack_ratio = atoi(optarg);
+        else if (opt == 'F')
+            out_path = optarg;
+        else if (opt == 'g')
+            gro = 1;
+        else if (opt == 'u')
+            uring = uring ? uring : 1;
+        else if (opt == 'U')
+            uring = 2;
+        else if (opt == 'j')
+            json_out = 1;
+        else if (opt == 'B')
+        {
+            if ((bdp = parse_bdp(optarg)) <= 0)
             {
-                // 회복 구간: 정상 누적 ACK
-                if (seq == next_expected)
-                {
-                    next_expected += len;
-                    printf(GREEN "[RCV] in-order 수신 → next_expected=%d\n" RESET,
-                           next_expected);
-                }
-                else if (seq > next_expected)
-                {
-                    printf(YELLOW "[RCV] out-of-order (next_expected=%d) → 기존 ACK 유지\n" RESET,
-                           next_expected);
-                }
-
-                ack = next_expected;
-                printf(GREEN "[RCV] 회복 구간 ACK 송신   ▶▶▶   ACK %d\n" RESET, ack);
-
-                int m = snprintf(ackbuf, sizeof(ackbuf), "ACK %d", ack);
-                sendto(s, ackbuf, m, 0, (struct sockaddr *)&cli, clen);
+                fprintf(stderr, "잘못된 BDP: %s (예: 10g:80 = 10 Gbit/s x 80 ms, 또는 100m bytes)\n", optarg);
+                return 1;
             }
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-b] [-I impair] [-n flows] [-i idle_sec] [-w workers] [-M shm [-y]] [-d delay] [-k ratio] [-F file] [-B bdp] [-g] [-u | -U] [-j] <listen_port> <normal|dup3|timeout|bulk>\n", argv[0]);
+            return 1;
+        }
+    }
+    argc -= optind;
+    argv += optind;
 
-            usleep(SLEEP_US);
+    if (shm_name && (batch || workers > 0 || impair || gro || uring))
+    {
+        fprintf(stderr, "-M 은 -b, -w, -I, -g, -u 와 함께 쓸 수 없습니다 (소켓 전용)\n");
+        return 1;
+    }
+    if (uring && batch)
+    {
+        fprintf(stderr, "-u/-U 와 -b 는 함께 쓸 수 없습니다 (둘 다 수신 경로)\n");
+        return 1;
+    }
+    if (argc < (shm_name ? 1 : 2))
+    {
+        fprintf(stderr, "usage: receiver [-b] [-I impair] [-n flows] [-i idle_sec] [-w workers] [-M shm [-y]] [-d delay] [-k ratio] [-F file] [-B bdp] [-g] [-u | -U] [-j] <listen_port> <normal|dup3|timeout|bulk>\n");
+        return 1;
+    }
+
+    // -M 이면 포트 없이 시나리오만
+    int port = shm_name ? 0 : atoi(argv[0]);
+    Mode mode = parse_mode(argv[shm_name ? 0 : 1]);
+
+    ImpairCfg icfg;
+    if (impair)
+    {
+        // 시나리오 모드의 송신자는 정해진 손실만 복구하므로 임의 손상은 bulk 에서만 허용
+        if (mode != MODE_BULK)
+        {
+            fprintf(stderr, "-I 는 bulk 모드에서만 사용할 수 있습니다\n");
+            return 1;
+        }
+        if (imp_parse(&icfg, impair) < 0)
+        {
+            fprintf(stderr, "잘못된 impair 설정: %s\n"
+                            "  loss=P ge=P:R[:BAD[:GOOD]] delay=T jitter=T reorder=P gap=T dup=P corrupt=P seed=N\n",
+                    impair);
+            return 1;
+        }
+    }
+    // 지연 ACK: -d 만 주면 두 세그먼트마다, -k 만 주면 타이머 기본값
+    if (dack_us || dack_ratio)
+    {
+        // 시나리오 모드의 송신자는 세그먼트마다 ACK 를 하나씩 기다림
+        if (mode != MODE_BULK)
+        {
+            fprintf(stderr, "-d, -k 는 bulk 모드에서만 사용할 수 있습니다\n");
+            return 1;
+        }
+        if (dack_ratio == 0)
+            dack_ratio = 2;
+        if (dack_ratio < 1)
+        {
+            fprintf(stderr, "-k 는 1 이상이어야 합니다\n");
+            return 1;
+        }
+        if (!dack_us)
+            dack_us = DACK_US;
+    }
+    else
+        dack_ratio = 1;
+
+    if (out_path && mode != MODE_BULK)
+    {
+        fprintf(stderr, "-F 는 bulk 모드에서만 사용할 수 있습니다\n");
+        return 1;
+    }
+    if (bdp && mode != MODE_BULK)
+    {
+        fprintf(stderr, "-B 는 bulk 모드에서만 사용할 수 있습니다\n");
+        return 1;
+    }
+    if (uring && mode != MODE_BULK)
+    {
+        fprintf(stderr, "-u/-U 는 bulk 모드에서만 사용할 수 있습니다\n");
+        return 1;
+    }
+
+    // 시나리오 모드는 단계별 출력과 SLEEP_US 간격이 목적이라 워커로 나누지 않음
+    if (workers > 0 && mode != MODE_BULK)
+    {
+        fprintf(stderr, "-w 는 bulk 모드에서만 사용할 수 있습니다\n");
+        return 1;
+    }
+    uint64_t idle_us = idle_sec > 0 ? (uint64_t)(idle_sec * 1e6) : FLOW_IDLE_US;
+    uint64_t nflows = max_flows > 0 ? max_flows : 0;
+
+    printf(BOLDMAG "=== [RCV] Receiver 시작 (port=%d, mode=%s) ===\n" RESET,
+           port,
+           mode == MODE_NORMAL ? "normal" : mode == MODE_DUP3  ? "dup3"
+                                        : mode == MODE_TIMEOUT ? "timeout"
+                                                               : "bulk");
+    if (bdp)
+        printf(YELLOW "[RCV] BDP %.1f MB: reorder buffer %u segs\n" RESET, bdp / 1e6, bdp_segs(bdp));
+
+    if (workers > 0)
+    {
+        printf(YELLOW "[RCV] workers: %d (SO_REUSEPORT)\n" RESET, workers);
+        if (uring)
+            printf(YELLOW "[RCV] io_uring%s per worker\n" RESET, uring == 2 ? " + SQPOLL" : "");
+        if (impair)
+            printf(YELLOW "[RCV] impair: %s\n" RESET, impair);
+        if (dack_ratio > 1)
+            printf(YELLOW "[RCV] delayed ACK: every %d segments, timer %.3f ms\n" RESET, dack_ratio, dack_us / 1e3);
+        run_workers(workers, port, mode, batch, idle_us, nflows, impair ? &icfg : NULL, dack_ratio, dack_us, out_path, bdp, gro,
+                    uring);
+        return 0;
+    }
+
+    Receiver rv;
+    rv_init(&rv, mode, idle_us, nflows);
+    rv.flows.ro_cap = bdp ? bdp_segs(bdp) : 0;
+    rv.dack_ratio = dack_ratio;
+    rv.dack_us = dack_us;
+    rv.out_path = out_path;
+    rv.uring = uring;
+    if (out_path)
+        printf(YELLOW "[RCV] file sink: %s (pwrite)\n" RESET, out_path);
+
+    int s = -1;
+    Transport tp;
+    if (shm_name)
+    {
+        tp_shm_create(&tp, shm_name, busy_poll, &rv.syscalls);
+        printf(YELLOW "[RCV] transport: %s (%s)\n" RESET, tp_name(&tp), tp.name);
+    }
+    else
+    {
+        s = open_socket(port, mode, 0, bdp);
+        tp_udp(&tp, s, DGRAM_BUF, &rv.syscalls);
+        if (gro)
+        {
+            rv.gro = tp_udp_gro(&tp);
+            if (rv.gro)
+                printf(YELLOW "[RCV] UDP_GRO on\n" RESET);
+            else
+                printf(YELLOW "[RCV] UDP_GRO 를 켤 수 없음 (커널 미지원), 데이터그램 하나씩 받음\n" RESET);
         }
     }
 
-    close(s);
+    Impair imp;
+    if (impair)
+    {
+        imp_init(&imp, &icfg);
+        rv.imp = &imp;
+        printf(YELLOW "[RCV] impair: %s\n" RESET, impair);
+    }
+    if (impair || (dack_ratio > 1 && !shm_name))
+    {
+        rv.timed = 1;
+        ev_init(&rv.ev, s);
+    }
+    if (dack_ratio > 1)
+    {
+        // UDP 는 이벤트 루프 타이머가, 공유 메모리 링은 수신 대기 timeout(futex) 이 마감을 챙김
+        if (shm_name)
+            tp_set_timeout(&tp, dack_us);
+        printf(YELLOW "[RCV] delayed ACK: every %d segments, timer %.3f ms\n" RESET, dack_ratio, dack_us / 1e3);
+    }
+
+    if (uring)
+    {
+        printf(YELLOW "[RCV] io_uring%s: multishot recvmsg + provided buffers, ACK via SQE\n" RESET,
+               uring == 2 ? " + SQPOLL" : "");
+        loop_uring(&tp, &rv);
+    }
+    else if (batch)
+        loop_batch(&tp, &rv);
+    else
+        loop_plain(&tp, &rv);
+
+    printf(BOLDMAG "\n=== [RCV] END 수신 → 시나리오 종료 ===\n" RESET);
+    if (mode == MODE_BULK)
+        print_summary(&rv, io_name(&rv, &tp, batch));
+
+    if (rv.timed)
+        ev_close(&rv.ev);
+    if (rv.imp)
+        imp_free(rv.imp);
+    ft_free(&rv.flows);
+    tp_close(&tp);
+    if (s >= 0)
+        close(s);
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,239 @@
+// reorder.h - 수신측 재정렬 버퍼 + SACK 비트맵
+// next_expected 뒤로 도착한 순서 밖 세그먼트를 버리지 않고 MSS 블록 단위 링 버퍼에 기록한다.
+// 블록 i 는 시퀀스 [i*MSS, (i+1)*MSS) 이며 링 슬롯 i % cap 에 대응한다.
+// 구멍이 채워지면 연속으로 도착해 있던 블록들을 비트맵 스캔 한 번으로 넘어가며
+// next_expected 를 전진시키고, 아직 남은 구간은 SACK 블록으로 보고한다.
+// (bulk 모드는 페이로드를 소비하지 않으므로 도착 여부와 길이만 보관한다)
+// 가장 최근 세그먼트가 속한 구간은 [run_lo, run_hi) 로 들고 다니며 세그먼트마다 이어 붙이므로,
+// 윈도우가 수만 블록이어도 ACK 하나에 드는 일은 구간 길이와 상관없이 일정하다.
+#ifndef REORDER_H
+#define REORDER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "segment.h"
+
+#define RO_DEFAULT_CAP 4096 // 기본 용량 (블록 수, 64의 배수)
+
+typedef struct
+{
+    uint64_t *bits;   // 도착한 블록 비트맵 (슬롯 = 블록 번호 % cap)
+    uint16_t *len;    // 블록별 길이 (마지막 세그먼트는 MSS 보다 짧을 수 있음)
+    uint32_t cap;     // 블록 수
+    int64_t next;     // next_expected (바이트)
+    int64_t last_seq; // 가장 최근에 버퍼에 들어간 순서 밖 세그먼트 (첫 SACK 블록용)
+    uint64_t hi_blk;  // 버퍼에 들어간 가장 높은 블록 번호 + 1 (스캔 범위 제한)
+    uint64_t run_lo, run_hi; // last_seq 블록이 속한 연속 구간 [run_lo, run_hi) (last_seq >= 0 일 때)
+    uint64_t buffered, dups, out_of_window;
+} Reorder;
+
+static inline void ro_init(Reorder *ro, uint32_t cap)
+{
+    cap = (cap + 63) / 64 * 64;
+    ro->cap = cap;
+    ro->bits = calloc(cap / 64, sizeof(uint64_t));
+    ro->len = calloc(cap, sizeof(uint16_t));
+    if (!ro->bits || !ro->len)
+        die("calloc reorder");
+    ro->next = 0;
+    ro->last_seq = -1;
+    ro->hi_blk = 0;
+    ro->run_lo = ro->run_hi = 0;
+    ro->buffered = ro->dups = ro->out_of_window = 0;
+}
+
+static inline void ro_free(Reorder *ro)
+{
+    free(ro->bits);
+    free(ro->len);
+    ro->bits = NULL;
+    ro->len = NULL;
+}
+
+static inline int ro_test(const Reorder *ro, uint64_t blk)
+{
+    uint32_t i = blk % ro->cap;
+    return (ro->bits[i / 64] >> (i % 64)) & 1;
+}
+
+static inline void ro_set(Reorder *ro, uint64_t blk)
+{
+    uint32_t i = blk % ro->cap;
+    ro->bits[i / 64] |= 1ULL << (i % 64);
+}
+
+// from 블록부터 비트 값이 bit 인 블록이 연속으로 몇 개인지 (최대 limit). 64비트 단위로 센다
+static inline uint32_t ro_span(const Reorder *ro, uint64_t from, uint32_t limit, int bit)
+{
+    uint32_t n = 0;
+    while (n < limit)
+    {
+        uint32_t i = (from + n) % ro->cap;
+        uint64_t w = ro->bits[i / 64] >> (i % 64);
+        if (!bit)
+            w = ~w;
+        uint32_t avail = 64 - i % 64; // 이 워드에서 볼 수 있는 비트 수
+        uint32_t same = ~w ? (uint32_t)__builtin_ctzll(~w) : 64;
+        if (same > avail)
+            same = avail;
+        n += same;
+        if (same < avail)
+            break;
+    }
+    return n < limit ? n : limit;
+}
+
+// from 블록 바로 앞(from-1, from-2, ...)으로 연속으로 도착해 있는 블록 수 (최대 limit). 64비트 단위로 센다
+static inline uint32_t ro_span_back(const Reorder *ro, uint64_t from, uint32_t limit)
+{
+    uint32_t n = 0;
+    while (n < limit)
+    {
+        uint32_t i = (from - 1 - n) % ro->cap;
+        uint64_t w = ro->bits[i / 64] << (63 - i % 64); // 블록 i 가 최상위 비트
+        uint32_t avail = i % 64 + 1;
+        uint32_t same = ~w ? (uint32_t)__builtin_clzll(~w) : 64;
+        if (same > avail)
+            same = avail;
+        n += same;
+        if (same < avail)
+            break;
+    }
+    return n < limit ? n : limit;
+}
+
+// from 블록부터 연속으로 도착해 있는 블록 수
+static inline uint32_t ro_run(const Reorder *ro, uint64_t from, uint32_t limit)
+{
+    return ro_span(ro, from, limit, 1);
+}
+
+// from 블록부터 연속된 n 개 블록의 비트를 지운다
+static inline void ro_clear(Reorder *ro, uint64_t from, uint32_t n)
+{
+    while (n > 0)
+    {
+        uint32_t i = from % ro->cap;
+        uint32_t k = 64 - i % 64;
+        if (k > n)
+            k = n;
+        uint64_t mask = (k == 64 ? ~0ULL : ((1ULL << k) - 1)) << (i % 64);
+        ro->bits[i / 64] &= ~mask;
+        from += k;
+        n -= k;
+    }
+}
+
+// 세그먼트 하나를 반영하고 갱신된 next_expected 를 반환
+static inline int64_t ro_insert(Reorder *ro, int64_t seq, uint32_t len)
+{
+    if (seq < ro->next)
+    {
+        ro->dups++;
+        return ro->next;
+    }
+
+    // MSS 경계에 맞지 않는 세그먼트는 버퍼링하지 않고 in-order 일 때만 받는다
+    if (seq % MSS != 0 || len > MSS)
+    {
+        if (seq == ro->next)
+            ro->next += len;
+        return ro->next;
+    }
+
+    uint64_t blk = seq / MSS;
+    uint64_t head = ro->next / MSS;
+    if (blk - head >= ro->cap)
+    {
+        ro->out_of_window++;
+        return ro->next;
+    }
+
+    if (seq == ro->next)
+    {
+        // 구멍이 채워짐: 뒤에 연속으로 도착해 있던 블록까지 한 번에 전진
+        uint32_t run = ro->hi_blk > blk + 1 ? ro_run(ro, blk + 1, ro->hi_blk - blk - 1) : 0;
+        int64_t end = seq + len;
+        if (run > 0)
+        {
+            uint64_t last = blk + run;
+            end = (int64_t)last * MSS + ro->len[last % ro->cap];
+            ro_clear(ro, blk + 1, run);
+        }
+        ro->next = end;
+        if (ro->last_seq >= 0 && ro->last_seq < ro->next)
+            ro->last_seq = -1;
+        return ro->next;
+    }
+
+    if (ro_test(ro, blk))
+    {
+        ro->dups++;
+        return ro->next;
+    }
+    ro_set(ro, blk);
+    ro->len[blk % ro->cap] = len;
+    if (blk + 1 > ro->hi_blk)
+        ro->hi_blk = blk + 1;
+
+    // 최근 구간 갱신: 구간 바로 뒤에 이어 온 흔한 경우는 그대로 늘리고, 아니면 앞뒤 이웃 구간을 찾음
+    if (ro->last_seq >= 0 && blk == ro->run_hi)
+        ro->run_hi = blk + 1;
+    else
+    {
+        ro->run_lo = blk - ro_span_back(ro, blk, (uint32_t)(blk - head - 1));
+        ro->run_hi = blk + 1;
+    }
+    if (ro->run_hi < ro->hi_blk)
+        ro->run_hi += ro_run(ro, ro->run_hi, ro->hi_blk - ro->run_hi); // 뒤 구간과 이어졌으면 합침
+    ro->last_seq = seq;
+    ro->buffered++;
+    return ro->next;
+}
+
+// next_expected 뒤의 SACK 블록을 최대 max 개 채우고 개수 반환.
+// RFC 2018 처럼 가장 최근에 도착한 세그먼트를 포함한 블록을 맨 앞에 둔다
+static inline int ro_sack(const Reorder *ro, SackBlock *out, int max)
+{
+    uint64_t head = ro->next / MSS;
+    uint64_t end = ro->hi_blk;
+    if (max <= 0 || end <= head + 1)
+        return 0;
+
+    int n = 0;
+    uint64_t first = UINT64_MAX; // 맨 앞에 넣은 구간의 시작 블록
+
+    // 가장 최근 블록이 속한 구간 (ro_insert 가 들고 있는 것을 그대로)
+    if (ro->last_seq >= ro->next)
+    {
+        out[n].start = ro->run_lo * MSS;
+        out[n].end = (ro->run_hi - 1) * MSS + ro->len[(ro->run_hi - 1) % ro->cap];
+        n++;
+        first = ro->run_lo;
+    }
+
+    // 나머지 구간은 앞에서부터 (구멍은 워드 단위로, 맨 앞에 넣은 구간은 통째로 건너뜀)
+    uint64_t blk = head + 1;
+    while (blk < end && n < max)
+    {
+        blk += ro_span(ro, blk, end - blk, 0);
+        if (blk >= end)
+            break;
+        if (blk == first)
+        {
+            blk = ro->run_hi;
+            continue;
+        }
+        uint32_t r = ro_run(ro, blk, end - blk);
+        out[n].start = blk * MSS;
+        out[n].end = (blk + r - 1) * MSS + ro->len[(blk + r - 1) % ro->cap];
+        n++;
+        blk += r;
+    }
+    return n;
+}
+
+#endif
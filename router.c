@@ -0,0 +1,548 @@
+// router.c - loopback 병목 라우터 (sender 와 receiver 사이의 미들박스)
+// 실행 방법:
+//   ./router [-r rate] [-q pkts] [-a aqm] [-d delay] [-n flows] [-i interval] [-o series.csv] [-s seed] [-j]
+//            <listen_port> <dst_ip> <dst_port>
+//   sender 는 router 의 listen_port 로 보내고(./sender ... 127.0.0.1 <listen_port> bulk), router 는 DATA 를
+//   속도가 제한된 병목 링크 하나로 <dst_ip>:<dst_port> 의 receiver 에 전달한다. ACK 는 큐 없이 되돌려 준다.
+//   -r: 병목 링크 속도 bit/s (k/m/g 단위, 기본 100m)
+//   -q: 링크 앞 버퍼 크기, 패킷 수 (기본 100)
+//   -a: 큐 관리 방식 (aqm.h). droptail (기본), red[:min:max:maxp[:wq]], codel[:target[:interval]]
+//   -d: 방향마다의 전파 지연 (예: 10ms → 기본 RTT 20ms). 링크를 떠난 패킷을 이만큼 늦게 전달
+//   -n: END 를 이만큼 전달하면 종료 (기본 1, 0 이면 Ctrl-C 까지)
+//   -i: 이 간격(기본 1s)마다 큐 길이/체류 시간/드롭/링크 사용률을 출력
+//   -o: 같은 값을 간격마다 CSV 로 기록 (t_ms,qlen_pkts,qlen_bytes,sojourn_avg_us,sojourn_max_us,
+//       enq,drop_tail,drop_aqm,tx_mbps,util)
+//   -j: 종료 시 결과를 JSON 한 줄로 출력 (bench.c)
+// 송신자(주소)마다 receiver 쪽 소켓을 따로 열어 연결해 두므로 receiver 는 송신자별로 다른 주소를 보고,
+// 그 소켓에 돌아온 ACK 는 해당 송신자에게 보낸다.
+// END 같은 제어 세그먼트는 큐 순서는 지키되 버리지 않는다 (sender 는 END 를 재전송하지 않음).
+// 링크는 가상 시계로 직렬화한다: 패킷마다 길이 * 8 / 속도 만큼 링크를 점유하고, 깨어나는 시각이 늦어도
+// 밀린 만큼 한꺼번에 내보내 평균 속도를 지킨다.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "aqm.h"
+#include "common.h"
+#include "hist.h"
+#include "impair.h"
+#include "segment.h"
+
+#define ROUTER_MAX_PEERS 64
+#define ROUTER_LINGER_US 200000 // 마지막 END 뒤 ACK 가 돌아올 시간
+#define ROUTER_SOCKBUF (4 * 1024 * 1024)
+#define ROUTER_DL_INIT 1024     // 지연 라인 초기 용량 (가득 차면 두 배)
+
+// 송신자 하나: 주소와 receiver 쪽으로 연결한 소켓
+typedef struct
+{
+    struct sockaddr_in addr;
+    int fd;
+} Peer;
+
+// 전파 지연 라인: 지연이 일정하므로 FIFO 로 충분 (전달 시각 순서 = 넣은 순서)
+typedef struct
+{
+    uint64_t due;
+    int tag, len;
+    uint8_t data[AQM_SLOT];
+} DlPkt;
+
+typedef struct
+{
+    DlPkt *ring;
+    uint32_t cap, head, n;
+} DelayLine;
+
+typedef struct
+{
+    int lsock; // 송신자 쪽
+    struct sockaddr_in dst;
+    Peer peers[ROUTER_MAX_PEERS];
+    int npeers;
+
+    double rate;        // bit/s
+    uint64_t delay_us;  // 방향마다
+    Aqm q;
+    double link_free;   // 링크가 비는 가상 시각 (us, 소수점까지)
+    DelayLine fwd, rev; // DATA 방향, ACK 방향
+
+    // 통계
+    uint64_t t_first, t_last_tx;
+    double busy_us; // 링크가 전송에 쓴 시간
+    uint64_t tx_pkts, tx_bytes, acks, ends, no_peer, rx_trunc;
+
+    // -i / -o 구간 통계
+    uint64_t iv_us, iv_next, iv_start;
+    uint64_t iv_tx_bytes, iv_soj_sum, iv_soj_max, iv_deq;
+    double iv_busy;
+    FILE *csv;
+} Router;
+
+static volatile sig_atomic_t interrupted;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    interrupted = 1;
+}
+
+static void dl_init(DelayLine *d)
+{
+    d->cap = ROUTER_DL_INIT;
+    d->head = d->n = 0;
+    d->ring = malloc(sizeof(DlPkt) * d->cap);
+    if (!d->ring)
+        die("malloc delay line");
+}
+
+static void dl_push(DelayLine *d, uint64_t due, int tag, const uint8_t *data, int len)
+{
+    if (d->n == d->cap)
+    {
+        // 두 배로 늘리며 순서대로 다시 펼침
+        DlPkt *r = malloc(sizeof(DlPkt) * d->cap * 2);
+        if (!r)
+            die("malloc delay line");
+        for (uint32_t i = 0; i < d->n; i++)
+            r[i] = d->ring[(d->head + i) & (d->cap - 1)];
+        free(d->ring);
+        d->ring = r;
+        d->head = 0;
+        d->cap *= 2;
+    }
+    DlPkt *p = &d->ring[(d->head + d->n) & (d->cap - 1)];
+    p->due = due;
+    p->tag = tag;
+    p->len = len;
+    memcpy(p->data, data, len);
+    d->n++;
+}
+
+// 전달 시각이 된 머리 패킷 (없으면 NULL). 쓴 뒤 dl_pop
+static DlPkt *dl_head(DelayLine *d, uint64_t now)
+{
+    if (!d->n || d->ring[d->head].due > now)
+        return NULL;
+    return &d->ring[d->head];
+}
+
+static void dl_pop(DelayLine *d)
+{
+    d->head = (d->head + 1) & (d->cap - 1);
+    d->n--;
+}
+
+static int open_udp(int port)
+{
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    if (s < 0)
+        die("socket");
+    int sz = ROUTER_SOCKBUF;
+    setsockopt(s, SOL_SOCKET, SO_RCVBUF, &sz, sizeof(sz));
+    setsockopt(s, SOL_SOCKET, SO_SNDBUF, &sz, sizeof(sz));
+    struct sockaddr_in me;
+    memset(&me, 0, sizeof(me));
+    me.sin_family = AF_INET;
+    me.sin_addr.s_addr = htonl(port ? INADDR_ANY : INADDR_LOOPBACK);
+    me.sin_port = htons(port);
+    if (bind(s, (struct sockaddr *)&me, sizeof(me)) < 0)
+        die("bind");
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+    return s;
+}
+
+// 송신자 주소의 번호. 처음 보는 주소면 receiver 쪽 소켓을 새로 열어 연결. 자리가 없으면 -1
+static int peer_of(Router *rt, const struct sockaddr_in *from)
+{
+    for (int i = 0; i < rt->npeers; i++)
+        if (rt->peers[i].addr.sin_addr.s_addr == from->sin_addr.s_addr &&
+            rt->peers[i].addr.sin_port == from->sin_port)
+            return i;
+    if (rt->npeers == ROUTER_MAX_PEERS)
+        return -1;
+    Peer *p = &rt->peers[rt->npeers];
+    p->addr = *from;
+    p->fd = open_udp(0);
+    if (connect(p->fd, (struct sockaddr *)&rt->dst, sizeof(rt->dst)) < 0)
+        die("connect");
+    char ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &from->sin_addr, ip, sizeof(ip));
+    printf(YELLOW "[RTR] sender %s:%u 연결\n" RESET, ip, ntohs(from->sin_port));
+    return rt->npeers++;
+}
+
+// 링크가 비어 있는 동안 큐에서 꺼내 직렬화하고 전파 지연 라인에 넣음
+static void link_run(Router *rt, uint64_t now)
+{
+    while (rt->q.n && rt->link_free <= now)
+    {
+        uint64_t t = (uint64_t)rt->link_free;
+        AqmPkt *p = aqm_dequeue(&rt->q, t);
+        if (!p)
+            break;
+        double tx = p->len * 8e6 / rt->rate;
+        uint64_t start = t > p->t_enq ? t : p->t_enq;
+        rt->link_free = start + tx;
+        rt->busy_us += tx;
+        rt->iv_busy += tx;
+        rt->tx_pkts++;
+        rt->tx_bytes += p->len;
+        rt->iv_tx_bytes += p->len;
+        uint64_t soj = start - p->t_enq;
+        rt->iv_soj_sum += soj;
+        rt->iv_deq++;
+        if (soj > rt->iv_soj_max)
+            rt->iv_soj_max = soj;
+        rt->t_last_tx = (uint64_t)rt->link_free;
+        dl_push(&rt->fwd, (uint64_t)rt->link_free + rt->delay_us, p->tag, p->data, p->len);
+    }
+    // 비어 있는 링크는 다음 도착 시각부터 다시 잼
+    if (!rt->q.n && rt->link_free < now)
+        rt->link_free = now;
+}
+
+// 전달 시각이 된 패킷을 보냄. 이번에 전달한 END 수 반환
+static int deliver(Router *rt, uint64_t now)
+{
+    int ends = 0;
+    DlPkt *p;
+    while ((p = dl_head(&rt->fwd, now)))
+    {
+        SegHdr h;
+        if (seg_decode(p->data, p->len, &h) != SEG_FMT_INVALID && h.type == SEG_END)
+            ends++;
+        send(rt->peers[p->tag].fd, p->data, p->len, 0);
+        dl_pop(&rt->fwd);
+    }
+    while ((p = dl_head(&rt->rev, now)))
+    {
+        Peer *peer = &rt->peers[p->tag];
+        sendto(rt->lsock, p->data, p->len, 0, (struct sockaddr *)&peer->addr, sizeof(peer->addr));
+        dl_pop(&rt->rev);
+    }
+    return ends;
+}
+
+// 송신자 쪽 소켓에 온 것을 모두 큐에 넣음
+static void ingress(Router *rt)
+{
+    uint8_t buf[DGRAM_BUF];
+    struct sockaddr_in from;
+    socklen_t fl = sizeof(from);
+    ssize_t n;
+    while ((n = recvfrom(rt->lsock, buf, sizeof(buf), 0, (struct sockaddr *)&from, &fl)) >= 0)
+    {
+        fl = sizeof(from);
+        uint64_t now = now_us();
+        if (!rt->t_first)
+            rt->t_first = now;
+        int tag = peer_of(rt, &from);
+        if (tag < 0)
+        {
+            rt->no_peer++;
+            continue;
+        }
+        if (n > AQM_SLOT)
+        {
+            rt->rx_trunc++; // 세그먼트보다 큰 데이터그램 (GSO 는 커널이 나눠서 옴)
+            continue;
+        }
+        SegHdr h;
+        int data = seg_decode(buf, n, &h) != SEG_FMT_INVALID && h.type == SEG_DATA;
+        // 링크가 비어 있었으면 이 패킷부터 바로 전송 시작
+        if (!rt->q.n && rt->link_free < now)
+            rt->link_free = now;
+        aqm_enqueue(&rt->q, now, buf, (int)n, tag, !data);
+        link_run(rt, now);
+    }
+}
+
+// receiver 쪽 소켓에 돌아온 ACK 를 (지연 라인을 거쳐) 송신자에게
+static void egress(Router *rt, int i)
+{
+    uint8_t buf[DGRAM_BUF];
+    ssize_t n;
+    while ((n = recv(rt->peers[i].fd, buf, sizeof(buf), 0)) >= 0)
+    {
+        rt->acks++;
+        if (rt->delay_us || rt->rev.n)
+            dl_push(&rt->rev, now_us() + rt->delay_us, i, buf, n > AQM_SLOT ? AQM_SLOT : (int)n);
+        else
+            sendto(rt->lsock, buf, n, 0, (struct sockaddr *)&rt->peers[i].addr, sizeof(rt->peers[i].addr));
+    }
+}
+
+// -i 구간 한 줄 (-o 면 CSV 에도)
+static void interval_report(Router *rt, uint64_t now)
+{
+    double sec = (now - rt->iv_start) / 1e6;
+    if (sec <= 0)
+        return;
+    double mbps = rt->iv_tx_bytes * 8 / sec / 1e6;
+    double util = rt->iv_busy / (now - rt->iv_start);
+    if (util > 1) // 구간 끝에 걸친 패킷의 전송 시간까지 들어감
+        util = 1;
+    double soj = rt->iv_deq ? (double)rt->iv_soj_sum / rt->iv_deq : 0;
+    if (rt->csv)
+        fprintf(rt->csv, "%.1f,%u,%llu,%.1f,%llu,%llu,%llu,%llu,%.2f,%.4f\n", (now - rt->t_first) / 1e3, rt->q.n,
+                (unsigned long long)rt->q.bytes, soj, (unsigned long long)rt->iv_soj_max,
+                (unsigned long long)rt->q.enq, (unsigned long long)rt->q.drop_tail,
+                (unsigned long long)rt->q.drop_aqm, mbps, util);
+    else
+        printf("[RTR] t=%.2fs  q %u pkts (%.1f KB)  sojourn avg %.0f / max %llu us  drops %llu+%llu  "
+               "%.1f Mbit/s  util %.1f%%\n",
+               (now - rt->t_first) / 1e6, rt->q.n, rt->q.bytes / 1e3, soj, (unsigned long long)rt->iv_soj_max,
+               (unsigned long long)rt->q.drop_tail, (unsigned long long)rt->q.drop_aqm, mbps, util * 100);
+    rt->iv_start = now;
+    rt->iv_tx_bytes = rt->iv_soj_sum = rt->iv_soj_max = rt->iv_deq = 0;
+    rt->iv_busy = 0;
+}
+
+static void print_summary(Router *rt, const char *aqm_spec, int json)
+{
+    uint64_t now = now_us();
+    uint64_t end = rt->t_last_tx > rt->t_first ? rt->t_last_tx : now;
+    double sec = rt->t_first && end > rt->t_first ? (end - rt->t_first) / 1e6 : 0;
+    double util = sec > 0 ? rt->busy_us / (sec * 1e6) : 0;
+    double mbps = sec > 0 ? rt->tx_bytes * 8 / sec / 1e6 : 0;
+    Aqm *q = &rt->q;
+    double avg_q = aqm_avg_len(q, end);
+    uint64_t drops = q->drop_tail + q->drop_aqm;
+    uint64_t offered = q->enq + drops;
+
+    printf(BOLDMAG "\n=== [RTR] %.1f Mbit/s, buffer %d pkts, %s, delay %.1f ms ===\n" RESET, rt->rate / 1e6,
+           q->limit, aqm_spec, rt->delay_us / 1e3);
+    printf("  forwarded %llu pkts, %llu bytes in %.3fs  %.2f Mbit/s  link utilization %.1f%%\n",
+           (unsigned long long)rt->tx_pkts, (unsigned long long)rt->tx_bytes, sec, mbps, util * 100);
+    printf("  drops %llu (%.3f%%): %llu tail, %llu %s\n", (unsigned long long)drops,
+           offered ? 100.0 * drops / offered : 0.0, (unsigned long long)q->drop_tail,
+           (unsigned long long)q->drop_aqm, aqm_name(q->cfg.kind));
+    printf("  queue: avg %.1f pkts (time-weighted), seen by arrivals p50 %llu / p99 %llu, max %llu\n", avg_q,
+           (unsigned long long)hist_quantile(&q->occupancy, 0.5),
+           (unsigned long long)hist_quantile(&q->occupancy, 0.99), (unsigned long long)q->max_n);
+    printf("  sojourn p50 %llu / p99 %llu / p99.9 %llu / max %llu us\n",
+           (unsigned long long)hist_quantile(&q->sojourn, 0.5), (unsigned long long)hist_quantile(&q->sojourn, 0.99),
+           (unsigned long long)hist_quantile(&q->sojourn, 0.999), (unsigned long long)q->sojourn.max);
+    printf("  acks returned %llu, senders %d", (unsigned long long)rt->acks, rt->npeers);
+    if (rt->no_peer || rt->rx_trunc)
+        printf(", dropped %llu (too many senders), %llu (oversize)", (unsigned long long)rt->no_peer,
+               (unsigned long long)rt->rx_trunc);
+    printf("\n");
+    if (json)
+    {
+        printf("{\"aqm\":\"%s\",\"rate_mbps\":%.3f,\"buffer_pkts\":%d,\"delay_us\":%llu,\"pkts\":%llu,"
+               "\"bytes\":%llu,\"elapsed_s\":%.3f,\"tx_mbps\":%.2f,\"util\":%.4f,\"drop_tail\":%llu,"
+               "\"drop_aqm\":%llu,\"drop_ratio\":%.6f,\"q_avg_pkts\":%.2f,\"q_p99_pkts\":%llu,\"q_max_pkts\":%llu,"
+               "\"sojourn_p50_us\":%llu,\"sojourn_p99_us\":%llu,\"sojourn_p999_us\":%llu,\"sojourn_max_us\":%llu}\n",
+               aqm_name(q->cfg.kind), rt->rate / 1e6, q->limit, (unsigned long long)rt->delay_us,
+               (unsigned long long)rt->tx_pkts, (unsigned long long)rt->tx_bytes, sec, mbps, util,
+               (unsigned long long)q->drop_tail, (unsigned long long)q->drop_aqm,
+               offered ? (double)drops / offered : 0.0, avg_q,
+               (unsigned long long)hist_quantile(&q->occupancy, 0.99), (unsigned long long)q->max_n,
+               (unsigned long long)hist_quantile(&q->sojourn, 0.5), (unsigned long long)hist_quantile(&q->sojourn, 0.99),
+               (unsigned long long)hist_quantile(&q->sojourn, 0.999), (unsigned long long)q->sojourn.max);
+    }
+    fflush(stdout);
+}
+
+// 속도 "100m", "1g", "500k" (bit/s). 잘못된 형식이면 0
+static double parse_rate(const char *s)
+{
+    char *e;
+    double v = strtod(s, &e);
+    double scale = unit_scale(e);
+    return e == s || v <= 0 ? 0 : v * scale;
+}
+
+int main(int argc, char **argv)
+{
+    double rate = 100e6;          // -r
+    int limit = 100;              // -q
+    const char *aqm_spec = "droptail"; // -a
+    uint64_t delay_us = 0;        // -d
+    long max_ends = 1;            // -n
+    uint64_t iv_us = 1000000;     // -i
+    const char *csv_path = NULL;  // -o
+    uint64_t seed = 1;            // -s
+    int json = 0;                 // -j
+    int opt;
+    while ((opt = getopt(argc, argv, "r:q:a:d:n:i:o:s:j")) != -1)
+    {
+        if (opt == 'r')
+        {
+            if ((rate = parse_rate(optarg)) <= 0)
+            {
+                fprintf(stderr, "잘못된 속도: %s (예: 100m, 1g)\n", optarg);
+                return 1;
+            }
+        }
+        else if (opt == 'q')
+            limit = atoi(optarg);
+        else if (opt == 'a')
+            aqm_spec = optarg;
+        else if (opt == 'd' || opt == 'i')
+        {
+            if (imp_parse_us(optarg, opt == 'd' ? &delay_us : &iv_us) < 0)
+            {
+                fprintf(stderr, "잘못된 시간: %s (예: 10ms, 500us)\n", optarg);
+                return 1;
+            }
+        }
+        else if (opt == 'n')
+            max_ends = atol(optarg);
+        else if (opt == 'o')
+            csv_path = optarg;
+        else if (opt == 's')
+            seed = strtoull(optarg, NULL, 10);
+        else if (opt == 'j')
+            json = 1;
+        else
+        {
+            fprintf(stderr, "usage: %s [-r rate] [-q pkts] [-a droptail|red[:min:max:maxp[:wq]]|codel[:target[:interval]]] "
+                            "[-d delay] [-n flows] [-i interval] [-o series.csv] [-s seed] [-j] <listen_port> <dst_ip> <dst_port>\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (argc - optind < 3)
+    {
+        fprintf(stderr, "usage: router [-r rate] [-q pkts] [-a aqm] [-d delay] [-n flows] [-i interval] [-o series.csv] "
+                        "[-s seed] [-j] <listen_port> <dst_ip> <dst_port>\n");
+        return 1;
+    }
+    if (limit < 1)
+    {
+        fprintf(stderr, "-q 는 1 이상이어야 합니다\n");
+        return 1;
+    }
+    AqmCfg acfg;
+    if (aqm_parse(&acfg, aqm_spec) < 0)
+    {
+        fprintf(stderr, "잘못된 큐 관리 방식: %s\n"
+                        "  droptail | red[:min:max:maxp[:wq]] | codel[:target[:interval]]\n",
+                aqm_spec);
+        return 1;
+    }
+    acfg.seed = seed;
+
+    Router rt;
+    memset(&rt, 0, sizeof(rt));
+    rt.rate = rate;
+    rt.delay_us = delay_us;
+    rt.iv_us = iv_us;
+    rt.dst.sin_family = AF_INET;
+    rt.dst.sin_port = htons(atoi(argv[optind + 2]));
+    if (inet_pton(AF_INET, argv[optind + 1], &rt.dst.sin_addr) != 1)
+    {
+        fprintf(stderr, "잘못된 주소: %s\n", argv[optind + 1]);
+        return 1;
+    }
+    aqm_init(&rt.q, &acfg, limit, (uint64_t)((MSS + SEG_HDR_LEN) * 8e6 / rate));
+    dl_init(&rt.fwd);
+    dl_init(&rt.rev);
+    rt.lsock = open_udp(atoi(argv[optind]));
+    if (csv_path)
+    {
+        rt.csv = fopen(csv_path, "w");
+        if (!rt.csv)
+            die(csv_path);
+        fprintf(rt.csv, "t_ms,qlen_pkts,qlen_bytes,sojourn_avg_us,sojourn_max_us,enq,drop_tail,drop_aqm,tx_mbps,util\n");
+    }
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    printf(BOLDMAG "=== [RTR] :%s → %s:%s  %.1f Mbit/s, buffer %d pkts (%.1f ms), %s, delay %.1f ms ===\n" RESET,
+           argv[optind], argv[optind + 1], argv[optind + 2], rate / 1e6, limit,
+           limit * (MSS + SEG_HDR_LEN) * 8e3 / rate, aqm_spec, delay_us / 1e3);
+
+    struct pollfd pfd[ROUTER_MAX_PEERS + 1];
+    long ends = 0;
+    uint64_t stop_at = 0; // -n 개의 END 를 전달한 뒤 ACK 를 기다려 줄 시각
+    while (!interrupted)
+    {
+        uint64_t now = now_us();
+        link_run(&rt, now);
+        ends += deliver(&rt, now);
+        if (max_ends && ends >= max_ends && !stop_at)
+            stop_at = now + ROUTER_LINGER_US;
+        if (stop_at && now >= stop_at && !rt.rev.n)
+            break;
+        if (rt.t_first && iv_us && now >= rt.iv_next)
+        {
+            if (rt.iv_next)
+                interval_report(&rt, now);
+            else
+                rt.iv_start = now;
+            rt.iv_next = now + iv_us;
+        }
+
+        // 다음 할 일: 링크가 비는 시각, 지연 라인 머리의 전달 시각, 구간 출력, 종료
+        uint64_t due = 0;
+        if (rt.q.n)
+            due = (uint64_t)rt.link_free + 1;
+        if (rt.fwd.n && (!due || rt.fwd.ring[rt.fwd.head].due < due))
+            due = rt.fwd.ring[rt.fwd.head].due;
+        if (rt.rev.n && (!due || rt.rev.ring[rt.rev.head].due < due))
+            due = rt.rev.ring[rt.rev.head].due;
+        if (rt.iv_next && (!due || rt.iv_next < due))
+            due = rt.iv_next;
+        if (stop_at && (!due || stop_at < due))
+            due = stop_at;
+
+        int nfd = 0;
+        pfd[nfd].fd = rt.lsock;
+        pfd[nfd++].events = POLLIN;
+        for (int i = 0; i < rt.npeers; i++)
+        {
+            pfd[nfd].fd = rt.peers[i].fd;
+            pfd[nfd++].events = POLLIN;
+        }
+        struct timespec ts, *tsp = NULL;
+        if (due)
+        {
+            uint64_t w = due > now ? due - now : 0;
+            ts.tv_sec = w / 1000000;
+            ts.tv_nsec = (w % 1000000) * 1000;
+            tsp = &ts;
+        }
+        int r = ppoll(pfd, nfd, tsp, NULL);
+        if (r < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            die("ppoll");
+        }
+        if (r == 0)
+            continue;
+        if (pfd[0].revents & POLLIN)
+            ingress(&rt);
+        for (int i = 1; i < nfd; i++)
+            if (pfd[i].revents & POLLIN)
+                egress(&rt, i - 1);
+    }
+
+    if (rt.t_first && iv_us)
+        interval_report(&rt, now_us());
+    print_summary(&rt, aqm_spec, json);
+
+    if (rt.csv)
+        fclose(rt.csv);
+    for (int i = 0; i < rt.npeers; i++)
+        close(rt.peers[i].fd);
+    close(rt.lsock);
+    free(rt.fwd.ring);
+    free(rt.rev.ring);
+    aqm_free(&rt.q);
+    return 0;
+}
@@ -0,0 +1,77 @@
+// rto.h - RFC 6298 재전송 타임아웃 계산
+// RTT 표본으로 SRTT/RTTVAR 를 갱신해 RTO = SRTT + max(G, 4*RTTVAR) 를 구하고 [min, max] 로 제한한다.
+// 타임아웃이 나면 RTO 를 두 배로 늘리고(지수 백오프), 재전송된 세그먼트의 ACK 는
+// 어느 전송에 대한 응답인지 알 수 없으므로 표본으로 쓰지 않는다(Karn 규칙, 호출하는 쪽에서 거름).
+// 백오프된 RTO 는 재전송되지 않은 세그먼트로 새 표본을 얻을 때까지 유지된다.
+#ifndef RTO_H
+#define RTO_H
+
+#include <stdint.h>
+
+#define RTO_INIT_US 1000000   // 첫 표본 전 RTO (RFC 6298 2.1)
+#define RTO_MIN_US 2000       // 하한 (RFC 는 1초지만 us 단위 RTT 의 loopback 에 맞춤)
+#define RTO_MAX_US 60000000   // 상한
+#define RTO_GRANULARITY_US 1000 // 시계/스케줄링 오차 G
+
+typedef struct
+{
+    uint64_t srtt;   // us, 0 이면 표본 없음
+    uint64_t rttvar; // us
+    uint64_t rto;    // 현재 RTO (백오프 포함)
+    int backoff;     // 연속 타임아웃 횟수
+    uint64_t samples;
+} Rto;
+
+static inline void rto_init(Rto *r)
+{
+    r->srtt = 0;
+    r->rttvar = 0;
+    r->rto = RTO_INIT_US;
+    r->backoff = 0;
+    r->samples = 0;
+}
+
+static inline uint64_t rto_clamp(uint64_t v)
+{
+    if (v < RTO_MIN_US)
+        return RTO_MIN_US;
+    if (v > RTO_MAX_US)
+        return RTO_MAX_US;
+    return v;
+}
+
+// 재전송되지 않은 세그먼트의 RTT 표본 반영 (RFC 6298 2.2, 2.3). 백오프도 해제
+static inline void rto_sample(Rto *r, uint64_t rtt)
+{
+    if (!r->samples)
+    {
+        r->srtt = rtt;
+        r->rttvar = rtt / 2;
+    }
+    else
+    {
+        // RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|,  SRTT = 7/8 SRTT + 1/8 R
+        uint64_t err = r->srtt > rtt ? r->srtt - rtt : rtt - r->srtt;
+        r->rttvar = (3 * r->rttvar + err) / 4;
+        r->srtt = (7 * r->srtt + rtt) / 8;
+    }
+    r->samples++;
+
+    uint64_t var = 4 * r->rttvar;
+    r->rto = rto_clamp(r->srtt + (var > RTO_GRANULARITY_US ? var : RTO_GRANULARITY_US));
+    r->backoff = 0;
+}
+
+// 타임아웃: RTO 두 배 (RFC 6298 5.5)
+static inline void rto_backoff(Rto *r)
+{
+    r->rto = rto_clamp(r->rto * 2);
+    r->backoff++;
+}
+
+static inline uint64_t rto_get(const Rto *r)
+{
+    return r->rto;
+}
+
+#endif
@@ -0,0 +1,287 @@
+// segment.h - DATA/ACK/END 세그먼트 헤더 인코딩
+//
+// 기본은 고정 길이 바이너리 헤더(네트워크 바이트 순서)이며 파싱 없이 고정 오프셋에서
+// 바로 읽는다. 디버깅용으로 기존 텍스트 형식("DATA seq=%d len=%d", "ACK %d", "END")도
+// 그대로 지원하며, 수신 시 첫 바이트로 두 형식을 자동 구분한다.
+//
+//  0       1       2               4               8
+//  +-------+-------+---------------+---------------+
+//  |  ver  | type  |     flags     |      len      |
+//  +-------+-------+---------------+---------------+
+//  |                      seq (64)                 |
+//  +-----------------------------------------------+
+//  |                      ack (64)                 |
+//  +-----------------------+-----------------------+
+//  |      tsval (32)       |      tsecr (32)       |
+//  +-----------------------+-----------------------+
+//  |      conn (32)        |     csum (32)         |
+//  +-----------------------+-----------------------+  40 bytes
+//
+// conn 은 송신측이 고른 연결 id 로, 수신측은 (송신 주소, conn) 으로 플로우를 구분한다.
+//
+// SEG_F_SACK 가 켜진 ACK 는 헤더 뒤에 SACK 블록(start u64, end u64)을 len/16 개 싣는다.
+// SEG_F_FILE 이 켜진 END 는 seq 에 전송한 파일 크기, ack 에 내용 해시(fileio.h)를 싣는다.
+// SEG_F_CRC 가 켜진 DATA 는 csum 에 헤더(csum 자리는 0 으로 보고)와 페이로드의 CRC32C 를 싣는다.
+// 꺼져 있으면 csum 은 0 이고 검사하지 않는다.
+#ifndef SEGMENT_H
+#define SEGMENT_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "crc32c.h"
+
+#define SEG_VERSION 2
+#define SEG_HDR_LEN 40
+#define SEG_MAX_SACK 4  // ACK 한 개에 싣는 최대 SACK 블록 수
+#define SEG_SACK_LEN 16 // SACK 블록 하나의 크기
+
+// flags
+#define SEG_F_SACK 0x0001 // ACK 뒤에 SACK 블록이 붙어 있음
+#define SEG_F_FILE 0x0002 // END: 파일 전송 (seq = 크기, ack = 해시)
+#define SEG_F_CRC 0x0004  // DATA: csum 에 CRC32C 가 있음
+#define SEG_CSUM_OFF 36
+
+typedef enum
+{
+    SEG_DATA = 1,
+    SEG_ACK = 2,
+    SEG_END = 3
+} SegType;
+
+// 수신측이 이미 받아 둔 [start, end) 구간
+typedef struct
+{
+    uint64_t start;
+    uint64_t end;
+} SackBlock;
+
+// 수신한 세그먼트의 형식 (응답도 같은 형식으로 보낸다)
+typedef enum
+{
+    SEG_FMT_INVALID = 0,
+    SEG_FMT_BIN = 1,
+    SEG_FMT_TEXT = 2
+} SegFmt;
+
+typedef struct
+{
+    uint8_t type;   // SegType
+    uint16_t flags;
+    uint32_t len;   // DATA: 페이로드 길이
+    uint64_t seq;   // DATA: 시작 바이트 번호
+    uint64_t ack;   // ACK: 누적 ACK (다음에 기대하는 바이트)
+    uint32_t tsval; // 송신 시각 (us, 하위 32비트)
+    uint32_t tsecr; // 상대가 보낸 tsval 의 echo (RTT 측정용)
+    uint32_t conn;  // 연결 id (ACK 는 DATA 의 값을 그대로 돌려줌)
+    uint8_t nsack;  // ACK: SACK 블록 수
+    SackBlock sack[SEG_MAX_SACK];
+} SegHdr;
+
+// ------------------------------ big-endian 읽기/쓰기 ------------------------------
+static inline void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v;
+}
+static inline void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+static inline void put_u64(uint8_t *p, uint64_t v)
+{
+    put_u32(p, v >> 32);
+    put_u32(p + 4, (uint32_t)v);
+}
+static inline uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+static inline uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+static inline uint64_t get_u64(const uint8_t *p)
+{
+    return (uint64_t)get_u32(p) << 32 | get_u32(p + 4);
+}
+
+// ------------------------------ 인코딩 ------------------------------
+// 바이너리 헤더(+ SACK 블록)를 buf 에 쓰고 길이 반환
+static inline int seg_encode(const SegHdr *h, void *buf)
+{
+    uint8_t *p = buf;
+    int nsack = h->type == SEG_ACK ? h->nsack : 0;
+    p[0] = SEG_VERSION;
+    p[1] = h->type;
+    put_u16(p + 2, nsack ? h->flags | SEG_F_SACK : h->flags & ~SEG_F_SACK);
+    put_u32(p + 4, nsack ? (uint32_t)nsack * SEG_SACK_LEN : h->len);
+    put_u64(p + 8, h->seq);
+    put_u64(p + 16, h->ack);
+    put_u32(p + 24, h->tsval);
+    put_u32(p + 28, h->tsecr);
+    put_u32(p + 32, h->conn);
+    put_u32(p + SEG_CSUM_OFF, 0); // seg_seal 이 채움
+    for (int i = 0; i < nsack; i++)
+    {
+        put_u64(p + SEG_HDR_LEN + i * SEG_SACK_LEN, h->sack[i].start);
+        put_u64(p + SEG_HDR_LEN + i * SEG_SACK_LEN + 8, h->sack[i].end);
+    }
+    return SEG_HDR_LEN + nsack * SEG_SACK_LEN;
+}
+
+// 인코딩한 바이너리 헤더(hl 바이트)와 페이로드의 CRC32C. csum 자리는 0 으로 계산
+static inline uint32_t seg_csum(const uint8_t *hdr, int hl, const void *payload, size_t len)
+{
+    static const uint8_t zero[4];
+    uint32_t c = crc32c_extend(0, hdr, SEG_CSUM_OFF);
+    c = crc32c_extend(c, zero, 4);
+    c = crc32c_extend(c, hdr + SEG_CSUM_OFF + 4, hl - SEG_CSUM_OFF - 4);
+    return crc32c_extend(c, payload, len);
+}
+
+// 인코딩한 DATA 헤더에 SEG_F_CRC 를 켜고 CRC32C 를 채움 (crc32c_init 뒤에만)
+static inline void seg_seal(uint8_t *hdr, int hl, const void *payload, size_t len)
+{
+    put_u16(hdr + 2, get_u16(hdr + 2) | SEG_F_CRC);
+    put_u32(hdr + SEG_CSUM_OFF, seg_csum(hdr, hl, payload, len));
+}
+
+// 받은 바이너리 DATA 데이터그램의 CRC32C 확인 (SEG_F_CRC 가 켜진 경우만 호출)
+static inline int seg_csum_ok(const uint8_t *buf, size_t len)
+{
+    return get_u32(buf + SEG_CSUM_OFF) == seg_csum(buf, SEG_HDR_LEN, buf + SEG_HDR_LEN, len);
+}
+
+// 디버그용 텍스트 형식으로 쓰고 길이 반환
+// DATA 는 뒤에 페이로드가 붙으므로 헤더를 '\n' 으로 끝낸다. conn 은 0 이 아닐 때만 붙인다
+static inline int seg_encode_text(const SegHdr *h, char *buf, size_t cap)
+{
+    if (h->type == SEG_DATA && h->conn)
+        return snprintf(buf, cap, "DATA seq=%llu len=%u conn=%u\n",
+                        (unsigned long long)h->seq, h->len, h->conn);
+    if (h->type == SEG_DATA)
+        return snprintf(buf, cap, "DATA seq=%llu len=%u\n",
+                        (unsigned long long)h->seq, h->len);
+    if (h->type == SEG_ACK)
+    {
+        int n = snprintf(buf, cap, "ACK %llu", (unsigned long long)h->ack);
+        for (int i = 0; i < h->nsack && n < (int)cap; i++)
+            n += snprintf(buf + n, cap - n, "%s%llu-%llu", i == 0 ? " SACK " : " ",
+                          (unsigned long long)h->sack[i].start,
+                          (unsigned long long)h->sack[i].end);
+        return n < (int)cap ? n : (int)cap - 1;
+    }
+    if (h->conn)
+        return snprintf(buf, cap, "END conn=%u", h->conn);
+    return snprintf(buf, cap, "END");
+}
+
+static inline int seg_encode_fmt(SegFmt fmt, const SegHdr *h, void *buf, size_t cap)
+{
+    if (fmt == SEG_FMT_TEXT)
+        return seg_encode_text(h, buf, cap);
+    return seg_encode(h, buf);
+}
+
+// ------------------------------ 디코딩 ------------------------------
+// 헤더 뒤 페이로드의 시작 오프셋
+static inline size_t seg_payload_off(SegFmt fmt, const void *buf, size_t n)
+{
+    if (fmt == SEG_FMT_BIN)
+        return SEG_HDR_LEN < n ? SEG_HDR_LEN : n;
+    const char *nl = memchr(buf, '\n', n);
+    return nl ? (size_t)(nl - (const char *)buf) + 1 : n;
+}
+
+// buf 의 세그먼트를 h 로 읽는다. 바이너리는 고정 오프셋 읽기만 하며,
+// 텍스트 형식일 때만 sscanf 로 파싱한다. 알 수 없는 형식이면 SEG_FMT_INVALID
+static inline SegFmt seg_decode(const void *buf, size_t n, SegHdr *h)
+{
+    const uint8_t *p = buf;
+    if (n >= SEG_HDR_LEN && p[0] == SEG_VERSION)
+    {
+        h->type = p[1];
+        h->flags = get_u16(p + 2);
+        h->len = get_u32(p + 4);
+        h->seq = get_u64(p + 8);
+        h->ack = get_u64(p + 16);
+        h->tsval = get_u32(p + 24);
+        h->tsecr = get_u32(p + 28);
+        h->conn = get_u32(p + 32);
+        h->nsack = 0;
+        if (h->type < SEG_DATA || h->type > SEG_END)
+            return SEG_FMT_INVALID;
+        if (h->type == SEG_ACK && (h->flags & SEG_F_SACK))
+        {
+            size_t k = h->len / SEG_SACK_LEN;
+            if (k > SEG_MAX_SACK)
+                k = SEG_MAX_SACK;
+            if (n < SEG_HDR_LEN + k * SEG_SACK_LEN)
+                return SEG_FMT_INVALID;
+            for (size_t i = 0; i < k; i++)
+            {
+                h->sack[i].start = get_u64(p + SEG_HDR_LEN + i * SEG_SACK_LEN);
+                h->sack[i].end = get_u64(p + SEG_HDR_LEN + i * SEG_SACK_LEN + 8);
+            }
+            h->nsack = k;
+        }
+        return SEG_FMT_BIN;
+    }
+
+    // 텍스트(디버그) 형식: NUL 종료 복사본에서 파싱
+    char txt[256];
+    size_t m = n < sizeof(txt) - 1 ? n : sizeof(txt) - 1;
+    memcpy(txt, buf, m);
+    txt[m] = 0;
+
+    memset(h, 0, sizeof(*h));
+    unsigned long long a = 0, b = 0;
+    // 헤더 줄의 conn=N (없으면 0)
+    char *nl = strchr(txt, '\n');
+    if (nl)
+        *nl = 0;
+    const char *cp = strstr(txt, " conn=");
+    if (cp)
+        h->conn = (uint32_t)strtoul(cp + 6, NULL, 10);
+
+    if (strncmp(txt, "END", 3) == 0)
+    {
+        h->type = SEG_END;
+        return SEG_FMT_TEXT;
+    }
+    if (sscanf(txt, "DATA seq=%llu len=%llu", &a, &b) == 2)
+    {
+        h->type = SEG_DATA;
+        h->seq = a;
+        h->len = (uint32_t)b;
+        return SEG_FMT_TEXT;
+    }
+    if (sscanf(txt, "ACK %llu", &a) == 1)
+    {
+        h->type = SEG_ACK;
+        h->ack = a;
+        const char *sp = strstr(txt, " SACK ");
+        if (sp)
+        {
+            sp += 6;
+            int used = 0;
+            while (h->nsack < SEG_MAX_SACK && sscanf(sp, "%llu-%llu%n", &a, &b, &used) == 2)
+            {
+                h->sack[h->nsack].start = a;
+                h->sack[h->nsack].end = b;
+                h->nsack++;
+                sp += used;
+            }
+        }
+        return SEG_FMT_TEXT;
+    }
+    return SEG_FMT_INVALID;
+}
+
+#endif
@@ -1,48 +1,62 @@
 // sender.c - TCP 혼잡제어 송신자
 // 실행 방법:
 //    ./sender <dst_ip> <dst_port> <normal|dup3|timeout>
-
+//    ./sender [-n bytes | -T sec] <dst_ip> <dst_port> bulk   (MSS 크기 데이터그램 대량 전송)
+//    ./sender -s <normal|dup3|timeout>     (가상 시계 시뮬레이션, 소켓/sleep 없음)
+//    -t: 세그먼트를 바이너리 헤더 대신 디버그용 텍스트 형식으로 전송
+//    -b: sendmmsg/recvmmsg 배치 송수신 (윈도우 단위 전송, ACK 일괄 수신)
+//    -e: bulk 를 epoll + timerfd 이벤트 루프의 슬라이딩 윈도우로 실행
+//    -c: 혼잡제어 알고리즘 선택 (reno|newreno|cubic|bbr, 기본 reno)
+//    -C: 세그먼트 헤더의 연결 id (기본 pid)
+//    -q: 사건별 컬러 출력 대신 바이너리 트레이스를 파일로 기록 (tracedump 로 확인)
+//    -w: bulk 의 최대 윈도우 (MSS 개수, 수신 윈도우처럼 cwnd 와 함께 in-flight 를 제한)
+//    -j: bulk 결과를 JSON 한 줄로도 출력 (bench 가 읽음)
+//    -M: UDP 대신 공유 메모리 링으로 receiver -M 과 통신 (ip/port 대신 세그먼트 이름, -b/-e 와는 함께 못 씀)
+//    -y: -M 에서 ACK 를 기다릴 때 잠들지 않고 busy-poll
+//    -A: ABC 느린시작 한도 L (ACK 하나로 늘릴 수 있는 최대 MSS 수, 기본 2, 0 이면 ACK 개수로 셈).
+//        receiver -d/-k 로 ACK 가 줄어도 cwnd 증가 속도를 유지
+//    -P: bulk 페이싱 (timer|fq). cwnd/SRTT 로 정한 속도로 세그먼트 간격을 둠 (pacer.h)
+//        timer 는 사용자 공간 타이머, fq 는 SO_MAX_PACING_RATE 로 커널 fq qdisc 에 맡김
+//    -F: bulk 로 파일 전송. 파일을 mmap 하고 페이로드는 매핑을 가리키는 iovec 으로 복사 없이 보냄
+//        (전송량 = 파일 크기, receiver -F 가 END 의 크기/해시로 결과를 확인, fileio.h)
+//    -K: DATA 세그먼트마다 헤더와 페이로드의 CRC32C 를 실어 보냄 (receiver 가 확인, crc32c.h)
+//    -g: bulk DATA 를 UDP GSO(UDP_SEGMENT)로 전송. 연속한 세그먼트를 최대 64KB 슈퍼 데이터그램으로 묶어
+//        커널이 세그먼트 단위로 자르게 하고, 슈퍼 데이터그램 여러 개를 sendmmsg 한 번으로 보냄 (receiver -g 와 짝)
+//    -B: bulk 경로의 대역폭-지연 곱 ("<rate bit/s>:<rtt ms>" 예 10g:80, 또는 바이트 수 예 100m).
+//        재전송 큐와 소켓 버퍼를 BDP 의 두 배로 잡고 느린시작 임계치를 BDP 로 시작 (receiver -B 와 같은 값)
+
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <errno.h>
-
-// 기본 설정
-#define MSS 1500 // 초기 임계치
-#define BUF 256
-#define SLEEP_US 1500000
-
-// 컬러 코드
-#define RESET "\033[0m"
-#define RED "\033[31m"
-#define GREEN "\033[32m"
-#define YELLOW "\033[33m"
-#define BLUE "\033[34m"
-#define MAGENTA "\033[35m"
-#define CYAN "\033[36m"
-#define WHITE "\033[37m"
-#define BOLDRED "\033[1;31m"
-#define BOLDYEL "\033[1;33m"
-#define BOLDMAG "\033[1;35m"
-#define BOLDCYN "\033[1;36m"
-
-typedef enum // 시나리오 구분을 위한 구조체
-{
-    MODE_NORMAL,
-    MODE_DUP3,
-    MODE_TIMEOUT
-} Mode;
-
-// 에러 발생 시 프로그램 종료을 위한 함수
-void die(const char *msg)
-{
-    perror(msg);
-    exit(1);
-}
+#include <time.h>
+
+#include "batch_io.h"
+#include "cc.h"
+#include "common.h"
+#include "evloop.h"
+#include "fileio.h"
+#include "hist.h"
+#include "pacer.h"
+#include "rcv_logic.h"
+#include "rto.h"
+#include "segment.h"
+#include "sim.h"
+#include "sndq.h"
+#include "trace.h"
+#include "transport.h"
+
+// 시뮬레이션 모드(-s)의 가상 시간 파라미터 (실시간 모드의 sleep 값과 맞춤)
+#define SIM_TX_GAP_US 300000   // 라운드 내 세그먼트 전송 간격
+#define SIM_OWD_US 10000       // 단방향 지연
+#define SIM_RTO_US 3000000     // 재전송 타이머 (손실 구간 4개를 다 보낸 뒤 만료되도록 고정)
+#define SIM_ROUND_GAP_US SLEEP_US
 
 // 인자로 받은 시나리오 명을 구조체로 바꿔주는 함수
 Mode parse_mode(const char *s)
@@ -53,115 +67,326 @@ Mode parse_mode(const char *s)
         return MODE_DUP3;
     if (strcmp(s, "timeout") == 0)
         return MODE_TIMEOUT;
+    if (strcmp(s, "bulk") == 0)
+        return MODE_BULK;
     fprintf(stderr, "unknown mode: %s\n", s);
     exit(1);
 }
 
+// ------------------------------ 세그먼트 송수신 ------------------------------
+SegFmt wire_fmt = SEG_FMT_BIN; // -t: 디버그용 텍스트 형식
+
+// 모든 세그먼트에 싣는 연결 id (-C, 기본은 pid). 수신측은 (주소, conn) 으로 플로우를 구분
+uint32_t conn_id;
+
+// 모든 DATA 세그먼트가 실어 보내는 페이로드 (실제 MSS 크기 데이터그램)
+static uint8_t payload[MSS];
+
+// -K: DATA 헤더에 CRC32C 를 채움 (바이너리 형식만)
+static int csum_on;
+
+// 송수신에 사용한 syscall 수 (bulk 결과의 syscalls/byte)
+uint64_t n_syscalls = 0;
+
+// -b: 보낼 DATA 를 모았다가 sendmmsg 로, ACK 는 recvmmsg 로 한꺼번에 받아 하나씩 꺼냄
+static TxBatch *txq;
+static RxBatch *ackq;
+static int ack_pos, ack_cnt;
+
+// -g: 보낼 DATA 를 GSO 슈퍼 데이터그램에 모음 (txq 대신)
+static GsoBatch *gsoq;
+
+// 모아 둔 DATA 를 전송 (ACK 를 기다리기 전에 호출)
+void flush_data(Transport *tp)
+{
+    if (gsoq && gsoq->n > 0)
+        gsob_flush(tp->fd, gsoq, &n_syscalls);
+    if (txq && txq->n > 0)
+        txb_flush(tp->fd, txq, &n_syscalls);
+}
+
+void send_seg(Transport *tp, struct sockaddr_in *dst, const SegHdr *h)
+{
+    flush_data(tp);
+    SegHdr c = *h;
+    c.conn = conn_id;
+    uint8_t buf[BUF];
+    int n = seg_encode_fmt(wire_fmt, &c, buf, sizeof(buf));
+    tp_sendv(tp, dst, buf, n, NULL, 0);
+}
+
+// DATA 세그먼트 하나 전송: 헤더 + data 의 len 바이트 (UDP 는 복사 없이 iovec 으로 묶어 보냄)
+// -b/-g 이면 배치에 넣기만 하고 flush_data/recv_ack 시점에 한 번에 전송 (data 는 그때까지 유효해야 함)
+void send_data_buf(Transport *tp, struct sockaddr_in *dst, int64_t seq, const uint8_t *data, int len)
+{
+    SegHdr h = {0};
+    h.type = SEG_DATA;
+    h.len = len;
+    h.seq = seq;
+    h.tsval = (uint32_t)now_us();
+    h.conn = conn_id;
+
+    if (gsoq)
+    {
+        uint8_t *hdr = gsob_hdr(gsoq, dst, SEG_HDR_LEN + len);
+        if (!hdr)
+        {
+            flush_data(tp);
+            hdr = gsob_hdr(gsoq, dst, SEG_HDR_LEN + len);
+        }
+        int hl = seg_encode(&h, hdr);
+        if (csum_on)
+            seg_seal(hdr, hl, data, len);
+        gsob_commit(gsoq, hl, data, len);
+        return;
+    }
+
+    if (txq)
+    {
+        uint8_t *hdr = txb_hdr(txq);
+        int hl = seg_encode_fmt(wire_fmt, &h, hdr, IO_HDR_MAX);
+        if (csum_on)
+            seg_seal(hdr, hl, data, len);
+        txb_commit(txq, dst, hl, data, len);
+        if (txb_full(txq))
+            flush_data(tp);
+        return;
+    }
+
+    uint8_t hdr[BUF];
+    int hl = seg_encode_fmt(wire_fmt, &h, hdr, sizeof(hdr));
+    if (csum_on)
+        seg_seal(hdr, hl, data, len);
+    tp_sendv(tp, dst, hdr, hl, data, len);
+}
+
+void send_data_len(Transport *tp, struct sockaddr_in *dst, int64_t seq, int len)
+{
+    send_data_buf(tp, dst, seq, payload, len);
+}
+
+// 재전송 큐에 든 세그먼트를 (재)전송. 슬랩에 보관된 바이트를 그대로 보낸다
+void send_queued(Transport *tp, struct sockaddr_in *dst, SndQ *q, SqSeg *s)
+{
+    s->xmits++;
+    send_data_buf(tp, dst, s->seq, sq_data(q, s), s->len);
+}
+
+void send_data(Transport *tp, struct sockaddr_in *dst, int64_t seq)
+{
+    send_data_len(tp, dst, seq, MSS);
+}
+
+// ACK 하나를 받아 *h 에 채우고 누적 ACK 값을 반환. 수신 실패/timeout 시 -1 (errno 유지)
+int64_t recv_ack_hdr(Transport *tp, SegHdr *out)
+{
+    SegHdr h;
+    flush_data(tp);
+
+    if (ackq)
+    {
+        while (1)
+        {
+            while (ack_pos < ack_cnt)
+            {
+                int i = ack_pos++;
+                if (seg_decode(rxb_data(ackq, i), rxb_len(ackq, i), &h) != SEG_FMT_INVALID &&
+                    h.type == SEG_ACK)
+                {
+                    *out = h;
+                    return (int64_t)h.ack;
+                }
+            }
+            ack_pos = 0;
+            ack_cnt = rxb_recv(tp->fd, ackq, &n_syscalls);
+            if (ack_cnt < 0)
+            {
+                ack_cnt = 0;
+                return -1;
+            }
+        }
+    }
+
+    while (1)
+    {
+        const uint8_t *buf;
+        int n = tp_recv(tp, &buf, NULL);
+        if (n < 0)
+            return -1;
+        SegFmt fmt = seg_decode(buf, n, &h);
+        tp_recv_done(tp);
+        if (fmt != SEG_FMT_INVALID && h.type == SEG_ACK)
+        {
+            *out = h;
+            return (int64_t)h.ack;
+        }
+    }
+}
+
+int64_t recv_ack(Transport *tp)
+{
+    SegHdr h;
+    return recv_ack_hdr(tp, &h);
+}
+
 // 송수신 끝을 알리는 함수
-void send_end(int s, struct sockaddr_in *dst)
+void send_end(Transport *tp, struct sockaddr_in *dst)
 {
-    const char *msg = "END";
-    sendto(s, msg, strlen(msg), 0, (struct sockaddr *)dst, sizeof(*dst));
+    SegHdr h = {0};
+    h.type = SEG_END;
+    send_seg(tp, dst, &h);
 }
 
 // ------------------------------ UI 유틸 ------------------------------
+// -q 이면 사건별 출력을 끄고 tr() 로 남기는 트레이스 레코드만 기록한다 (trace.h)
+static int quiet;
+#define say(...)                 \
+    do                           \
+    {                            \
+        if (!quiet)              \
+            printf(__VA_ARGS__); \
+    } while (0)
+
+static Sim *sim_clock; // 시뮬레이션 중이면 트레이스 시각은 가상 시계
+
+static void tr(int ev, int64_t seq, int64_t ack, const Cc *cc, uint32_t aux)
+{
+    trace_emit(ev, sim_clock ? sim_clock->now : now_us(), seq, ack, cc->cwnd, cc->ssthresh, aux);
+}
+
 void box_top()
 {
-    printf(MAGENTA "┌──────────────────────────────────────────────────────────┐\n" RESET);
+    say(MAGENTA "┌──────────────────────────────────────────────────────────┐\n" RESET);
 }
 void box_mid()
 {
-    printf(MAGENTA "├──────────────────────────────────────────────────────────┤\n" RESET);
+    say(MAGENTA "├──────────────────────────────────────────────────────────┤\n" RESET);
 }
 void box_bot()
 {
-    printf(MAGENTA "└──────────────────────────────────────────────────────────┘\n" RESET);
+    say(MAGENTA "└──────────────────────────────────────────────────────────┘\n" RESET);
 }
 
-void show_round_header(int round, double cwnd, double ssthresh)
+void show_round_header(int round, const Cc *cc)
 {
+    tr(TR_ROUND, 0, 0, cc, round);
     box_top();
-    printf(MAGENTA "│  ROUND %d  │  cwnd = %.2f MSS   ssthresh = %.2f MSS          │\n" RESET,
-           round, cwnd / MSS, ssthresh / MSS);
+    say(MAGENTA "│  ROUND %d  │  cwnd = %.2f MSS   ssthresh = %.2f MSS          │\n" RESET,
+        round, cc->cwnd / MSS, cc->ssthresh / MSS);
     box_mid();
 }
+void show_round_end(const Cc *cc)
+{
+    tr(TR_ROUND_END, 0, 0, cc, 0);
+    box_bot();
+}
 void show_event(const char *msg)
 {
-    printf(BOLDRED "%s\n" RESET, msg);
+    say(BOLDRED "%s\n" RESET, msg);
 }
 void show_timer_event(const char *msg)
 {
-    printf(BOLDCYN "%s\n" RESET, msg);
+    say(BOLDCYN "%s\n" RESET, msg);
+}
+
+// ------------------------------ 혼잡제어 ------------------------------
+// cwnd/ssthresh 갱신은 cc.h 의 알고리즘이 맡는다 (-c 로 선택, 기본 reno).
+// 실시간 모드와 시뮬레이션 모드가 같은 훅을 호출한다.
+static const CcOps *cc_algo = &cc_reno;
+static int abc_l = CC_ABC_L; // -A: 느린시작에서 ACK 하나로 늘릴 수 있는 최대 MSS 수 (0 이면 ACK 개수 기준)
+
+// 선택된 알고리즘과 -A 로 혼잡제어 상태 초기화
+static void cc_start(Cc *cc, double cwnd, double ssthresh)
+{
+    cc_init(cc, cc_algo, cwnd, ssthresh);
+    cc->abc_l = abc_l;
+}
+
+// 라운드 단위 ACK 로 cwnd 를 늘리고 결과 출력. 느린시작이었으면 1, 아니면 0 반환
+int grow_cwnd(Cc *cc, uint64_t now)
+{
+    int g = cc_on_ack(cc, MSS, 0, now);
+    tr(g == CC_GROW_SS ? TR_GROW_SS : TR_GROW_CA, 0, 0, cc, 0);
+    if (g == CC_GROW_SS)
+        say(YELLOW "     ↳ Slow Start 증가 → cwnd=%.2f MSS\n" RESET, cc->cwnd / MSS);
+    else
+        say(YELLOW "     ↳ CA 증가 → cwnd=%.2f MSS\n" RESET, cc->cwnd / MSS);
+    return g == CC_GROW_SS;
+}
+
+// 3 중복 ACK 이후 첫 새 ACK 처리 결과 출력 (dup3 시나리오)
+void show_recovery_ack(int g, int64_t ack, const Cc *cc)
+{
+    tr(g == CC_GROW_NONE ? TR_RECOVERED : g == CC_GROW_SS ? TR_GROW_SS : TR_GROW_CA, 0, ack, cc, 0);
+    if (g == CC_GROW_NONE)
+        say(YELLOW "    빠른 회복 종료 → cwnd=%.2f MSS\n" RESET, cc->cwnd / MSS);
+    else
+        say(YELLOW "    %s 증가 1회 → cwnd=%.2f MSS\n" RESET,
+            g == CC_GROW_SS ? "Slow Start" : "CA", cc->cwnd / MSS);
+}
+
+// ACK 를 받아 에코된 송신 시각(tsecr)으로 RTT 표본을 혼잡제어에 넘기고 누적 ACK 값 반환
+int64_t recv_ack_cc(Transport *tp, Cc *cc)
+{
+    SegHdr h;
+    int64_t ack = recv_ack_hdr(tp, &h);
+    if (ack >= 0 && h.tsecr)
+    {
+        uint64_t now = now_us();
+        cc_on_rtt_sample(cc, (uint32_t)now - h.tsecr, now);
+    }
+    return ack;
 }
 
 // ------------------------------ NORMAL ------------------------------
-void run_normal(int s, struct sockaddr_in *dst)
+void run_normal(Transport *tp, struct sockaddr_in *dst)
 {
-    double cwnd = MSS;
-    int ssthresh = 15000;
-    int seq = 0;
+    Cc cc;
+    cc_start(&cc, MSS, 15000);
+    int64_t seq = 0;
     int round = 1; // 한 시나리오 내 라운드 구분을 위한 변수
 
-    printf(BOLDMAG "\n=== [NORMAL 시나리오 시작] ===\n" RESET);
+    say(BOLDMAG "\n=== [NORMAL 시나리오 시작] ===\n" RESET);
 
     int slow_start_rounds = 0; // 느린시작 라운드
     int ca_rounds = 0;         // 위험회피 라운드
 
     while (1)
     {
-        int packets = cwnd / MSS; // 보낼 패킷 수 = 윈도우 크기 / MSS
+        int packets = cc.cwnd / MSS; // 보낼 패킷 수 = 윈도우 크기 / MSS
         if (packets < 1)
             packets = 1;
 
-        show_round_header(round, cwnd, ssthresh);
+        show_round_header(round, &cc);
 
         // 패킷 수만큼 보내기
         for (int i = 0; i < packets; i++)
         {
-            printf(BLUE "  [TX] seq=%d len=%d\n" RESET, seq, MSS);
-            char buf[BUF];
-            snprintf(buf, sizeof(buf), "DATA seq=%d len=%d", seq, MSS);           // buf에 seq와 len에 대한 문자열 저장
-            sendto(s, buf, strlen(buf), 0, (struct sockaddr *)dst, sizeof(*dst)); // buf의 내용을 그대로 전송
-            seq += MSS;                                                           // 보낸만큼 seq 업데이트
-            usleep(300000);                                                       // 0.3초 딜레이
+            tr(TR_TX, seq, 0, &cc, MSS);
+            say(BLUE "  [TX] seq=%lld len=%d\n" RESET, (long long)seq, MSS);
+            send_data(tp, dst, seq); // seq와 len을 담은 DATA 세그먼트 전송
+            seq += MSS;             // 보낸만큼 seq 업데이트
+            usleep(300000);         // 0.3초 딜레이
         }
 
-        printf(CYAN "  --- RTT 경과: ACK 수신 ---\n" RESET);
+        say(CYAN "  --- RTT 경과: ACK 수신 ---\n" RESET);
 
         // ACK 받기
         for (int i = 0; i < packets; i++)
         {
-            char buf[BUF];
-            struct sockaddr_in src;
-            socklen_t slen = sizeof(src);
-
-            int n = recvfrom(s, buf, sizeof(buf) - 1, 0,
-                             (struct sockaddr *)&src, &slen);
-            if (n < 0)
+            int64_t ack = recv_ack_cc(tp, &cc);
+            if (ack < 0)
                 die("recvfrom normal");
-            buf[n] = 0;
-            int ack = 0;
-            sscanf(buf, "ACK %d", &ack);
-            printf(GREEN "  [RX] ACK %d\n" RESET, ack);
+            tr(TR_ACK, 0, ack, &cc, 0);
+            say(GREEN "  [RX] ACK %lld\n" RESET, (long long)ack);
 
-            // 윈도우 크기가 임계치보다 작다면 느린시작 -> 지수적 증가
-            if ((int)cwnd < ssthresh)
-            {
+            if (grow_cwnd(&cc, now_us()))
                 slow_start_rounds++;
-                cwnd += MSS;
-                printf(YELLOW "     ↳ Slow Start 증가 → cwnd=%.2f MSS\n" RESET, cwnd / MSS);
-            }
-            // 아니면 혼잡회피 -> 선형적 증가
             else
-            {
                 ca_rounds++;
-                double inc = MSS * ((double)MSS / cwnd);
-                cwnd += inc;
-                printf(YELLOW "     ↳ CA 증가 → cwnd=%.2f MSS\n" RESET, cwnd / MSS);
-            }
         }
 
-        box_bot();
+        show_round_end(&cc);
         usleep(SLEEP_US);
         round++;
 
@@ -170,53 +395,70 @@ void run_normal(int s, struct sockaddr_in *dst)
             break;
     }
 
-    printf(BOLDMAG "\n=== [NORMAL 시나리오 종료] ===\n" RESET);
-    send_end(s, dst);
+    say(BOLDMAG "\n=== [NORMAL 시나리오 종료] ===\n" RESET);
+    tr(TR_END, 0, 0, &cc, 0);
+    send_end(tp, dst);
 }
 
 // ------------------------------ 3 DUP ACK ------------------------------
-void run_dup3(int s, struct sockaddr_in *dst)
+// 보낸 세그먼트는 ACK 될 때까지 재전송 큐에 보관하고, 3 중복 ACK 를 받으면 큐 맨 앞(가장 오래된
+// 미확인 세그먼트)을 빠른 재전송한다. 수신측은 seq=3000 을 잃어버린 것으로 연출됨 (rcv_logic.h)
+#define DUP3_FIRST 1500
+#define DUP3_END 7500 // 보낼 구간 [1500, 7500) = 세그먼트 4개
+
+void run_dup3(Transport *tp, struct sockaddr_in *dst)
 {
     // 초기 윈도우 크기와 임계치 설정
-    double cwnd = 15000;
-    int ssthresh = 15000;
+    Cc cc;
+    cc_start(&cc, 15000, 15000);
 
-    printf(BOLDMAG "\n=== [3 DUP ACK 시나리오 시작] ===\n" RESET);
+    say(BOLDMAG "\n=== [3 DUP ACK 시나리오 시작] ===\n" RESET);
 
-    int seqs[] = {1500, 3000, 4500, 6000, 3000}; // 임의적으로 3 dup를 발생시키기 위해 seq 순서에 대한 배열 생성(3000에 대해 3 dup인 상황)
-    int count = sizeof(seqs) / sizeof(seqs[0]);
-    int lastAck = -1; // 마지막으로 받은 ack
-    int dupCnt = 0;   // 중복 ack 횟수
-    int halved = 0;   // cwnd 절반 감소 여부를 나타내는 플래그
+    SndQ q;
+    sq_init(&q, 64);
+    int64_t next = DUP3_FIRST; // 다음에 보낼 새 데이터
+    int64_t lastAck = -1;      // 마지막으로 받은 ack
+    int dupCnt = 0;        // 중복 ack 횟수
+    int halved = 0;        // cwnd 절반 감소 여부를 나타내는 플래그
+    int fast_retx = 0;     // 다음 전송은 큐 맨 앞의 빠른 재전송
 
-    for (int i = 0; i < count; i++)
+    while (next < DUP3_END || sq_count(&q) > 0)
     {
-        char buf[BUF];
-        int seq = seqs[i];
-
-        // send
-        printf(BLUE "\n[TX] seq=%d len=%d\n" RESET, seq, MSS);
-        snprintf(buf, sizeof(buf),
-                 "DATA seq=%d len=%d", seq, MSS);
-        sendto(s, buf, strlen(buf), 0,
-               (struct sockaddr *)dst, sizeof(*dst));
+        // send: 빠른 재전송이 걸려 있으면 큐 맨 앞, 아니면 새 세그먼트
+        SqSeg *sg;
+        if (fast_retx)
+        {
+            fast_retx = 0;
+            sg = sq_head(&q);
+            tr(TR_RETX, sg->seq, 0, &cc, sg->len);
+            say(BLUE "\n[TX] seq=%lld len=%u (재전송: 큐 맨 앞의 빠른 재전송)\n" RESET,
+                (long long)sg->seq, sg->len);
+        }
+        else if (next < DUP3_END)
+        {
+            sg = sq_push(&q, next, payload, MSS);
+            next += MSS;
+            tr(TR_TX, sg->seq, 0, &cc, MSS);
+            say(BLUE "\n[TX] seq=%lld len=%d\n" RESET, (long long)sg->seq, MSS);
+        }
+        else
+        {
+            say(RED "    보낼 세그먼트가 없는데 미확인 데이터가 남음 (%u개)\n" RESET, sq_count(&q));
+            break;
+        }
+        send_queued(tp, dst, &q, sg);
         usleep(SLEEP_US);
 
         // recv ack
-        struct sockaddr_in src;
-        socklen_t slen = sizeof(src);
-        int n = recvfrom(s, buf, sizeof(buf) - 1, 0,
-                         (struct sockaddr *)&src, &slen);
-        if (n < 0)
+        int64_t ack = recv_ack_cc(tp, &cc);
+        if (ack < 0)
             die("recvfrom dup3");
-        buf[n] = 0;
-
-        int ack = 0;
-        sscanf(buf, "ACK %d", &ack);
-        printf(GREEN "[RX] ACK %d 수신\n" RESET, ack);
+        tr(TR_ACK, 0, ack, &cc, 0);
+        say(GREEN "[RX] ACK %lld 수신\n" RESET, (long long)ack);
 
-        if (i == 0)
+        if (lastAck < 0)
         {
+            sq_ack(&q, ack);
             lastAck = ack;
             dupCnt = 0;
         }
@@ -224,35 +466,37 @@ void run_dup3(int s, struct sockaddr_in *dst)
         else if (ack == lastAck)
         {
             dupCnt++;
-            printf(YELLOW "    중복 ACK (%d회)\n" RESET, dupCnt);
+            tr(TR_DUPACK, 0, ack, &cc, dupCnt);
+            say(YELLOW "    중복 ACK (%d회)\n" RESET, dupCnt);
+
+            double prev = cc.cwnd; // 감소 이전 cwnd 값
+            if (!halved)
+                cc_on_dupack(&cc, dupCnt, now_us());
 
             if (dupCnt == 3 && !halved) // 중복 횟수가 3이고 cwnd가 절반으로 감소된 적이 없다면
             {
+                tr(TR_DUP3, 0, ack, &cc, (uint32_t)prev);
                 show_event("\n*** <<< 3 DUP ACK 사건 발생 >>> ***");
 
-                double prev = cwnd; // 감소 이전 cwnd 값
-                cwnd /= 2.0;
-                if (cwnd < MSS)
-                    cwnd = MSS;
-                ssthresh = cwnd; // 임계치 조정
-
-                printf(BOLDYEL "    cwnd: %.1f MSS → %.1f MSS\n" RESET,
-                       prev / MSS, cwnd / MSS);
-                printf(BOLDMAG "    ssthresh = %.1f MSS\n" RESET, ssthresh / MSS);
-                halved = 1; // 절반으로 감소했음을 표시
+                say(BOLDYEL "    cwnd: %.1f MSS → %.1f MSS\n" RESET,
+                    prev / MSS, cc.cwnd / MSS);
+                say(BOLDMAG "    ssthresh = %.1f MSS\n" RESET, cc.ssthresh / MSS);
+                halved = 1;    // 절반으로 감소했음을 표시
+                fast_retx = 1; // 잃어버린 세그먼트(ACK 가 가리키는 곳)를 큐에서 다시 보냄
             }
         }
         // 중복 ack가 아닌 새로운 값이 도착 = 복구 및 위험회피 구간
         else
         {
-            printf(CYAN "    새로운 ACK → 누적 구간 복구 처리\n" RESET);
+            uint32_t freed = sq_ack(&q, ack);
+            say(CYAN "    새로운 ACK → 누적 구간 복구 처리 (재전송 큐에서 %u개 해제, 남은 %u개)\n" RESET,
+                freed, sq_count(&q));
 
             // 위험회피
             if (halved)
             {
-                double inc = MSS * ((double)MSS / cwnd);
-                cwnd += inc;
-                printf(YELLOW "    CA 증가 1회 → cwnd=%.2f MSS\n" RESET, cwnd / MSS);
+                int g = cc_on_ack(&cc, (uint32_t)(ack - lastAck), 0, now_us());
+                show_recovery_ack(g, ack, &cc);
             }
 
             lastAck = ack;
@@ -260,194 +504,1230 @@ void run_dup3(int s, struct sockaddr_in *dst)
         }
     }
 
-    printf(BOLDMAG "\n=== [3 DUP ACK 시나리오 종료] ===\n" RESET);
-    send_end(s, dst);
+    sq_free(&q);
+    say(BOLDMAG "\n=== [3 DUP ACK 시나리오 종료] ===\n" RESET);
+    tr(TR_END, 0, 0, &cc, 0);
+    send_end(tp, dst);
 }
 
 // ------------------------------ TIMEOUT ------------------------------
-void run_timeout(int s, struct sockaddr_in *dst)
+void run_timeout(Transport *tp, struct sockaddr_in *dst)
 {
-    double cwnd = 15000;
-    int ssthresh = 15000;
+    Cc cc;
+    cc_start(&cc, 15000, 15000);
 
-    printf(BOLDMAG "\n=== [TIMEOUT 시나리오 시작] ===\n" RESET);
+    say(BOLDMAG "\n=== [TIMEOUT 시나리오 시작] ===\n" RESET);
 
-    char buf[BUF];
-    socklen_t dlen = sizeof(*dst);
+    // 재전송 타이머는 고정값 대신 측정한 RTT 로 계산 (RFC 6298)
+    Rto rto;
+    rto_init(&rto);
 
-    // recv timeout = 3초
-    struct timeval tv;
-    tv.tv_sec = 3;
-    tv.tv_usec = 0;
-    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    // 보낸 세그먼트는 ACK 될 때까지 재전송 큐에 두고, 타임아웃 뒤에는 큐 맨 앞부터 다시 보냄
+    SndQ q;
+    sq_init(&q, 64);
+    SqSeg *sg;
 
-    // (1) 첫 패킷 정상
-    int seq = 0;
+    // (1) 첫 패킷 정상: 송신 시각을 기록해 두고 ACK 로 RTT 표본을 얻음
+    int64_t seq = 0;
 
-    printf(BLUE "\n[TX] seq=%d len=%d\n" RESET, seq, MSS);
-    snprintf(buf, sizeof(buf), "DATA seq=%d len=%d", seq, MSS);
-    sendto(s, buf, strlen(buf), 0, (struct sockaddr *)dst, dlen);
-    usleep(SLEEP_US);
+    tr(TR_TX, seq, 0, &cc, MSS);
+    say(BLUE "\n[TX] seq=%lld len=%d\n" RESET, (long long)seq, MSS);
+    uint64_t sent_at = now_us();
+    sg = sq_push(&q, seq, payload, MSS);
+    send_queued(tp, dst, &q, sg);
+    seq += MSS;
 
     // ACK
-    struct sockaddr_in src;
-    socklen_t slen = sizeof(src);
-    int n = recvfrom(s, buf, sizeof(buf) - 1, 0,
-                     (struct sockaddr *)&src, &slen);
-    if (n < 0)
+    int64_t ack = recv_ack_cc(tp, &cc);
+    if (ack < 0)
         die("first ack timeout");
-    buf[n] = 0;
-    int ack;
-    sscanf(buf, "ACK %d", &ack);
-    printf(GREEN "[RX] ACK %d 수신\n" RESET, ack);
-
-    // (2) 1500~6000 손실 구간
-    int losses[] = {1500, 3000, 4500, 6000};
-    int lossCount = sizeof(losses) / sizeof(losses[0]);
+    sq_ack(&q, ack);
+    rto_sample(&rto, now_us() - sent_at);
+    tr(TR_ACK, 0, ack, &cc, now_us() - sent_at);
+    say(GREEN "[RX] ACK %lld 수신" RESET " (RTT %.3fms → RTO %.3fms)\n", (long long)ack,
+        (now_us() - sent_at) / 1e3, rto_get(&rto) / 1e3);
+    usleep(SLEEP_US);
 
-    for (int i = 0; i < lossCount; i++)
+    // (2) 1500~6000 손실 구간: 수신측이 4개 모두 잃어버린 것으로 연출됨 (rcv_logic.h)
+    for (int i = 0; i < 4; i++)
     {
-        seq = losses[i];
-        printf(BLUE "\n[TX] seq=%d (손실 구간)\n" RESET, seq);
+        tr(TR_TX, seq, 0, &cc, MSS);
+        say(BLUE "\n[TX] seq=%lld (손실 구간)\n" RESET, (long long)seq);
 
         // 타이머 걸기 시작 (첫 손실 구간에서)
         if (i == 0)
         {
-            show_timer_event("*** (타이머 시작) seq=1500 ***");
+            sent_at = now_us();
+            tr(TR_TIMER, seq, 0, &cc, 0);
+            say(BOLDCYN "*** (타이머 시작) seq=%lld ***\n" RESET, (long long)seq);
         }
 
-        snprintf(buf, sizeof(buf), "DATA seq=%d len=%d", seq, MSS);
-        sendto(s, buf, strlen(buf), 0, (struct sockaddr *)dst, dlen);
+        sg = sq_push(&q, seq, payload, MSS);
+        send_queued(tp, dst, &q, sg);
+        seq += MSS;
         usleep(SLEEP_US);
     }
+    int64_t snd_max = seq;
+
+    // (3) ACK 기다리기 → Timeout: 타이머 시작 후 RTO 가 지날 때까지만 기다림
+    say(CYAN "\n[TX] 손실 패킷 ACK 대기 중...\n" RESET);
 
-    // (3) ACK 기다리기 → Timeout
-    printf(CYAN "\n[TX] 손실 패킷 ACK 대기 중...\n" RESET);
+    uint64_t waited = now_us() - sent_at;
+    uint64_t left = rto_get(&rto) > waited ? rto_get(&rto) - waited : 1;
+    tp_set_timeout(tp, left);
 
-    n = recvfrom(s, buf, sizeof(buf) - 1, 0, (struct sockaddr *)&src, &slen);
+    int64_t n = recv_ack_cc(tp, &cc);
     // Timeout 발생
     if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
     {
         show_event("\n*** <<< TIMEOUT 발생 >>> ***");
 
-        double prev = cwnd;
-        ssthresh = prev / 2.0; // 임계치 조정
-        if (ssthresh < MSS)
-            ssthresh = MSS;
+        cc_on_timeout(&cc, now_us());
+        rto_backoff(&rto);
+        tr(TR_TIMEOUT, 0, 0, &cc, rto_get(&rto));
 
-        cwnd = MSS; // 1 MSS로 조정
-
-        printf(BOLDMAG "    ssthresh = %.2f MSS\n" RESET, ssthresh / MSS);
-        printf(BOLDYEL "    cwnd = 1 MSS 로 감소\n" RESET);
+        say(BOLDMAG "    ssthresh = %.2f MSS\n" RESET, cc.ssthresh / MSS);
+        say(BOLDYEL "    cwnd = 1 MSS 로 감소\n" RESET);
+        say(BOLDCYN "    RTO 백오프 → %.3fms\n" RESET, rto_get(&rto) / 1e3);
     }
 
-    // (4) 회복 구간 (지수 증가 + 선형 증가)
-    printf(BOLDMAG "\n=== [회복 구간: Slow Start + CA 시연] ===\n" RESET);
+    // 회복 구간은 손실이 없도록 연출되어 있고 수신측이 세그먼트마다 쉬므로 타이머 없이 대기
+    tp_set_timeout(tp, 0);
+
+    // (4) 회복 구간 (지수 증가 + 선형 증가): 가장 오래된 미확인 세그먼트부터 큐에 남은 것을
+    // 재전송하고(go-back-N), 큐를 다 보낸 뒤로는 새 데이터
+    say(BOLDMAG "\n=== [회복 구간: Slow Start + CA 시연] ===\n" RESET);
 
-    seq = 1500;
+    seq = sq_head(&q) ? sq_head(&q)->seq : snd_max;
+    say(CYAN "  재전송 큐에 미확인 세그먼트 %u개 → seq=%lld 부터 다시 전송\n" RESET, sq_count(&q), (long long)seq);
     int slow_rounds = 0;
     int ca_rounds = 0;
 
     while (1)
     {
-        int packets = cwnd / MSS;
+        int packets = cc.cwnd / MSS;
         if (packets < 1)
             packets = 1;
 
-        show_round_header(slow_rounds + ca_rounds + 1, cwnd, ssthresh);
+        show_round_header(slow_rounds + ca_rounds + 1, &cc);
 
         // send
         for (int i = 0; i < packets; i++)
         {
-            printf(BLUE "  [TX] seq=%d len=%d\n" RESET, seq, MSS);
-            snprintf(buf, sizeof(buf),
-                     "DATA seq=%d len=%d", seq, MSS);
-            sendto(s, buf, strlen(buf), 0,
-                   (struct sockaddr *)dst, dlen);
+            sg = seq < snd_max ? sq_find(&q, seq) : NULL;
+            if (sg)
+            {
+                tr(TR_RETX, seq, 0, &cc, sg->len);
+                say(BLUE "  [TX] seq=%lld len=%u (재전송: 큐에서)\n" RESET, (long long)seq, sg->len);
+            }
+            else
+            {
+                sg = sq_push(&q, seq, payload, MSS);
+                if (!sg)
+                    die("retransmission queue full");
+                tr(TR_TX, seq, 0, &cc, MSS);
+                say(BLUE "  [TX] seq=%lld len=%d\n" RESET, (long long)seq, MSS);
+            }
+            send_queued(tp, dst, &q, sg);
             seq += MSS;
+            if (seq > snd_max)
+                snd_max = seq;
             usleep(300000);
         }
 
-        printf(CYAN "  --- RTT 경과: ACK 수신 ---\n" RESET);
+        say(CYAN "  --- RTT 경과: ACK 수신 ---\n" RESET);
 
         // recv ack
         for (int i = 0; i < packets; i++)
         {
-            int n2 = recvfrom(s, buf, sizeof(buf) - 1, 0,
-                              (struct sockaddr *)&src, &slen);
-            if (n2 < 0)
+            int64_t ack2 = recv_ack_cc(tp, &cc);
+            if (ack2 < 0)
                 die("recvfrom recovery");
-            buf[n2] = 0;
-
-            int ack2;
-            sscanf(buf, "ACK %d", &ack2);
-            printf(GREEN "  [RX] ACK %d\n" RESET, ack2);
+            sq_ack(&q, ack2);
+            tr(TR_ACK, 0, ack2, &cc, 0);
+            say(GREEN "  [RX] ACK %lld\n" RESET, (long long)ack2);
 
-            // 느린시작
-            if ((int)cwnd < ssthresh)
-            {
-                cwnd += MSS;
+            // 느린시작 / 혼잡회피
+            if (grow_cwnd(&cc, now_us()))
                 slow_rounds++;
-                printf(YELLOW "     ↳ Slow Start 증가 → cwnd=%.2f MSS\n" RESET,
-                       cwnd / MSS);
-            }
-            // 혼잡회피
             else
-            {
-                double inc = MSS * ((double)MSS / cwnd);
-                cwnd += inc;
                 ca_rounds++;
-                printf(YELLOW "     ↳ CA 증가 → cwnd=%.2f MSS\n" RESET,
-                       cwnd / MSS);
-            }
         }
 
-        box_bot();
+        show_round_end(&cc);
         usleep(SLEEP_US);
 
         // 종료 조건(임의)
         if (slow_rounds >= 3 && ca_rounds >= 2)
         {
-            printf(BOLDMAG "\n=== [TIMEOUT 시나리오 종료] ===\n" RESET);
-            send_end(s, dst);
+            say(BOLDMAG "\n=== [TIMEOUT 시나리오 종료] ===\n" RESET);
+            tr(TR_END, 0, 0, &cc, 0);
+            send_end(tp, dst);
+            break;
+        }
+    }
+    sq_free(&q);
+}
+
+// ------------------------------ BULK ------------------------------
+// 실제 MSS 크기 데이터그램으로 total 바이트(또는 duration_us 동안)를 전송한다.
+// cwnd 는 다른 시나리오와 같은 혼잡제어 훅(-c)으로 갱신한다. 보낸 세그먼트는 ACK 될 때까지
+// 재전송 큐(sndq.h, 슬랩 버퍼)에 두고 송신 시각으로 RTT 를 재서(재전송된 세그먼트는 Karn 규칙으로
+// 제외) RFC 6298 RTO 와 혼잡제어에 넘기고 최소/평균 RTT(큐잉 지연)를 집계한다.
+// 3 중복 ACK 로 손실을 감지하면 NewReno 빠른 재전송/빠른 회복(RFC 6582)으로 들어가 snd_una 의
+// 세그먼트를 큐에서 다시 보내고, partial ACK 마다 다음 구멍을 곧바로 재전송해 한 윈도우의 여러
+// 손실을 타임아웃 없이 복구한다. ACK 에 SACK 블록이 있으면 큐의 점수판에 표시해 두고 확인된
+// 세그먼트 사이 구멍을 함께 재전송한다. 타임아웃이면 snd_una 부터 다시 보낸다(go-back-N,
+// SACK 로 확인된 세그먼트는 건너뜀). 윈도우 진행 방식은 두 가지:
+//   run_bulk    : run_normal 과 같은 라운드 방식 (윈도우 전송 → ACK 전부 수신)
+//   run_bulk_ev : -e, epoll + timerfd 이벤트 루프의 슬라이딩 윈도우 (ACK clocking)
+#define BULK_SOCKBUF (4 * 1024 * 1024)
+#define BULK_SNDQ 8192 // 재전송 큐 용량 (세그먼트 수 = 최대 in-flight, 재정렬 버퍼 용량보다 크게)
+                       // -B 로 준 BDP 가 더 크면 그 두 배 (bdp_segs)
+
+static int64_t wnd_cap; // -w: 최대 윈도우 (바이트, 0 이면 cwnd 만 적용)
+static int json_out;    // -j
+static int pace_mode;   // -P
+static int64_t bdp;     // -B: 대역폭-지연 곱 (바이트, 0 이면 기본 크기)
+static FileSrc src;     // -F: 보낼 파일의 매핑 (data 가 NULL 이면 카운터 페이로드)
+static const char *src_path;
+static uint64_t src_hash;
+
+typedef struct
+{
+    struct sockaddr_in *dst;
+    const char *loop; // "round" | "event"
+    int64_t total;        // 보낼 바이트 수 (duration_us 가 0 일 때)
+    uint64_t duration_us; // 전송 시간 (0 이 아니면 total 무시)
+    uint64_t t0;
+
+    Cc cc;
+    int64_t snd_una; // 가장 오래된 미확인 바이트
+    int64_t snd_nxt; // 다음에 보낼 바이트
+    int64_t snd_max; // 지금까지 보낸 최대 바이트 (재전송 구분용)
+    int dup;         // 연속 중복 ACK 수
+
+    // 손실 복구 구간: snd_una 가 recover 에 도달할 때까지 추가 cwnd 감소 없음.
+    // 타임아웃 뒤에도 recover = snd_max 로 두어 go-back-N 재전송이 만든 중복 ACK 로 다시 들어가지 않음
+    int in_recovery;
+    int64_t recover;
+    int64_t retx_hi; // 이번 복구에서 구멍 재전송을 마친 위치
+
+    SndQ q;             // 미확인 세그먼트 (송신 시각, 송신 횟수, 페이로드)
+    uint32_t q_peak;    // 큐에 동시에 있던 최대 세그먼트 수
+    uint64_t q_full;    // 큐가 가득 차 보내지 못한 횟수
+    uint64_t partials;  // partial ACK 로 이어서 복구한 횟수
+    Rto rto;
+    Pacer pace;
+
+    uint64_t pkts, retx, timeouts, dup3s;
+    Hist rtt;         // RTT 표본 분포 (us)
+    uint64_t rtt_sum; // 평균 계산용
+    uint64_t karn_skipped;                     // 재전송 세그먼트라 버린 표본 수
+} Bulk;
+
+static void bulk_init(Bulk *b, Transport *tp, struct sockaddr_in *dst, int64_t total, uint64_t duration_us)
+{
+    memset(b, 0, sizeof(*b));
+    b->dst = dst;
+    b->total = total;
+    b->duration_us = duration_us;
+    // 초기 ssthresh 는 시나리오와 같은 10 MSS. BDP 를 알면 거기까지 느린시작으로 올라감
+    cc_start(&b->cc, MSS, bdp > 15000 ? (double)bdp : 15000);
+    rto_init(&b->rto);
+    pace_init(&b->pace, pace_mode);
+    sq_init(&b->q, bdp && bdp_segs(bdp) > BULK_SNDQ ? bdp_segs(bdp) : BULK_SNDQ);
+    if (src.data)
+        sq_set_source(&b->q, src.data);
+
+    if (tp->kind == TP_UDP)
+    {
+        int64_t want = 2 * bdp > BULK_SOCKBUF ? 2 * bdp : BULK_SOCKBUF;
+        int sz = want > INT32_MAX / 2 ? INT32_MAX / 2 : (int)want;
+        // 커널 상한(wmem_max/rmem_max)에 막히면 권한이 있을 때 FORCE 로
+        if (setsockopt(tp->fd, SOL_SOCKET, SO_SNDBUFFORCE, &sz, sizeof(sz)) < 0)
+            setsockopt(tp->fd, SOL_SOCKET, SO_SNDBUF, &sz, sizeof(sz));
+        if (setsockopt(tp->fd, SOL_SOCKET, SO_RCVBUFFORCE, &sz, sizeof(sz)) < 0)
+            setsockopt(tp->fd, SOL_SOCKET, SO_RCVBUF, &sz, sizeof(sz));
+    }
+
+    if (duration_us)
+        printf(BOLDMAG "\n=== [BULK 시작] %.1f초 동안 전송 (%s) ===\n" RESET, duration_us / 1e6,
+               cc_algo->name);
+    else
+        printf(BOLDMAG "\n=== [BULK 시작] %lld bytes 전송 (%s) ===\n" RESET, (long long)total,
+               cc_algo->name);
+
+    b->t0 = now_us();
+}
+
+static int bulk_done(const Bulk *b)
+{
+    return b->duration_us ? now_us() - b->t0 >= b->duration_us : b->snd_una >= b->total;
+}
+
+// 큐의 세그먼트 하나 (재)전송. loopback 에서는 sendmsg 도중에 수신측이 먼저 돌아 ACK 를
+// 보낼 수 있으므로 송신 시각은 전송 전에 찍는다
+static void bulk_xmit(Transport *tp, Bulk *b, SqSeg *sg)
+{
+    int retx = sg->xmits > 0;
+    sg->sent_at = now_us();
+    pace_sent(&b->pace, sg->len, sg->sent_at);
+    tr(retx ? TR_RETX : TR_TX, sg->seq, 0, &b->cc, sg->len);
+    send_queued(tp, b->dst, &b->q, sg);
+    if (retx)
+        b->retx++;
+    b->pkts++;
+}
+
+// snd_nxt 의 세그먼트 하나 전송. 타임아웃 뒤라 snd_nxt 가 snd_max 보다 뒤면 큐에 남은 세그먼트를
+// 다시 보내고(SACK 로 확인된 것은 건너뜀), 아니면 새 세그먼트를 큐에 넣고 보낸다.
+// 더 보낼 데이터가 없거나 큐가 가득 찼으면 0 반환
+static int bulk_send_one(Transport *tp, Bulk *b)
+{
+    if (b->snd_nxt < b->snd_max)
+    {
+        uint64_t pos = sq_pos(&b->q, b->snd_nxt);
+        pos += sq_span(&b->q, pos, (uint32_t)(b->q.tail - pos), 1);
+        if (pos < b->q.tail)
+        {
+            SqSeg *sg = sq_at(&b->q, pos);
+            bulk_xmit(tp, b, sg);
+            b->snd_nxt = sg->seq + sg->len;
+            return 1;
+        }
+        b->snd_nxt = b->snd_max;
+    }
+
+    int len = MSS;
+    if (!b->duration_us)
+    {
+        if (b->snd_nxt >= b->total)
+            return 0;
+        if (b->total - b->snd_nxt < len)
+            len = b->total - b->snd_nxt;
+    }
+    SqSeg *sg = sq_push(&b->q, b->snd_nxt, payload, len);
+    if (!sg)
+    {
+        b->q_full++;
+        return 0;
+    }
+    if (sq_count(&b->q) > b->q_peak)
+        b->q_peak = sq_count(&b->q);
+    bulk_xmit(tp, b, sg);
+    b->snd_nxt += len;
+    b->snd_max = b->snd_nxt;
+    return 1;
+}
+
+// 복구 중 재전송: snd_una 의 세그먼트(NewReno 의 첫 미확인 세그먼트)와, SACK 정보가 있으면
+// 가장 높은 SACK 끝까지의 구멍 중 이번 복구에서 아직 보내지 않은 것(retx_hi 아래는 이미 보냄).
+// 확인된 구간은 점수판 비트맵을 워드 단위로 건너뛴다
+static void bulk_retx_holes(Transport *tp, Bulk *b)
+{
+    SndQ *q = &b->q;
+    int64_t from = b->snd_una > b->retx_hi ? b->snd_una : b->retx_hi;
+    uint64_t pos = sq_pos(q, from);
+    uint64_t end = q->sacked_hi > from ? sq_pos(q, q->sacked_hi) : pos;
+    if (from == b->snd_una && end == pos && pos < q->tail)
+        end = pos + 1; // SACK 이 없으면 첫 미확인 세그먼트 하나
+    while (pos < end)
+    {
+        pos += sq_span(q, pos, (uint32_t)(end - pos), 1);
+        uint32_t run = pos < end ? sq_span(q, pos, (uint32_t)(end - pos), 0) : 0;
+        for (uint32_t k = 0; k < run; k++, pos++)
+            bulk_xmit(tp, b, sq_at(q, pos));
+    }
+    int64_t hi = end < q->tail ? sq_at(q, end)->seq : b->snd_max;
+    if (hi > b->retx_hi)
+        b->retx_hi = hi;
+}
+
+// snd_una 를 넘어서는 ACK 가 왔을 때: 이 ACK 를 일으킨 세그먼트(큐 맨 앞, 이전 snd_una)의
+// 송신 시각으로 RTT 를 재서 RTO, 혼잡제어, 통계에 반영. 재전송된 세그먼트는 원본과 재전송 중
+// 어느 쪽의 ACK 인지 알 수 없으므로 버린다(Karn 규칙). 표본이 없으면 0 반환
+static uint64_t bulk_rtt_sample(Bulk *b, uint64_t now)
+{
+    SqSeg *sg = sq_head(&b->q);
+    if (!sg)
+        return 0;
+    if (sg->xmits > 1)
+    {
+        b->karn_skipped++;
+        return 0;
+    }
+    uint64_t rtt = now - sg->sent_at;
+    rto_sample(&b->rto, rtt);
+    cc_on_rtt_sample(&b->cc, rtt, now);
+    hist_add(&b->rtt, rtt);
+    b->rtt_sum += rtt;
+    return rtt;
+}
+
+// ACK 하나 처리: SACK 점수판 갱신, 확인된 세그먼트 해제, cwnd 갱신, 손실 감지와 복구 재전송
+static void bulk_on_ack(Transport *tp, Bulk *b, const SegHdr *h)
+{
+    uint64_t now = now_us();
+    int64_t ack = h->ack;
+
+    for (int i = 0; i < h->nsack; i++)
+        sq_sack(&b->q, (int64_t)h->sack[i].start, (int64_t)h->sack[i].end);
+
+    if (ack > b->snd_una)
+    {
+        uint64_t rtt = bulk_rtt_sample(b, now);
+        uint32_t acked = ack - b->snd_una;
+        b->snd_una = ack;
+        sq_ack(&b->q, ack);
+        if (b->snd_nxt < b->snd_una)
+            b->snd_nxt = b->snd_una; // 재정렬 버퍼 덕분에 재전송 뒤 ACK 가 크게 뛸 수 있음
+        if (b->in_recovery && ack < b->recover)
+        {
+            // partial ACK: 복구 시작 때 보낸 데이터 안에 구멍이 더 있음. 다음 구멍을 바로 재전송
+            cc_on_ack(&b->cc, acked, 1, now);
+            tr(TR_ACK, 0, ack, &b->cc, rtt);
+            b->partials++;
+            bulk_retx_holes(tp, b);
+            return;
+        }
+        b->in_recovery = 0;
+        b->dup = 0;
+        cc_on_ack(&b->cc, acked, 0, now);
+        tr(TR_ACK, 0, ack, &b->cc, rtt);
+        return;
+    }
+
+    b->dup++;
+    if (!b->in_recovery && b->snd_una < b->recover)
+    {
+        // 타임아웃 뒤 go-back-N 으로 다시 보낸 세그먼트의 중복 ACK: 새 손실 신호가 아님
+        tr(TR_DUPACK, 0, ack, &b->cc, b->dup);
+        return;
+    }
+
+    // 중복 ACK: 복구 중에는 세기만 계속하고 (NewReno 윈도우 팽창) 새로 드러난 구멍을 재전송
+    double prev = b->cc.cwnd;
+    cc_on_dupack(&b->cc, b->dup, now);
+    tr(TR_DUPACK, 0, ack, &b->cc, b->dup);
+    if (b->in_recovery)
+    {
+        if (h->nsack)
+            bulk_retx_holes(tp, b);
+        return;
+    }
+
+    if (b->dup == 3)
+    {
+        // 빠른 재전송: snd_una 세그먼트를 큐에서 다시 보내고 빠른 회복 시작
+        tr(TR_DUP3, 0, ack, &b->cc, (uint32_t)prev);
+        b->dup3s++;
+        b->in_recovery = 1;
+        b->recover = b->snd_max;
+        b->retx_hi = b->snd_una;
+        bulk_retx_holes(tp, b);
+    }
+}
+
+// 페이싱 속도를 현재 cwnd/SRTT 에 맞춤 (ACK 나 타임아웃을 처리한 뒤)
+static void bulk_pace(Transport *tp, Bulk *b)
+{
+    pace_update(&b->pace, &b->cc, b->rto.srtt);
+    pace_apply_fq(&b->pace, tp->fd);
+}
+
+static void bulk_on_timeout(Bulk *b)
+{
+    b->timeouts++;
+    rto_backoff(&b->rto);
+    cc_on_timeout(&b->cc, now_us());
+    tr(TR_TIMEOUT, 0, b->snd_una, &b->cc, rto_get(&b->rto));
+    b->dup = 0;
+    b->in_recovery = 0;
+    b->recover = b->snd_max;
+    b->snd_nxt = b->snd_una;
+}
+
+static void bulk_finish(Transport *tp, Bulk *b)
+{
+    uint64_t elapsed = now_us() - b->t0;
+    tr(TR_END, b->snd_una, b->snd_una, &b->cc, 0);
+    if (src.data)
+    {
+        // 수신측이 받은 파일을 확인하도록 크기와 해시를 실어 보냄
+        SegHdr h = {0};
+        h.type = SEG_END;
+        h.flags = SEG_F_FILE;
+        h.seq = src.size;
+        h.ack = src_hash;
+        send_seg(tp, b->dst, &h);
+    }
+    else
+        send_end(tp, b->dst);
+
+    printf(BOLDMAG "\n=== [BULK 종료] ===\n" RESET);
+    printf("  [%s] sent %llu pkts (retx %llu), timeout %llu, 3dup %llu, final cwnd=%.2f MSS ssthresh=%.2f MSS\n",
+           b->cc.ops->name, (unsigned long long)b->pkts, (unsigned long long)b->retx,
+           (unsigned long long)b->timeouts, (unsigned long long)b->dup3s,
+           b->cc.cwnd / MSS, b->cc.ssthresh / MSS);
+    if (b->rtt.n)
+    {
+        double avg = (double)b->rtt_sum / b->rtt.n;
+        printf("  rtt min %llu / avg %.1f / max %llu us  queueing delay avg %.1f us (%llu samples)\n",
+               (unsigned long long)b->rtt.min, avg, (unsigned long long)b->rtt.max,
+               avg - b->rtt.min, (unsigned long long)b->rtt.n);
+        printf("  rtt p50 %llu / p99 %llu / p99.9 %llu us\n",
+               (unsigned long long)hist_quantile(&b->rtt, 0.5),
+               (unsigned long long)hist_quantile(&b->rtt, 0.99),
+               (unsigned long long)hist_quantile(&b->rtt, 0.999));
+    }
+    printf("  rto: srtt %llu us, rttvar %llu us, final rto %llu us (backoff %d), karn skipped %llu\n",
+           (unsigned long long)b->rto.srtt, (unsigned long long)b->rto.rttvar,
+           (unsigned long long)rto_get(&b->rto), b->rto.backoff,
+           (unsigned long long)b->karn_skipped);
+    if (b->pace.mode != PACE_OFF)
+        printf("  pacing: %s, avg rate %.1f Mbit/s (%llu paced segs), %llu waits / %.1f ms, %llu setsockopt\n",
+               pace_name(b->pace.mode), pace_avg_mbps(&b->pace), (unsigned long long)b->pace.paced,
+               (unsigned long long)b->pace.waits, b->pace.wait_us / 1e3,
+               (unsigned long long)b->pace.setsockopts);
+    if (src.data)
+        printf("  sndq: %u segs (zero-copy from mmap), peak %u in flight, full %llu, partial ACK recoveries %llu\n",
+               b->q.cap, b->q_peak, (unsigned long long)b->q_full, (unsigned long long)b->partials);
+    else
+        printf("  sndq: %u segs (%.1f MB slab), peak %u in flight, full %llu, partial ACK recoveries %llu\n",
+               b->q.cap, (double)b->q.cap * MSS / 1e6, b->q_peak, (unsigned long long)b->q_full,
+               (unsigned long long)b->partials);
+    report_throughput("SND", b->snd_una, b->pkts, elapsed);
+    if (src.data)
+        printf(BOLDMAG "[SND] file %s: %lld bytes in %.3fs  %.1f MB/s  (hash %016llx)\n" RESET,
+               src_path, (long long)src.size, elapsed / 1e6,
+               elapsed ? src.size / (elapsed / 1e6) / 1e6 : 0.0, (unsigned long long)src_hash);
+    double acked = b->snd_una > 0 ? (double)b->snd_una : 1;
+    printf("  syscalls %llu (%s)  %.2f per MB  %.3g per byte\n",
+           (unsigned long long)n_syscalls,
+           gsoq ? (ackq ? "sendmmsg+GSO/recvmmsg" : "sendmmsg+GSO/recvfrom")
+           : txq ? "sendmmsg/recvmmsg" : tp->kind == TP_SHM ? tp_name(tp) : "sendmsg/recvfrom",
+           n_syscalls / (acked / 1e6), n_syscalls / acked);
+    if (tp->kind == TP_SHM)
+        printf("  shm: %llu dropped (ring full), %llu futex sleeps\n",
+               (unsigned long long)tp->tx_drops, (unsigned long long)tp->sleeps);
+    if (gsoq)
+        printf("  gso: %llu segments in %llu super-datagrams (%.1f per datagram), %llu sendmmsg\n",
+               (unsigned long long)gsoq->segments, (unsigned long long)gsoq->datagrams,
+               gsoq->datagrams ? (double)gsoq->segments / gsoq->datagrams : 0.0,
+               (unsigned long long)gsoq->sends);
+
+    if (json_out)
+    {
+        // 기계가 읽는 결과 한 줄 (bench.c). 시간은 us, 처리량은 Mbit/s
+        double sec = elapsed > 0 ? elapsed / 1e6 : 1e-6;
+        printf("{\"cc\":\"%s\",\"loop\":\"%s\",\"transport\":\"%s\",\"pacing\":\"%s\",\"batch\":%d,\"gso\":%d,\"wnd\":%lld,\"bytes\":%lld,"
+               "\"elapsed_us\":%llu,\"goodput_mbps\":%.2f,\"pkts\":%llu,\"retx\":%llu,"
+               "\"retx_ratio\":%.6f,\"timeouts\":%llu,\"dup3\":%llu,\"rtt_samples\":%llu,"
+               "\"rtt_min_us\":%llu,\"rtt_p50_us\":%llu,\"rtt_p99_us\":%llu,\"rtt_p999_us\":%llu,"
+               "\"rtt_max_us\":%llu,\"qdelay_us\":%.1f,\"syscalls\":%llu,\"syscalls_per_mb\":%.2f,\"cpu_s\":%.3f}\n",
+               b->cc.ops->name, b->loop, tp->kind == TP_SHM ? "shm" : "udp", pace_name(b->pace.mode), txq != NULL, gsoq != NULL, (long long)(wnd_cap / MSS), (long long)b->snd_una,
+               (unsigned long long)elapsed, b->snd_una * 8 / sec / 1e6, (unsigned long long)b->pkts,
+               (unsigned long long)b->retx, b->pkts ? (double)b->retx / b->pkts : 0.0,
+               (unsigned long long)b->timeouts, (unsigned long long)b->dup3s,
+               (unsigned long long)b->rtt.n, (unsigned long long)b->rtt.min,
+               (unsigned long long)hist_quantile(&b->rtt, 0.5),
+               (unsigned long long)hist_quantile(&b->rtt, 0.99),
+               (unsigned long long)hist_quantile(&b->rtt, 0.999),
+               (unsigned long long)b->rtt.max,
+               b->rtt.n ? (double)b->rtt_sum / b->rtt.n - b->rtt.min : 0.0, (unsigned long long)n_syscalls,
+               n_syscalls / (acked / 1e6), cpu_seconds());
+        fflush(stdout);
+    }
+    sq_free(&b->q);
+}
+
+// 이번에 허용되는 in-flight 바이트: cwnd 와 -w 중 작은 쪽
+static int64_t bulk_window(const Bulk *b)
+{
+    int64_t w = (int64_t)b->cc.cwnd;
+    return wnd_cap && wnd_cap < w ? wnd_cap : w;
+}
+
+void run_bulk(Transport *tp, struct sockaddr_in *dst, int64_t total, uint64_t duration_us)
+{
+    Bulk b;
+    bulk_init(&b, tp, dst, total, duration_us);
+    b.loop = "round";
+    uint64_t rcvtimeo = 0; // 소켓에 설정된 RTO
+
+    while (!bulk_done(&b))
+    {
+        // ACK 대기 한도 = 현재 RTO (바뀌었을 때만 다시 설정)
+        if (rto_get(&b.rto) != rcvtimeo)
+        {
+            rcvtimeo = rto_get(&b.rto);
+            tp_set_timeout(tp, rcvtimeo);
+        }
+
+        // 윈도우 채우기: in-flight 가 cwnd 를 넘지 않는 만큼 전송 (-e 와 같은 조건).
+        // 페이싱(-P timer)이면 세그먼트마다 출발 시각까지 기다림
+        while (b.snd_nxt - b.snd_una + MSS <= bulk_window(&b) || b.snd_nxt == b.snd_una)
+        {
+            if (pace_delay(&b.pace, now_us()))
+            {
+                flush_data(tp);
+                pace_sleep(&b.pace);
+            }
+            if (!bulk_send_one(tp, &b))
+                break;
+        }
+
+        // 이번 라운드에 보낸 가장 높은 seq 까지 확인될 때까지 ACK 수집. 수신측이 ACK 를 지연/솎아
+        // 내거나 구멍을 메운 누적 ACK 가 여러 세그먼트를 확인해도 라운드가 일찍 끝나지 않음.
+        // 보낼 것이 없었어도(모두 전송됨, 큐 가득) ACK 하나나 타임아웃까지는 기다린다
+        int64_t round_hi = b.snd_nxt;
+        do
+        {
+            SegHdr h;
+            if (recv_ack_hdr(tp, &h) < 0)
+            {
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    die("recvfrom bulk");
+                // 타임아웃: 남은 ACK 는 오지 않는다고 보고 라운드 종료
+                bulk_on_timeout(&b);
+                break;
+            }
+            bulk_on_ack(tp, &b, &h);
+        } while (b.snd_una < round_hi && !bulk_done(&b));
+        bulk_pace(tp, &b);
+    }
+
+    bulk_finish(tp, &b);
+}
+
+// 이벤트 구동 슬라이딩 윈도우 (-e)
+//  - ACK 는 도착하는 대로 처리하고, snd_una 가 전진하면 바로 윈도우를 채워 새 세그먼트 전송
+//  - 가장 오래된 미확인 세그먼트에 재전송 타이머(timerfd)를 걸어 ACK 와 독립적으로 만료 처리
+//  - 페이싱(-P timer)이면 출발 시각이 안 된 세그먼트는 남겨 두고, 같은 timerfd 를 재전송 타이머와
+//    다음 출발 시각 중 이른 쪽에 건다
+void run_bulk_ev(Transport *tp, struct sockaddr_in *dst, int64_t total, uint64_t duration_us)
+{
+    Bulk b;
+    EvLoop ev;
+    ev_init(&ev, tp->fd);
+    bulk_init(&b, tp, dst, total, duration_us);
+    b.loop = "event";
+    uint64_t rto_at = 0; // 재전송 타이머 만료 시각 (0 이면 꺼짐)
+    uint64_t armed = 0;  // timerfd 에 걸려 있는 시각 (같으면 다시 걸지 않음)
+
+    while (!bulk_done(&b))
+    {
+        // 윈도우 채우기: in-flight 가 cwnd 를 넘지 않는 만큼 전송
+        uint64_t pace_at = 0;
+        while (b.snd_nxt - b.snd_una + MSS <= bulk_window(&b) || b.snd_nxt == b.snd_una)
+        {
+            if (pace_delay(&b.pace, now_us()))
+            {
+                pace_at = b.pace.next_at;
+                break;
+            }
+            if (!bulk_send_one(tp, &b))
+                break;
+        }
+        flush_data(tp);
+
+        // 미확인 데이터가 있는데 타이머가 꺼져 있으면 건다
+        if (b.snd_nxt > b.snd_una && !rto_at)
+            rto_at = now_us() + rto_get(&b.rto);
+
+        uint64_t due = rto_at;
+        if (pace_at && (!due || pace_at < due))
+            due = pace_at;
+        if (due != armed)
+        {
+            uint64_t now = now_us();
+            if (due)
+                ev_timer_arm(&ev, due > now ? due - now : 1);
+            else
+                ev_timer_disarm(&ev);
+            armed = due;
+        }
+
+        int ready = ev_wait(&ev);
+        if (ready & EV_TIMER)
+            armed = 0;
+
+        if (ready & EV_READABLE)
+        {
+            // 도착해 있는 ACK 를 모두 처리 (EAGAIN 까지)
+            SegHdr h;
+            while (recv_ack_hdr(tp, &h) >= 0)
+            {
+                int64_t una = b.snd_una;
+                bulk_on_ack(tp, &b, &h);
+                if (b.snd_una > una)
+                {
+                    // 새 데이터가 확인되면 가장 오래된 미확인 세그먼트 기준으로 타이머 재시작
+                    rto_at = b.snd_una < b.snd_nxt ? now_us() + rto_get(&b.rto) : 0;
+                }
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                die("recvfrom bulk");
+        }
+
+        if (rto_at && now_us() >= rto_at)
+        {
+            bulk_on_timeout(&b);
+            rto_at = 0;
+        }
+        bulk_pace(tp, &b);
+    }
+
+    ev_close(&ev);
+    bulk_finish(tp, &b);
+}
+
+// ------------------------------ SIMULATION (-s) ------------------------------
+// 소켓과 sleep 없이 가상 시계 위에서 같은 시나리오를 돌린다.
+// 세그먼트 전송, DATA/ACK 도착, RTO 만료가 모두 sim.h 의 사건으로 처리되고,
+// 수신측은 receiver 와 같은 rcv_logic.h 로직이 in-process 로 동작한다.
+
+typedef struct
+{
+    Sim sim;
+    RcvState rcv;
+    Mode mode;
+
+    Cc cc;
+    int64_t seq; // 다음에 보낼 seq
+    SndQ q;   // 보냈지만 아직 ACK 되지 않은 세그먼트 (재전송은 여기서 꺼냄)
+
+    // 라운드(윈도우) 진행 상태
+    int round;
+    int packets; // 이번 라운드에 보낸 세그먼트 수
+    int acked;   // 이번 라운드에 받은 ACK 수
+    int slow_rounds;
+    int ca_rounds;
+
+    // dup3 시나리오
+    int64_t lastAck;
+    int dupCnt;
+    int halved;
+    int fast_retx; // 다음 전송은 큐 맨 앞의 빠른 재전송
+
+    // timeout 시나리오
+    int recovering; // 타임아웃 이후 회복 구간 여부
+    int rto_armed;  // 재전송 타이머 동작 여부
+    int rto_gen;    // 타이머 세대: 재무장 시 증가, 이전 세대의 EV_RTO 는 무시
+    int64_t rto_seq; // 타이머를 건 세그먼트
+} SimSender;
+
+static void sim_stamp(SimSender *ss)
+{
+    say(WHITE "[t=%8.3fs] " RESET, ss->sim.now / 1e6);
+}
+
+static void sim_tx(SimSender *ss, uint64_t delay, int64_t seq)
+{
+    Event ev = {0};
+    ev.type = EV_TX;
+    ev.seq = seq;
+    ev.len = MSS;
+    sim_at(&ss->sim, delay, ev);
+}
+
+// 새 라운드: cwnd 만큼 세그먼트를 SIM_TX_GAP_US 간격으로 예약
+static void sim_round(SimSender *ss)
+{
+    ss->packets = ss->cc.cwnd / MSS;
+    if (ss->packets < 1)
+        ss->packets = 1;
+    ss->acked = 0;
+
+    show_round_header(ss->round, &ss->cc);
+    for (int i = 0; i < ss->packets; i++)
+    {
+        sim_tx(ss, (uint64_t)i * SIM_TX_GAP_US, ss->seq);
+        ss->seq += MSS;
+    }
+}
+
+static void sim_on_tx(SimSender *ss, const Event *ev)
+{
+    // 큐에 이미 있는 세그먼트면 재전송, 아니면 새로 넣음
+    SqSeg *sg = sq_find(&ss->q, ev->seq);
+    if (!sg)
+        sg = sq_push(&ss->q, ev->seq, payload, ev->len);
+    int retx = sg && sg->xmits++ > 0;
+
+    sim_stamp(ss);
+    tr(retx ? TR_RETX : TR_TX, ev->seq, 0, &ss->cc, ev->len);
+    say(BLUE "[TX] seq=%lld len=%d%s\n" RESET, (long long)ev->seq, ev->len, retx ? " (재전송: 큐에서)" : "");
+
+    // timeout 시나리오: 손실 구간 첫 패킷에 타이머를 건다
+    if (ss->mode == MODE_TIMEOUT && !ss->recovering && ev->seq == 1500)
+    {
+        ss->rto_armed = 1;
+        ss->rto_gen++;
+        ss->rto_seq = ev->seq;
+        Event rto = {0};
+        rto.type = EV_RTO;
+        rto.seq = ev->seq;
+        rto.gen = ss->rto_gen;
+        sim_at(&ss->sim, SIM_RTO_US, rto);
+        tr(TR_TIMER, ev->seq, 0, &ss->cc, 0);
+        show_timer_event("*** (타이머 시작) seq=1500 ***");
+    }
+
+    Event data = *ev;
+    data.type = EV_DATA_ARRIVE;
+    sim_at(&ss->sim, SIM_OWD_US, data);
+}
+
+static void sim_on_data(SimSender *ss, const Event *ev)
+{
+    sim_stamp(ss);
+    tr(TR_RCV_DATA, ev->seq, 0, &ss->cc, ev->len);
+    say(BLUE "[RCV] DATA 수신   ◀◀◀   " RESET "seq=%lld, len=%d\n", (long long)ev->seq, ev->len);
+
+    int64_t ack = 0;
+    if (rcv_on_data(&ss->rcv, ss->mode, ev->seq, ev->len, &ack))
+    {
+        Event a = {0};
+        a.type = EV_ACK_ARRIVE;
+        a.ack = ack;
+        sim_at(&ss->sim, SIM_OWD_US, a);
+    }
+}
+
+// 라운드 단위 ACK 처리 (normal, timeout 회복 구간)
+static void sim_round_ack(SimSender *ss, int64_t ack)
+{
+    sq_ack(&ss->q, ack);
+    sim_stamp(ss);
+    tr(TR_ACK, 0, ack, &ss->cc, 0);
+    say(GREEN "[RX] ACK %lld\n" RESET, (long long)ack);
+
+    if (grow_cwnd(&ss->cc, ss->sim.now))
+        ss->slow_rounds++;
+    else
+        ss->ca_rounds++;
+
+    if (++ss->acked < ss->packets)
+        return;
+
+    show_round_end(&ss->cc);
+    ss->round++;
+    // 종료 조건(임의): 실시간 모드와 동일
+    if (ss->slow_rounds >= 3 && ss->ca_rounds >= 2)
+        return;
+
+    Event r = {0};
+    r.type = EV_ROUND;
+    sim_at(&ss->sim, SIM_ROUND_GAP_US, r);
+}
+
+// dup3 시나리오의 ACK 처리: run_dup3 과 같은 규칙
+static void sim_dup3_ack(SimSender *ss, int64_t ack)
+{
+    sim_stamp(ss);
+    tr(TR_ACK, 0, ack, &ss->cc, 0);
+    say(GREEN "[RX] ACK %lld 수신\n" RESET, (long long)ack);
+
+    if (ss->lastAck < 0)
+    {
+        sq_ack(&ss->q, ack);
+        ss->lastAck = ack;
+        ss->dupCnt = 0;
+    }
+    else if (ack == ss->lastAck)
+    {
+        ss->dupCnt++;
+        tr(TR_DUPACK, 0, ack, &ss->cc, ss->dupCnt);
+        say(YELLOW "    중복 ACK (%d회)\n" RESET, ss->dupCnt);
+
+        double prev = ss->cc.cwnd;
+        if (!ss->halved)
+            cc_on_dupack(&ss->cc, ss->dupCnt, ss->sim.now);
+        if (ss->dupCnt == 3 && !ss->halved)
+        {
+            tr(TR_DUP3, 0, ack, &ss->cc, (uint32_t)prev);
+            show_event("\n*** <<< 3 DUP ACK 사건 발생 >>> ***");
+            say(BOLDYEL "    cwnd: %.1f MSS → %.1f MSS\n" RESET,
+                prev / MSS, ss->cc.cwnd / MSS);
+            say(BOLDMAG "    ssthresh = %.1f MSS\n" RESET, ss->cc.ssthresh / MSS);
+            ss->halved = 1;
+            ss->fast_retx = 1;
+        }
+    }
+    else
+    {
+        uint32_t freed = sq_ack(&ss->q, ack);
+        say(CYAN "    새로운 ACK → 누적 구간 복구 처리 (재전송 큐에서 %u개 해제, 남은 %u개)\n" RESET,
+            freed, sq_count(&ss->q));
+        if (ss->halved)
+        {
+            int g = cc_on_ack(&ss->cc, (uint32_t)(ack - ss->lastAck), 0, ss->sim.now);
+            show_recovery_ack(g, ack, &ss->cc);
+        }
+        ss->lastAck = ack;
+        ss->dupCnt = 0;
+    }
+
+    // 다음 전송: 빠른 재전송이 걸려 있으면 큐 맨 앞, 아니면 남은 새 데이터
+    if (ss->fast_retx && sq_head(&ss->q))
+    {
+        ss->fast_retx = 0;
+        sim_tx(ss, SIM_ROUND_GAP_US, sq_head(&ss->q)->seq);
+    }
+    else if (ss->seq < DUP3_END)
+    {
+        sim_tx(ss, SIM_ROUND_GAP_US, ss->seq);
+        ss->seq += MSS;
+    }
+}
+
+static void sim_on_ack(SimSender *ss, const Event *ev)
+{
+    // 타이머를 건 세그먼트가 ACK 되면 해제
+    if (ss->rto_armed && ev->ack > ss->rto_seq)
+        ss->rto_armed = 0;
+
+    if (ss->mode == MODE_DUP3)
+    {
+        sim_dup3_ack(ss, ev->ack);
+        return;
+    }
+
+    if (ss->mode == MODE_TIMEOUT && !ss->recovering)
+    {
+        // (1) 첫 패킷의 ACK → (2) 손실 구간 4개 전송
+        sq_ack(&ss->q, ev->ack);
+        sim_stamp(ss);
+        tr(TR_ACK, 0, ev->ack, &ss->cc, 0);
+        say(GREEN "[RX] ACK %lld 수신\n" RESET, (long long)ev->ack);
+        for (int i = 0; i < 4; i++)
+        {
+            sim_tx(ss, (uint64_t)i * SIM_TX_GAP_US, ss->seq);
+            ss->seq += MSS;
+        }
+        return;
+    }
+
+    sim_round_ack(ss, ev->ack);
+}
+
+static void sim_on_rto(SimSender *ss, const Event *ev)
+{
+    if (!ss->rto_armed || ev->gen != ss->rto_gen)
+        return; // 이미 해제된 타이머
+
+    sim_stamp(ss);
+    show_event("\n*** <<< TIMEOUT 발생 >>> ***");
+    cc_on_timeout(&ss->cc, ss->sim.now);
+    tr(TR_TIMEOUT, 0, 0, &ss->cc, SIM_RTO_US);
+    say(BOLDMAG "    ssthresh = %.2f MSS\n" RESET, ss->cc.ssthresh / MSS);
+    say(BOLDYEL "    cwnd = 1 MSS 로 감소\n" RESET);
+
+    // (4) 회복 구간: 재전송 큐 맨 앞(가장 오래된 미확인 세그먼트)부터 다시 라운드 진행
+    say(BOLDMAG "\n=== [회복 구간: Slow Start + CA 시연] ===\n" RESET);
+    ss->rto_armed = 0;
+    ss->recovering = 1;
+    if (sq_head(&ss->q))
+        ss->seq = sq_head(&ss->q)->seq;
+    ss->round = 1;
+    sim_round(ss);
+}
+
+void run_sim(Mode mode)
+{
+    SimSender ss;
+    memset(&ss, 0, sizeof(ss));
+    sim_init(&ss.sim);
+    rcv_init(&ss.rcv, mode, 0);
+    sq_init(&ss.q, 256);
+    ss.rcv.quiet = quiet;
+    ss.mode = mode;
+    ss.round = 1;
+    ss.lastAck = -1;
+    sim_clock = &ss.sim;
+
+    say(BOLDMAG "\n=== [SIM %s 시나리오 시작 (가상 시계)] ===\n" RESET,
+        mode == MODE_NORMAL ? "NORMAL" : mode == MODE_DUP3 ? "3 DUP ACK"
+                                                           : "TIMEOUT");
+
+    struct timespec w0, w1;
+    clock_gettime(CLOCK_MONOTONIC, &w0);
+
+    if (mode == MODE_NORMAL)
+    {
+        cc_start(&ss.cc, MSS, 15000);
+        Event r = {0};
+        r.type = EV_ROUND;
+        sim_at(&ss.sim, 0, r);
+    }
+    else
+    {
+        // dup3/timeout 은 cwnd=15000 에서 시작, 첫 세그먼트는 각각 1500 / 0
+        cc_start(&ss.cc, 15000, 15000);
+        ss.seq = mode == MODE_DUP3 ? DUP3_FIRST : 0;
+        sim_tx(&ss, 0, ss.seq);
+        ss.seq += MSS;
+    }
+
+    Event ev;
+    while (sim_next(&ss.sim, &ev))
+    {
+        switch (ev.type)
+        {
+        case EV_ROUND:
+            sim_round(&ss);
+            break;
+        case EV_TX:
+            sim_on_tx(&ss, &ev);
+            break;
+        case EV_DATA_ARRIVE:
+            sim_on_data(&ss, &ev);
+            break;
+        case EV_ACK_ARRIVE:
+            sim_on_ack(&ss, &ev);
+            break;
+        case EV_RTO:
+            sim_on_rto(&ss, &ev);
             break;
         }
     }
+
+    clock_gettime(CLOCK_MONOTONIC, &w1);
+    double wall_us = (w1.tv_sec - w0.tv_sec) * 1e6 + (w1.tv_nsec - w0.tv_nsec) / 1e3;
+
+    printf(BOLDMAG "\n=== [SIM 종료] 가상 시간 %.3fs, 사건 %llu개, 실제 소요 %.1fus ===\n" RESET,
+           ss.sim.now / 1e6, (unsigned long long)ss.sim.handled, wall_us);
+    sim_clock = NULL;
+    sim_free(&ss.sim);
+    rcv_free(&ss.rcv);
+    sq_free(&ss.q);
 }
 
 // ------------------------------ MAIN ------------------------------
 int main(int argc, char **argv)
 {
-    if (argc < 4)
+    int sim = 0;                        // -s: 가상 시계 시뮬레이션 모드
+    int64_t bulk_bytes = 100000000;     // -n: bulk 전송량 (바이트)
+    uint64_t bulk_us = 0;               // -T: bulk 전송 시간 (초, 지정 시 -n 무시)
+    int opt;
+    int batch = 0;                      // -b: sendmmsg/recvmmsg 배치 송수신
+    int evloop = 0;                     // -e: 이벤트 구동 슬라이딩 윈도우 (bulk)
+    const char *trace_path = NULL;      // -q: 트레이스 파일
+    const char *shm_name = NULL;        // -M: 공유 메모리 전송
+    int busy_poll = 0;                  // -y
+    int gso = 0;                        // -g
+    conn_id = (uint32_t)getpid();
+    while ((opt = getopt(argc, argv, "stbejc:C:n:T:q:w:M:yA:P:F:KB:g")) != -1)
     {
-        fprintf(stderr, "usage: %s <dst_ip> <dst_port> <mode>\n", argv[0]);
-        return 1;
+        if (opt == 'C')
+            conn_id = (uint32_t)strtoul(optarg, NULL, 10);
+        else if (opt == 'c')
+        {
+            cc_algo = cc_find(optarg);
+            if (!cc_algo)
+            {
+                fprintf(stderr, "unknown congestion control: %s (reno|newreno|cubic|bbr)\n", optarg);
+                return 1;
+            }
+        }
+        else if (opt == 's')
+            sim = 1;
+        else if (opt == 'e')
+            evloop = 1;
+        else if (opt == 'b')
+            batch = 1;
+        else if (opt == 'g')
+            gso = 1;
+        else if (opt == 't')
+            wire_fmt = SEG_FMT_TEXT;
+        else if (opt == 'j')
+            json_out = 1;
+        else if (opt == 'w')
+            wnd_cap = (int64_t)atoi(optarg) * MSS;
+        else if (opt == 'q')
+        {
+            quiet = 1;
+            trace_path = optarg;
+        }
+        else if (opt == 'M')
+            shm_name = optarg;
+        else if (opt == 'y')
+            busy_poll = 1;
+        else if (opt == 'A')
+            abc_l = atoi(optarg);
+        else if (opt == 'P')
+        {
+            pace_mode = pace_parse(optarg);
+            if (pace_mode < 0)
+            {
+                fprintf(stderr, "unknown pacing mode: %s (timer|fq|off)\n", optarg);
+                return 1;
+            }
+        }
+        else if (opt == 'F')
+            src_path = optarg;
+        else if (opt == 'K')
+            csum_on = 1;
+        else if (opt == 'B')
+        {
+            if ((bdp = parse_bdp(optarg)) <= 0)
+            {
+                fprintf(stderr, "잘못된 BDP: %s (예: 10g:80 = 10 Gbit/s x 80 ms, 또는 100m bytes)\n", optarg);
+                return 1;
+            }
+        }
+        else if (opt == 'n')
+            bulk_bytes = strtoll(optarg, NULL, 10);
+        else if (opt == 'T')
+            bulk_us = (uint64_t)(atof(optarg) * 1e6);
+        else
+        {
+            fprintf(stderr, "usage: %s [-s] [-t] [-b] [-e] [-j] [-w wnd] [-q trace] [-c cc] [-C conn] [-n bytes | -T sec] [-A L] [-P pacing] [-F file] [-K] [-B bdp] [-g] [-M shm [-y]] <dst_ip> <dst_port> <mode>\n", argv[0]);
+            return 1;
+        }
+    }
+    argc -= optind;
+    argv += optind;
+
+    if (csum_on)
+    {
+        if (wire_fmt == SEG_FMT_TEXT)
+        {
+            fprintf(stderr, "-K 는 바이너리 헤더에서만 쓸 수 있습니다 (-t 와 함께 못 씀)\n");
+            return 1;
+        }
+        crc32c_init();
+        printf(YELLOW "[SND] checksum: crc32c (%s)\n" RESET, crc32c_impl);
     }
+    if (trace_path)
+        trace_open(trace_path);
 
-    // 인자: 목적지 ip, 목적지 port, 시나리오
-    const char *ip = argv[1];
-    int port = atoi(argv[2]);
-    Mode mode = parse_mode(argv[3]);
+    // 시뮬레이션 모드는 소켓 없이 시나리오만 받는다
+    if (sim)
+    {
+        if (argc < 1)
+        {
+            fprintf(stderr, "usage: sender -s <normal|dup3|timeout>\n");
+            return 1;
+        }
+        Mode mode = parse_mode(argv[0]);
+        if (mode == MODE_BULK)
+        {
+            fprintf(stderr, "bulk 모드는 실제 소켓에서만 실행됩니다\n");
+            return 1;
+        }
+        run_sim(mode);
+        trace_close();
+        return 0;
+    }
 
-    // 소켓 설정
-    int s = socket(AF_INET, SOCK_DGRAM, 0);
-    if (s < 0)
-        die("socket");
+    if (shm_name && (batch || evloop || pace_mode == PACE_FQ))
+    {
+        fprintf(stderr, "-M 은 -b, -e, -P fq 와 함께 쓸 수 없습니다 (소켓 전용)\n");
+        return 1;
+    }
+    if (argc < (shm_name ? 1 : 3))
+    {
+        fprintf(stderr, "usage: sender [-s] [-t] [-b] [-e] [-j] [-w wnd] [-q trace] [-c cc] [-C conn] [-n bytes | -T sec] [-A L] [-P pacing] [-F file] [-K] [-B bdp] [-g] [-M shm [-y]] <dst_ip> <dst_port> <mode>\n");
+        return 1;
+    }
 
+    // 인자: 목적지 ip, 목적지 port, 시나리오 (-M 이면 시나리오만)
+    Mode mode = parse_mode(argv[shm_name ? 0 : 2]);
+    if (pace_mode != PACE_OFF && mode != MODE_BULK)
+    {
+        fprintf(stderr, "-P 는 bulk 모드에서만 사용할 수 있습니다\n");
+        return 1;
+    }
+    if (bdp && mode != MODE_BULK)
+    {
+        fprintf(stderr, "-B 는 bulk 모드에서만 사용할 수 있습니다\n");
+        return 1;
+    }
+    if (gso && (mode != MODE_BULK || shm_name || wire_fmt == SEG_FMT_TEXT))
+    {
+        fprintf(stderr, "-g 는 UDP bulk 모드의 바이너리 헤더에서만 사용할 수 있습니다 (-M, -t 와 함께 못 씀)\n");
+        return 1;
+    }
+    if (src_path)
+    {
+        if (mode != MODE_BULK || bulk_us)
+        {
+            fprintf(stderr, "-F 는 bulk 모드에서 -T 없이만 사용할 수 있습니다\n");
+            return 1;
+        }
+        if (fio_map_src(&src, src_path) < 0)
+        {
+            fprintf(stderr, "빈 파일은 보낼 수 없습니다: %s\n", src_path);
+            return 1;
+        }
+        // 해시는 전송 전에 계산 (처리량 측정에서 제외)
+        src_hash = fio_hash(src.data, src.size);
+        bulk_bytes = src.size;
+        printf(YELLOW "[SND] file: %s (%lld bytes, mmap)\n" RESET, src_path, (long long)src.size);
+    }
     struct sockaddr_in dst;
     memset(&dst, 0, sizeof(dst));
-    dst.sin_family = AF_INET;
-    dst.sin_port = htons(port);
-    inet_pton(AF_INET, ip, &dst.sin_addr);
+    Transport tp;
+    if (shm_name)
+    {
+        tp_shm_open(&tp, shm_name, busy_poll, &n_syscalls);
+        printf(YELLOW "[SND] transport: %s (%s)\n" RESET, tp_name(&tp), tp.name);
+    }
+    else
+    {
+        // 소켓 설정
+        int s = socket(AF_INET, SOCK_DGRAM, 0);
+        if (s < 0)
+            die("socket");
+        dst.sin_family = AF_INET;
+        dst.sin_port = htons(atoi(argv[1]));
+        inet_pton(AF_INET, argv[0], &dst.sin_addr);
+        tp_udp(&tp, s, BUF, &n_syscalls);
+    }
+
+    if (batch)
+    {
+        txq = txb_new();
+        ackq = rxb_new(BUF, IO_BATCH);
+    }
+    if (gso)
+    {
+        if (udp_gso_probe(tp.fd))
+        {
+            gsoq = gsob_new();
+            printf(YELLOW "[SND] UDP GSO on (up to %d segments per datagram)\n" RESET,
+                   GSO_MAX_BYTES / (SEG_HDR_LEN + MSS));
+        }
+        else
+            printf(YELLOW "[SND] UDP GSO 를 쓸 수 없음 (커널 미지원), 세그먼트를 하나씩 보냄\n" RESET);
+    }
 
     // 인자에 따라 시나리오 실행
     if (mode == MODE_NORMAL)
-        run_normal(s, &dst);
+        run_normal(&tp, &dst);
     else if (mode == MODE_DUP3)
-        run_dup3(s, &dst);
+        run_dup3(&tp, &dst);
     else if (mode == MODE_TIMEOUT)
-        run_timeout(s, &dst);
+        run_timeout(&tp, &dst);
+    else if (mode == MODE_BULK && evloop)
+        run_bulk_ev(&tp, &dst, bulk_bytes, bulk_us);
+    else if (mode == MODE_BULK)
+        run_bulk(&tp, &dst, bulk_bytes, bulk_us);
 
-    close(s);
+    if (batch)
+    {
+        free(txq);
+        rxb_free(ackq);
+    }
+    free(gsoq);
+    trace_close();
+    if (src.data)
+        fio_unmap_src(&src);
+    if (tp.fd >= 0)
+        close(tp.fd);
+    tp_close(&tp);
     return 0;
 }
\ No newline at end of file
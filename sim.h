@@ -0,0 +1,125 @@
+// sim.h - 가상 시계 기반 이산 사건(discrete-event) 스케줄러
+// 패킷 전송, ACK 도착, RTO 만료 등을 (시각, 사건) 으로 우선순위 큐(최소 힙)에 넣고
+// 가장 이른 사건부터 꺼내며 가상 시계를 그 시각으로 옮긴다. 실제 sleep 이 없으므로
+// 시나리오 전체가 CPU 속도로 끝난다.
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "common.h"
+
+typedef enum
+{
+    EV_ROUND,       // 송신측: 새 라운드(윈도우) 시작
+    EV_TX,          // 송신측: 세그먼트 전송
+    EV_DATA_ARRIVE, // 수신측: DATA 도착
+    EV_ACK_ARRIVE,  // 송신측: ACK 도착
+    EV_RTO          // 송신측: 재전송 타이머 만료
+} EventType;
+
+typedef struct
+{
+    uint64_t t;  // 발생 시각 (가상 시계, us)
+    uint64_t id; // 같은 시각이면 먼저 예약된 사건이 먼저 (FIFO)
+    EventType type;
+    int64_t seq;
+    int len;
+    int64_t ack;
+    int gen; // RTO 타이머 세대 (재무장/해제된 타이머 구분용)
+} Event;
+
+typedef struct
+{
+    Event *heap;
+    int n, cap;
+    uint64_t now;     // 현재 가상 시각 (us)
+    uint64_t next_id;
+    uint64_t handled; // 처리한 사건 수
+} Sim;
+
+static inline void sim_init(Sim *sim)
+{
+    sim->n = 0;
+    sim->cap = 64;
+    sim->heap = malloc(sizeof(Event) * sim->cap);
+    if (!sim->heap)
+        die("malloc sim");
+    sim->now = 0;
+    sim->next_id = 0;
+    sim->handled = 0;
+}
+
+static inline void sim_free(Sim *sim)
+{
+    free(sim->heap);
+    sim->heap = NULL;
+    sim->n = sim->cap = 0;
+}
+
+static inline int sim_before(const Event *a, const Event *b)
+{
+    return a->t < b->t || (a->t == b->t && a->id < b->id);
+}
+
+// 현재 시각으로부터 delay_us 뒤에 사건 ev 를 예약
+static inline void sim_at(Sim *sim, uint64_t delay_us, Event ev)
+{
+    if (sim->n == sim->cap)
+    {
+        sim->cap *= 2;
+        Event *h = realloc(sim->heap, sizeof(Event) * sim->cap);
+        if (!h)
+            die("realloc sim");
+        sim->heap = h;
+    }
+
+    ev.t = sim->now + delay_us;
+    ev.id = sim->next_id++;
+
+    // sift-up
+    int i = sim->n++;
+    while (i > 0)
+    {
+        int p = (i - 1) / 2;
+        if (!sim_before(&ev, &sim->heap[p]))
+            break;
+        sim->heap[i] = sim->heap[p];
+        i = p;
+    }
+    sim->heap[i] = ev;
+}
+
+// 가장 이른 사건을 꺼내고 가상 시계를 그 시각으로 이동. 큐가 비면 0 반환
+static inline int sim_next(Sim *sim, Event *out)
+{
+    if (sim->n == 0)
+        return 0;
+
+    *out = sim->heap[0];
+    Event last = sim->heap[--sim->n];
+
+    // sift-down
+    int i = 0;
+    while (1)
+    {
+        int c = 2 * i + 1;
+        if (c >= sim->n)
+            break;
+        if (c + 1 < sim->n && sim_before(&sim->heap[c + 1], &sim->heap[c]))
+            c++;
+        if (!sim_before(&sim->heap[c], &last))
+            break;
+        sim->heap[i] = sim->heap[c];
+        i = c;
+    }
+    if (sim->n > 0)
+        sim->heap[i] = last;
+
+    sim->now = out->t;
+    sim->handled++;
+    return 1;
+}
+
+#endif
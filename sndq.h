@@ -0,0 +1,273 @@
+// sndq.h - 송신측 재전송 큐 (보냈지만 아직 확인되지 않은 세그먼트)
+// 세그먼트 기술자는 보낸 순서대로 고정 용량 링에 두고, 페이로드는 MSS 크기 버퍼 cap 개를
+// 미리 잡아 둔 슬랩에서 빈 목록(스택)으로 꺼내 쓴다. 패킷마다 malloc/free 가 없다.
+//   - seq 로 찾기: 세그먼트는 MSS 경계에 놓이므로 (seq - 맨 앞 seq) / MSS 가 링 위치 (O(1))
+//   - 누적 ACK: 링 앞에서 확인된 세그먼트를 떼어 내며 버퍼를 빈 목록에 돌려줌 (세그먼트당 O(1))
+//   - SACK: 블록에 완전히 들어간 세그먼트를 비트맵에 표시하고 버퍼를 바로 돌려줌.
+//           이미 표시된 구간은 reorder.h 처럼 64비트 워드 단위로 건너뛰므로 같은 블록이 ACK 마다
+//           반복돼도 새로 표시할 세그먼트만 본다. 기술자는 누적 ACK 가 지나갈 때까지 링에 남아
+//           구멍(재전송 대상) 판단에 쓰인다. 최근 블록 몇 개는 어디까지 표시했는지 기억해 두어,
+//           수신측이 매 ACK 마다 같은 시작점으로 조금씩 늘려 보내는 블록은 늘어난 부분만 본다
+//           (윈도우가 수만 세그먼트여도 ACK 당 일이 일정)
+// 재전송은 슬랩에 남아 있는 원본 바이트를 그대로 다시 보낸다.
+// sq_set_source 로 원본(파일 매핑 등)을 붙이면 슬랩 없이 세그먼트가 원본의 seq 위치를 가리킨다.
+#ifndef SNDQ_H
+#define SNDQ_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+
+#define SQ_NOBUF UINT32_MAX
+#define SQ_SACK_MEMO 4 // 기억해 두는 최근 SACK 블록 수 (ACK 에 실리는 최대 블록 수)
+
+typedef struct
+{
+    int64_t seq;
+    uint32_t len;
+    uint32_t buf;     // 슬랩 버퍼 번호 (SACK 로 확인되면 SQ_NOBUF)
+    uint64_t sent_at; // 마지막 송신 시각 (us)
+    uint32_t xmits;   // 송신 횟수 (2 이상이면 재전송된 세그먼트, Karn 규칙)
+} SqSeg;
+
+typedef struct
+{
+    SqSeg *segs;      // 링 (cap 은 2의 거듭제곱)
+    uint8_t *slab;    // cap * MSS 바이트 (원본을 붙였으면 NULL)
+    const uint8_t *src; // 페이로드 원본 (바이트 seq 가 src[seq], NULL 이면 슬랩에 복사)
+    uint64_t *sacked; // SACK 로 확인된 세그먼트 비트맵 (비트 = 링 위치 % cap)
+    uint32_t *free;   // 빈 버퍼 번호 스택
+    uint32_t nfree;
+    uint32_t cap;
+    uint64_t head, tail; // 링 위치 [head, tail) 가 미확인 세그먼트
+    int64_t sacked_hi;   // SACK 로 확인된 가장 높은 바이트 + 1 (없으면 0)
+    uint64_t sacked_bytes;
+    struct
+    {
+        int64_t start; // 블록 시작 바이트
+        uint64_t done; // 이 블록으로 표시를 마친 링 위치 (여기까지는 다시 보지 않음)
+    } memo[SQ_SACK_MEMO];
+    uint32_t memo_next; // 다음에 덮어쓸 memo 칸
+} SndQ;
+
+static inline void sq_init(SndQ *q, uint32_t cap)
+{
+    uint32_t c = 64;
+    while (c < cap)
+        c <<= 1;
+    memset(q, 0, sizeof(*q));
+    q->cap = c;
+    q->segs = malloc(sizeof(SqSeg) * c);
+    q->slab = malloc((size_t)c * MSS);
+    q->free = malloc(sizeof(uint32_t) * c);
+    q->sacked = calloc(c / 64, sizeof(uint64_t));
+    if (!q->segs || !q->slab || !q->free || !q->sacked)
+        die("malloc sndq");
+    // 낮은 번호부터 꺼내도록 거꾸로 쌓음 (처음 채울 때 슬랩을 앞에서부터 씀)
+    for (uint32_t i = 0; i < c; i++)
+        q->free[i] = c - 1 - i;
+    q->nfree = c;
+}
+
+// 페이로드를 복사하지 않고 src 에서 바로 보냄 (src 는 큐를 쓰는 동안 유효해야 함). 슬랩은 반환
+static inline void sq_set_source(SndQ *q, const uint8_t *src)
+{
+    free(q->slab);
+    q->slab = NULL;
+    q->src = src;
+}
+
+static inline void sq_free(SndQ *q)
+{
+    free(q->segs);
+    free(q->slab);
+    free(q->free);
+    free(q->sacked);
+    memset(q, 0, sizeof(*q));
+}
+
+static inline uint32_t sq_count(const SndQ *q)
+{
+    return (uint32_t)(q->tail - q->head);
+}
+
+static inline int sq_full(const SndQ *q)
+{
+    return sq_count(q) >= q->cap;
+}
+
+static inline SqSeg *sq_at(SndQ *q, uint64_t pos)
+{
+    return &q->segs[pos & (q->cap - 1)];
+}
+
+// 가장 오래된 미확인 세그먼트 (없으면 NULL)
+static inline SqSeg *sq_head(SndQ *q)
+{
+    return q->head == q->tail ? NULL : sq_at(q, q->head);
+}
+
+static inline int sq_is_sacked(const SndQ *q, uint64_t pos)
+{
+    uint32_t i = pos & (q->cap - 1);
+    return (q->sacked[i / 64] >> (i % 64)) & 1;
+}
+
+static inline void sq_mark(SndQ *q, uint64_t pos, int bit)
+{
+    uint32_t i = pos & (q->cap - 1);
+    if (bit)
+        q->sacked[i / 64] |= 1ULL << (i % 64);
+    else
+        q->sacked[i / 64] &= ~(1ULL << (i % 64));
+}
+
+// from 위치부터 SACK 비트가 bit 인 세그먼트가 연속으로 몇 개인지 (최대 limit). 64비트 단위로 센다
+static inline uint32_t sq_span(const SndQ *q, uint64_t from, uint32_t limit, int bit)
+{
+    uint32_t n = 0;
+    while (n < limit)
+    {
+        uint32_t i = (from + n) & (q->cap - 1);
+        uint64_t w = q->sacked[i / 64] >> (i % 64);
+        if (!bit)
+            w = ~w;
+        uint32_t avail = 64 - i % 64;
+        uint32_t same = ~w ? (uint32_t)__builtin_ctzll(~w) : 64;
+        if (same > avail)
+            same = avail;
+        n += same;
+        if (same < avail)
+            break;
+    }
+    return n < limit ? n : limit;
+}
+
+static inline const uint8_t *sq_data(const SndQ *q, const SqSeg *s)
+{
+    if (q->src)
+        return q->src + s->seq;
+    return q->slab + (size_t)s->buf * MSS;
+}
+
+static inline void sq_release(SndQ *q, SqSeg *s)
+{
+    if (s->buf != SQ_NOBUF)
+    {
+        q->free[q->nfree++] = s->buf;
+        s->buf = SQ_NOBUF;
+    }
+}
+
+// 새 세그먼트를 뒤에 붙이고 data 의 len 바이트를 버퍼에 복사 (원본이 붙어 있으면 복사 없음). 가득 찼으면 NULL
+static inline SqSeg *sq_push(SndQ *q, int64_t seq, const void *data, uint32_t len)
+{
+    if (sq_full(q) || len > MSS)
+        return NULL;
+    SqSeg *s = sq_at(q, q->tail++);
+    s->seq = seq;
+    s->len = len;
+    s->sent_at = 0;
+    s->xmits = 0;
+    sq_mark(q, q->tail - 1, 0);
+    if (q->src)
+    {
+        s->buf = SQ_NOBUF;
+        return s;
+    }
+    s->buf = q->free[--q->nfree];
+    memcpy(q->slab + (size_t)s->buf * MSS, data, len);
+    return s;
+}
+
+// seq 가 속한 세그먼트의 링 위치. 맨 앞보다 앞이면 head, 큐 뒤면 tail
+static inline uint64_t sq_pos(const SndQ *q, int64_t seq)
+{
+    if (q->head == q->tail)
+        return q->tail;
+    int64_t base = q->segs[q->head & (q->cap - 1)].seq;
+    if (seq <= base)
+        return q->head;
+    uint64_t k = (uint64_t)((seq - base) / MSS);
+    return k < q->tail - q->head ? q->head + k : q->tail;
+}
+
+// seq 에서 시작하는 세그먼트 (큐에 없으면 NULL)
+static inline SqSeg *sq_find(SndQ *q, int64_t seq)
+{
+    uint64_t pos = sq_pos(q, seq);
+    if (pos == q->tail)
+        return NULL;
+    SqSeg *s = sq_at(q, pos);
+    return s->seq == seq ? s : NULL;
+}
+
+// 누적 ACK: ack 아래로 끝나는 세그먼트를 모두 떼어 냄. 떼어 낸 개수 반환
+static inline uint32_t sq_ack(SndQ *q, int64_t ack)
+{
+    uint32_t n = 0;
+    while (q->head != q->tail)
+    {
+        SqSeg *s = sq_at(q, q->head);
+        if (s->seq + (int64_t)s->len > ack)
+            break;
+        if (sq_is_sacked(q, q->head))
+            q->sacked_bytes -= s->len;
+        sq_release(q, s);
+        q->head++;
+        n++;
+    }
+    if (q->sacked_hi <= ack)
+        q->sacked_hi = 0; // 남은 SACK 정보 없음
+    return n;
+}
+
+// SACK 블록 [start, end) 에 완전히 들어간 세그먼트를 표시. 새로 표시한 개수 반환
+static inline uint32_t sq_sack(SndQ *q, int64_t start, int64_t end)
+{
+    if (q->head == q->tail || end <= start)
+        return 0;
+    // [pos, last) 가 블록에 완전히 들어가는 세그먼트
+    uint64_t pos = sq_pos(q, start);
+    if (pos < q->tail && sq_at(q, pos)->seq < start)
+        pos++;
+    uint64_t last = sq_pos(q, end);
+    if (last < q->tail && sq_at(q, last)->seq + (int64_t)sq_at(q, last)->len <= end)
+        last++;
+    // 같은 시작점의 블록을 전에 처리했으면 그때 끝낸 위치부터 (링 위치는 계속 증가하므로 그대로 유효)
+    uint32_t m = 0;
+    while (m < SQ_SACK_MEMO && q->memo[m].start != start)
+        m++;
+    if (m == SQ_SACK_MEMO)
+    {
+        m = q->memo_next++ % SQ_SACK_MEMO;
+        q->memo[m].start = start;
+        q->memo[m].done = 0;
+    }
+    else if (q->memo[m].done > pos)
+        pos = q->memo[m].done;
+    if (last > q->memo[m].done)
+        q->memo[m].done = last;
+
+    uint32_t n = 0;
+    while (pos < last)
+    {
+        pos += sq_span(q, pos, (uint32_t)(last - pos), 1); // 이미 표시된 구간
+        uint32_t run = pos < last ? sq_span(q, pos, (uint32_t)(last - pos), 0) : 0;
+        for (uint32_t k = 0; k < run; k++, pos++)
+        {
+            SqSeg *s = sq_at(q, pos);
+            sq_mark(q, pos, 1);
+            q->sacked_bytes += s->len;
+            sq_release(q, s);
+            n++;
+        }
+    }
+    if (n && end > q->sacked_hi)
+        q->sacked_hi = end;
+    return n;
+}
+
+#endif
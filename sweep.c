@@ -0,0 +1,545 @@
+// sweep.c - 혼잡제어 파라미터 몬테카를로 스윕
+// 실행 방법:
+//   ./sweep [-a algos] [-l losses] [-r rtts_ms] [-i init_cwnds] [-s ssthreshs] [-B mbps] [-Q buf_pkts]
+//           [-n bytes] [-R runs] [-j threads] [-S seed] [-o out.csv]
+//   algos      : reno,newreno,cubic,bbr 중 쉼표로 구분 (기본 전부)
+//   losses     : 임의 손실률 (기본 0,0.001,0.01)
+//   rtts_ms    : 왕복 전파 지연 (기본 10,50,100)
+//   init_cwnds : 초기 cwnd, MSS 개수 (기본 1,10)
+//   ssthreshs  : 초기 ssthresh, 바이트 (기본 15000,65535,1000000)
+// 소켓 없이 sim.h 가상 시계 위에서 송신측(cc.h, rto.h)과 수신측(rcv_logic.h) 상태 기계를 돌린다.
+// 경로는 병목 링크 하나(속도 -B, drop-tail 버퍼 -Q 패킷) + 시드 고정 임의 손실 + 왕복 전파 지연.
+// 조합 × 반복(-R) 개의 독립 실행을 작업 훔치기 풀(pool.h)에 나눠 돌리고, 조합별 goodput 과
+// 수렴 시간의 평균/표준편차/분위수를 표로 출력한다. 결과는 스레드 수와 무관하게 같다.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "common.h"
+#include "sim.h"
+#include "cc.h"
+#include "rto.h"
+#include "rcv_logic.h"
+#include "pool.h"
+
+#define SW_MAX_ITEMS 16
+#define SW_RING_MIN 8192          // 재정렬 버퍼/송신 시각 링의 최소 크기 (MSS 블록 수)
+#define SW_TIME_LIMIT_US 600000000 // 실행 하나의 가상 시간 상한
+#define SW_CONV_WIN 4             // 수렴 판정 구간 (RTT 개수)
+#define SW_CONV_FRAC 0.9          // 정상 상태 전송률의 이 비율에 도달하면 수렴
+
+// 그리드의 한 점
+typedef struct
+{
+    const CcOps *algo;
+    double loss;
+    uint64_t rtt_us;
+    int init_cwnd; // MSS
+    double ssthresh;
+} Point;
+
+// 실행 하나의 결과
+typedef struct
+{
+    double goodput; // Mbit/s
+    double conv_ms; // 수렴 시간
+    uint64_t retx, timeouts, drops_q, drops_rand;
+    int done; // 시간 상한 안에 전송을 마쳤는지
+} RunResult;
+
+typedef struct
+{
+    Point *pts;
+    int npts;
+    int runs;
+    uint64_t seed;
+    uint64_t rate_bps;
+    int buf_pkts;
+    int64_t total;
+    RunResult *res; // [점 * runs + 반복]
+} Sweep;
+
+// ------------------------------ 실행 하나 ------------------------------
+typedef struct
+{
+    Sim sim;
+    RcvState rcv;
+    Cc cc;
+    Rto rto;
+    uint64_t rng;
+    const Point *pt;
+    const Sweep *sw;
+
+    // 병목 링크
+    uint64_t tx_us;     // MSS 하나의 직렬화 시간
+    uint64_t link_free; // 링크가 비는 시각 (그 전까지는 큐에 쌓인 패킷을 내보내는 중)
+
+    // 송신측
+    int64_t snd_una, snd_nxt, snd_max;
+    int dups;
+    int in_recovery;
+    int64_t recover; // 복구 시작 시점의 snd_max (NewReno)
+    int rto_gen;
+    uint32_t ring;       // 송신 시각 링과 수신측 재정렬 버퍼의 크기 (2의 거듭제곱, 블록 수) = 수신 윈도우
+    uint64_t *sent_at;   // 세그먼트별 송신 시각
+    uint8_t *retx_mark;
+
+    // 수렴 판정용: 기준 RTT 마다 snd_una 기록
+    int64_t *marks;
+    int nmarks, cap_marks;
+    uint64_t next_mark;
+
+    RunResult r;
+} SimFlow;
+
+// splitmix64: 실행마다 독립된 시드 스트림
+static uint64_t sm_next(uint64_t *s)
+{
+    uint64_t z = (*s += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static int chance(uint64_t *s, double p)
+{
+    return p > 0 && (sm_next(s) >> 11) * (1.0 / 9007199254740992.0) < p;
+}
+
+static void sf_arm_rto(SimFlow *f)
+{
+    Event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = EV_RTO;
+    ev.gen = ++f->rto_gen;
+    sim_at(&f->sim, rto_get(&f->rto), ev);
+}
+
+// 세그먼트 하나를 병목 링크에 넣는다. 큐가 가득 차거나 임의 손실이면 버려짐
+static void sf_send(SimFlow *f, int64_t seq)
+{
+    uint64_t now = f->sim.now;
+    uint32_t slot = (uint32_t)(seq / MSS) & (f->ring - 1);
+    f->sent_at[slot] = now;
+    f->retx_mark[slot] = seq < f->snd_max;
+    if (seq < f->snd_max)
+        f->r.retx++;
+    if (seq + MSS > f->snd_max)
+        f->snd_max = seq + MSS;
+
+    if (f->link_free < now)
+        f->link_free = now;
+    // 큐 길이 = 링크가 비기까지 남은 시간 / 직렬화 시간
+    if ((f->link_free - now) / f->tx_us >= (uint64_t)f->sw->buf_pkts)
+    {
+        f->r.drops_q++;
+        return;
+    }
+    f->link_free += f->tx_us;
+    if (chance(&f->rng, f->pt->loss))
+    {
+        f->r.drops_rand++;
+        return;
+    }
+
+    Event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = EV_DATA_ARRIVE;
+    ev.seq = seq;
+    ev.len = MSS;
+    sim_at(&f->sim, f->link_free - now + f->pt->rtt_us / 2, ev);
+}
+
+// 윈도우가 허락하는 만큼 전송
+static void sf_fill(SimFlow *f)
+{
+    int idle = f->snd_nxt == f->snd_una;
+    // cwnd 와 수신 윈도우(재정렬 버퍼) 중 작은 쪽까지. 윈도우 밖 세그먼트를 수신측이 조용히 버리지 않게
+    int64_t rwnd = (int64_t)f->ring * MSS;
+    while (f->snd_nxt < f->sw->total && f->snd_nxt - f->snd_una + MSS <= f->cc.cwnd &&
+           f->snd_nxt - f->snd_una + MSS <= rwnd)
+    {
+        sf_send(f, f->snd_nxt);
+        f->snd_nxt += MSS;
+    }
+    if (idle && f->snd_nxt > f->snd_una)
+        sf_arm_rto(f);
+}
+
+static void sf_mark(SimFlow *f)
+{
+    while (f->sim.now >= f->next_mark)
+    {
+        if (f->nmarks == f->cap_marks)
+        {
+            f->cap_marks = f->cap_marks ? f->cap_marks * 2 : 256;
+            f->marks = realloc(f->marks, sizeof(int64_t) * f->cap_marks);
+            if (!f->marks)
+                die("realloc marks");
+        }
+        f->marks[f->nmarks++] = f->snd_una;
+        f->next_mark += f->pt->rtt_us;
+    }
+}
+
+static void sf_on_ack(SimFlow *f, int64_t ack)
+{
+    uint64_t now = f->sim.now;
+    if (ack > f->snd_una)
+    {
+        // 확인된 가장 마지막 세그먼트의 RTT (재전송된 것은 제외, Karn 규칙)
+        uint32_t slot = (uint32_t)((ack - MSS) / MSS) & (f->ring - 1);
+        if (!f->retx_mark[slot])
+        {
+            uint64_t rtt = now - f->sent_at[slot];
+            rto_sample(&f->rto, rtt);
+            cc_on_rtt_sample(&f->cc, rtt, now);
+        }
+
+        uint32_t acked = (uint32_t)(ack - f->snd_una);
+        f->snd_una = ack;
+        if (f->snd_nxt < f->snd_una)
+            f->snd_nxt = f->snd_una;
+        f->dups = 0;
+
+        if (f->in_recovery && ack < f->recover)
+        {
+            // partial ACK: 다음 구멍을 바로 재전송 (NewReno)
+            cc_on_ack(&f->cc, acked, 1, now);
+            sf_send(f, f->snd_una);
+        }
+        else
+        {
+            f->in_recovery = 0;
+            cc_on_ack(&f->cc, acked, 0, now);
+        }
+
+        if (f->snd_una < f->snd_nxt)
+            sf_arm_rto(f);
+        else
+            f->rto_gen++; // 미확인 없음: 타이머 해제
+    }
+    else if (f->snd_nxt > f->snd_una)
+    {
+        f->dups++;
+        if (!f->in_recovery || f->dups != 3)
+            cc_on_dupack(&f->cc, f->dups, now);
+        if (!f->in_recovery && f->dups == 3)
+        {
+            f->in_recovery = 1;
+            f->recover = f->snd_max;
+            sf_send(f, f->snd_una);
+        }
+    }
+    sf_fill(f);
+}
+
+static void sf_on_rto(SimFlow *f)
+{
+    f->r.timeouts++;
+    cc_on_timeout(&f->cc, f->sim.now);
+    rto_backoff(&f->rto);
+    // go-back-N: 가장 오래된 미확인부터 다시 (수신측 재정렬 버퍼가 이미 받은 것은 누적 ACK 로 건너뜀)
+    f->snd_nxt = f->snd_una;
+    f->in_recovery = 0;
+    f->dups = 0;
+    sf_fill(f);
+}
+
+// 정상 상태(후반부) 전송률의 SW_CONV_FRAC 배에 처음 도달한 시각
+static double sf_convergence(const SimFlow *f, uint64_t elapsed)
+{
+    int n = f->nmarks;
+    if (n < 2 * SW_CONV_WIN)
+        return elapsed / 1e3;
+    double steady = (double)(f->marks[n - 1] - f->marks[n / 2]) / (n - 1 - n / 2);
+    for (int k = 0; k + SW_CONV_WIN < n; k++)
+    {
+        double rate = (double)(f->marks[k + SW_CONV_WIN] - f->marks[k]) / SW_CONV_WIN;
+        if (rate >= SW_CONV_FRAC * steady)
+            return k * f->pt->rtt_us / 1e3;
+    }
+    return elapsed / 1e3;
+}
+
+static void run_flow(const Sweep *sw, const Point *pt, uint64_t seed, RunResult *out)
+{
+    SimFlow *f = calloc(1, sizeof(*f));
+    if (!f)
+        die("calloc flow");
+    f->sw = sw;
+    f->pt = pt;
+    f->rng = seed;
+    f->tx_us = (uint64_t)MSS * 8 * 1000000 / sw->rate_bps;
+    if (!f->tx_us)
+        f->tx_us = 1;
+    sim_init(&f->sim);
+    // 느린시작은 BDP + 버퍼를 두 배 가까이 넘겨 보낼 수 있으므로 bdp_segs(BDP + 버퍼) 이상으로 잡음
+    int64_t pipe = (int64_t)(sw->rate_bps / 8 * pt->rtt_us / 1000000) + (int64_t)sw->buf_pkts * MSS;
+    f->ring = SW_RING_MIN;
+    while (f->ring < bdp_segs(pipe))
+        f->ring <<= 1;
+    f->sent_at = calloc(f->ring, sizeof(uint64_t));
+    f->retx_mark = calloc(f->ring, 1);
+    if (!f->sent_at || !f->retx_mark)
+        die("calloc ring");
+    rcv_init(&f->rcv, MODE_BULK, f->ring);
+    f->rcv.quiet = 1;
+    cc_init(&f->cc, pt->algo, (double)pt->init_cwnd * MSS, pt->ssthresh);
+    rto_init(&f->rto);
+
+    sf_fill(f);
+    Event ev;
+    while (f->snd_una < sw->total && f->sim.now < SW_TIME_LIMIT_US && sim_next(&f->sim, &ev))
+    {
+        sf_mark(f);
+        if (ev.type == EV_DATA_ARRIVE)
+        {
+            int64_t ack;
+            if (rcv_on_data(&f->rcv, MODE_BULK, ev.seq, ev.len, &ack))
+            {
+                Event a;
+                memset(&a, 0, sizeof(a));
+                a.type = EV_ACK_ARRIVE;
+                a.ack = ack;
+                sim_at(&f->sim, pt->rtt_us / 2, a);
+            }
+        }
+        else if (ev.type == EV_ACK_ARRIVE)
+            sf_on_ack(f, ev.ack);
+        else if (ev.type == EV_RTO && ev.gen == f->rto_gen)
+            sf_on_rto(f);
+    }
+
+    uint64_t elapsed = f->sim.now ? f->sim.now : 1;
+    f->r.done = f->snd_una >= sw->total;
+    f->r.goodput = f->snd_una * 8.0 / elapsed; // bit/us = Mbit/s
+    f->r.conv_ms = sf_convergence(f, elapsed);
+    *out = f->r;
+
+    free(f->marks);
+    free(f->sent_at);
+    free(f->retx_mark);
+    rcv_free(&f->rcv);
+    sim_free(&f->sim);
+    free(f);
+}
+
+static void sweep_task(void *arg, uint32_t task, int worker)
+{
+    (void)worker;
+    Sweep *sw = arg;
+    uint32_t p = task / sw->runs, rep = task % sw->runs;
+    // 시드는 (기본 시드, 점, 반복) 으로만 정해져 어느 워커가 실행해도 같음
+    uint64_t s = sw->seed ^ ((uint64_t)p << 32 | rep);
+    uint64_t seed = sm_next(&s);
+    run_flow(sw, &sw->pts[p], seed, &sw->res[task]);
+}
+
+// ------------------------------ 집계 ------------------------------
+typedef struct
+{
+    double mean, sd, p10, p50, p90;
+} Stat;
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// v 를 정렬한 뒤 평균/표준편차/분위수
+static Stat stat_of(double *v, int n)
+{
+    Stat s;
+    memset(&s, 0, sizeof(s));
+    if (!n)
+        return s;
+    qsort(v, n, sizeof(double), cmp_double);
+    double sum = 0, sq = 0;
+    for (int i = 0; i < n; i++)
+        sum += v[i];
+    s.mean = sum / n;
+    for (int i = 0; i < n; i++)
+        sq += (v[i] - s.mean) * (v[i] - s.mean);
+    s.sd = n > 1 ? sqrt(sq / (n - 1)) : 0;
+    s.p10 = v[(int)(0.1 * (n - 1) + 0.5)];
+    s.p50 = v[(int)(0.5 * (n - 1) + 0.5)];
+    s.p90 = v[(int)(0.9 * (n - 1) + 0.5)];
+    return s;
+}
+
+// 쉼표로 구분된 목록을 잘라 items 에 넣고 개수 반환 (s 는 수정됨)
+static int split(char *s, char *items[])
+{
+    int n = 0;
+    for (char *save = NULL, *t = strtok_r(s, ",", &save); t && n < SW_MAX_ITEMS; t = strtok_r(NULL, ",", &save))
+        items[n++] = t;
+    return n;
+}
+
+int main(int argc, char **argv)
+{
+    char algos_s[256] = "reno,newreno,cubic,bbr";
+    char losses_s[256] = "0,0.001,0.01";
+    char rtts_s[256] = "10,50,100";
+    char inits_s[256] = "1,10";
+    char threshs_s[256] = "15000,65535,1000000";
+    double mbps = 100;
+    const char *csv_path = NULL;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+    Sweep sw;
+    memset(&sw, 0, sizeof(sw));
+    sw.buf_pkts = 100;
+    sw.total = 5000000;
+    sw.runs = 16;
+    sw.seed = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "a:l:r:i:s:B:Q:n:R:j:S:o:")) != -1)
+    {
+        if (opt == 'a')
+            snprintf(algos_s, sizeof(algos_s), "%s", optarg);
+        else if (opt == 'l')
+            snprintf(losses_s, sizeof(losses_s), "%s", optarg);
+        else if (opt == 'r')
+            snprintf(rtts_s, sizeof(rtts_s), "%s", optarg);
+        else if (opt == 'i')
+            snprintf(inits_s, sizeof(inits_s), "%s", optarg);
+        else if (opt == 's')
+            snprintf(threshs_s, sizeof(threshs_s), "%s", optarg);
+        else if (opt == 'B')
+            mbps = atof(optarg);
+        else if (opt == 'Q')
+            sw.buf_pkts = atoi(optarg);
+        else if (opt == 'n')
+            sw.total = strtoll(optarg, NULL, 10);
+        else if (opt == 'R')
+            sw.runs = atoi(optarg);
+        else if (opt == 'j')
+            threads = atoi(optarg);
+        else if (opt == 'S')
+            sw.seed = strtoull(optarg, NULL, 10);
+        else if (opt == 'o')
+            csv_path = optarg;
+        else
+        {
+            fprintf(stderr, "usage: %s [-a algos] [-l losses] [-r rtts_ms] [-i init_cwnds] [-s ssthreshs] "
+                            "[-B mbps] [-Q buf_pkts] [-n bytes] [-R runs] [-j threads] [-S seed] [-o out.csv]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (mbps <= 0 || sw.buf_pkts < 1 || sw.total < MSS || sw.runs < 1 || threads < 1)
+    {
+        fprintf(stderr, "-B, -Q, -R, -j 는 양수, -n 은 %d 이상이어야 합니다\n", MSS);
+        return 1;
+    }
+    sw.rate_bps = (uint64_t)(mbps * 1e6);
+
+    char *algos[SW_MAX_ITEMS], *losses[SW_MAX_ITEMS], *rtts[SW_MAX_ITEMS], *inits[SW_MAX_ITEMS], *threshs[SW_MAX_ITEMS];
+    int na = split(algos_s, algos), nl = split(losses_s, losses), nr = split(rtts_s, rtts);
+    int ni = split(inits_s, inits), ns = split(threshs_s, threshs);
+
+    sw.npts = na * nl * nr * ni * ns;
+    sw.pts = calloc(sw.npts, sizeof(Point));
+    if (!sw.pts)
+        die("calloc points");
+    int k = 0;
+    for (int a = 0; a < na; a++)
+    {
+        const CcOps *ops = cc_find(algos[a]);
+        if (!ops)
+        {
+            fprintf(stderr, "unknown cc: %s (reno|newreno|cubic|bbr)\n", algos[a]);
+            return 1;
+        }
+        for (int l = 0; l < nl; l++)
+            for (int r = 0; r < nr; r++)
+                for (int i = 0; i < ni; i++)
+                    for (int s = 0; s < ns; s++)
+                    {
+                        Point *p = &sw.pts[k++];
+                        p->algo = ops;
+                        p->loss = atof(losses[l]);
+                        p->rtt_us = (uint64_t)(atof(rtts[r]) * 1000);
+                        p->init_cwnd = atoi(inits[i]) > 0 ? atoi(inits[i]) : 1;
+                        p->ssthresh = atof(threshs[s]);
+                    }
+    }
+
+    uint32_t ntasks = (uint32_t)sw.npts * sw.runs;
+    sw.res = calloc(ntasks, sizeof(RunResult));
+    if (!sw.res)
+        die("calloc results");
+
+    printf(BOLDMAG "=== [SWEEP] %d 조합 x %d 회 = %u 실행, %lld bytes, 병목 %.0f Mbit/s / 버퍼 %d pkts, 스레드 %ld ===\n" RESET,
+           sw.npts, sw.runs, ntasks, (long long)sw.total, mbps, sw.buf_pkts, threads);
+    uint64_t t0 = now_us();
+    uint64_t steals = pool_run(ntasks, (int)threads, sweep_task, &sw);
+    uint64_t wall = now_us() - t0;
+
+    FILE *csv = NULL;
+    if (csv_path)
+    {
+        csv = fopen(csv_path, "w");
+        if (!csv)
+            die("fopen csv");
+        fprintf(csv, "algo,loss,rtt_ms,init_cwnd,ssthresh,runs,incomplete,goodput_mean,goodput_sd,goodput_p10,"
+                     "goodput_p50,goodput_p90,util,conv_ms_mean,conv_ms_p50,conv_ms_p90,retx_mean,timeouts_mean,"
+                     "drops_queue_mean,drops_random_mean\n");
+    }
+
+    printf("%-8s %7s %5s %4s %8s | %8s %7s %8s %6s | %8s %8s | %7s %6s\n",
+           "algo", "loss", "rtt", "iw", "ssthresh", "Mbit/s", "sd", "p10", "util%", "conv p50", "conv p90",
+           "retx", "rto");
+    double *gp = malloc(sizeof(double) * sw.runs), *cv = malloc(sizeof(double) * sw.runs);
+    if (!gp || !cv)
+        die("malloc stats");
+    for (int p = 0; p < sw.npts; p++)
+    {
+        const Point *pt = &sw.pts[p];
+        const RunResult *res = &sw.res[(size_t)p * sw.runs];
+        double retx = 0, tos = 0, dq = 0, dr = 0;
+        int incomplete = 0;
+        for (int i = 0; i < sw.runs; i++)
+        {
+            gp[i] = res[i].goodput;
+            cv[i] = res[i].conv_ms;
+            retx += res[i].retx;
+            tos += res[i].timeouts;
+            dq += res[i].drops_q;
+            dr += res[i].drops_rand;
+            incomplete += !res[i].done;
+        }
+        Stat g = stat_of(gp, sw.runs), c = stat_of(cv, sw.runs);
+        double util = g.mean / mbps * 100;
+
+        printf("%-8s %7g %5.0f %4d %8.0f | %8.2f %7.2f %8.2f %6.1f | %8.0f %8.0f | %7.1f %6.2f%s\n",
+               pt->algo->name, pt->loss, pt->rtt_us / 1e3, pt->init_cwnd, pt->ssthresh,
+               g.mean, g.sd, g.p10, util, c.p50, c.p90, retx / sw.runs, tos / sw.runs,
+               incomplete ? RED " (미완료)" RESET : "");
+        if (csv)
+            fprintf(csv, "%s,%g,%g,%d,%.0f,%d,%d,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.3f,%.3f,%.3f,%.2f,%.2f,%.2f,%.2f\n",
+                    pt->algo->name, pt->loss, pt->rtt_us / 1e3, pt->init_cwnd, pt->ssthresh, sw.runs, incomplete,
+                    g.mean, g.sd, g.p10, g.p50, g.p90, util / 100, c.mean, c.p50, c.p90,
+                    retx / sw.runs, tos / sw.runs, dq / sw.runs, dr / sw.runs);
+    }
+    printf(BOLDMAG "=== %u 실행 완료: %.2f s (%.0f runs/s, steal %llu) ===\n" RESET,
+           ntasks, wall / 1e6, ntasks / (wall / 1e6), (unsigned long long)steals);
+
+    if (csv)
+    {
+        fclose(csv);
+        printf(YELLOW "[CSV] → %s\n" RESET, csv_path);
+    }
+    free(gp);
+    free(cv);
+    free(sw.res);
+    free(sw.pts);
+    return 0;
+}
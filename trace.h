@@ -0,0 +1,321 @@
+// trace.h - 혼잡제어 상태의 비동기 바이너리 트레이스
+// 전송/ACK/cwnd 변화마다 printf 로 터미널에 쓰는 대신 고정 길이 레코드(TraceRec)를 스레드별
+// 링 버퍼에 넣고, 백그라운드 writer 스레드가 파일로 모아 쓴다.
+//   - 링은 스레드 하나가 쓰고 writer 하나가 읽는 SPSC 구조라 락이 없고, 쓰는 쪽은 syscall 을 하지 않는다.
+//   - 링이 가득 차면 기다리지 않고 레코드를 버린 뒤 개수만 센다 (측정 대상의 타이밍을 바꾸지 않기 위해).
+//   - 파일은 TraceFileHdr 뒤에 레코드가 호스트 바이트 순서로 이어진다. tracedump.c 로 읽는다.
+// trace_open 전에는 trace_emit 이 아무것도 하지 않으므로 호출하는 쪽은 tracing 여부를 몰라도 된다.
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "common.h"
+
+#define TRACE_MAGIC "CCTRACE1"
+#define TRACE_RING 65536      // 스레드당 레코드 슬롯 (2의 거듭제곱)
+#define TRACE_MAX_THREADS 64
+#define TRACE_DRAIN_US 1000   // writer 가 링을 비우는 주기
+
+// 이벤트 종류. aux 의 의미는 종류마다 다름
+typedef enum
+{
+    TR_ROUND = 1,  // 라운드 시작 (aux = 라운드 번호)
+    TR_ROUND_END,  // 라운드 끝
+    TR_TX,         // 세그먼트 전송 (seq, aux = len)
+    TR_RETX,       // 재전송 (seq, aux = len)
+    TR_RCV_DATA,   // (시뮬레이션) 수신측 DATA 도착 (seq, aux = len)
+    TR_ACK,        // 새 데이터 ACK (ack, aux = RTT 표본 us, 없으면 0). cwnd 는 처리 후 값
+    TR_DUPACK,     // 중복 ACK (ack, aux = 연속 횟수)
+    TR_GROW_SS,    // 느린시작 증가
+    TR_GROW_CA,    // 혼잡회피 증가
+    TR_DUP3,       // 3 중복 ACK 사건 (aux = 감소 전 cwnd)
+    TR_RECOVERED,  // 빠른 회복 뒤 첫 새 ACK (ack)
+    TR_TIMER,      // 재전송 타이머 시작 (seq)
+    TR_TIMEOUT,    // 타임아웃 (aux = 백오프된 RTO us)
+    TR_END,        // 전송 종료
+    TR_EV_MAX
+} TraceEv;
+
+typedef struct
+{
+    uint64_t t; // us (실시간 모드는 now_us, 시뮬레이션은 가상 시계)
+    int64_t seq;
+    int64_t ack;
+    uint32_t cwnd;     // 바이트
+    uint32_t ssthresh; // 바이트
+    uint32_t aux;
+    uint16_t tid; // 기록한 스레드 (등록 순서)
+    uint8_t ev;   // TraceEv
+    uint8_t pad;
+} TraceRec;
+
+typedef struct
+{
+    char magic[8];
+    uint16_t version;
+    uint16_t rec_size;
+    uint32_t reserved;
+} TraceFileHdr;
+
+// 스레드 하나의 링. head 는 쓰는 스레드만, tail 은 writer 만 갱신하며 서로 다른 캐시 라인에 둔다
+typedef struct
+{
+    _Atomic uint64_t head;
+    uint64_t tail_cache; // 쓰는 쪽이 마지막으로 본 tail (매번 tail 을 읽지 않도록)
+    uint64_t dropped;
+    char pad0[40];
+    _Atomic uint64_t tail;
+    char pad1[56];
+    uint16_t tid;
+    TraceRec rec[TRACE_RING];
+} TraceRing;
+
+typedef struct
+{
+    int on;
+    FILE *f;
+    const char *path;
+    pthread_t writer;
+    atomic_int stop;
+    atomic_int nrings;
+    TraceRing *_Atomic rings[TRACE_MAX_THREADS];
+    uint64_t written;
+} Tracer;
+
+static Tracer tracer;
+static __thread TraceRing *tr_ring; // 이 스레드의 링, 첫 기록 때 등록
+
+static inline const char *trace_ev_name(int ev)
+{
+    static const char *names[TR_EV_MAX] = {
+        "?", "round", "round_end", "tx", "retx", "rcv_data", "ack", "dupack",
+        "grow_ss", "grow_ca", "dup3", "recovered", "timer", "timeout", "end"};
+    return ev > 0 && ev < TR_EV_MAX ? names[ev] : "?";
+}
+
+// ------------------------------ writer ------------------------------
+// 링 하나에 쌓인 레코드를 파일로 옮기고 옮긴 개수 반환
+static inline uint64_t trace_drain(TraceRing *r)
+{
+    uint64_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    uint64_t n = head - tail;
+    if (!n)
+        return 0;
+
+    // 링 끝에서 감기는 경우 두 번에 나눠 씀
+    uint64_t i = tail & (TRACE_RING - 1);
+    uint64_t first = n < TRACE_RING - i ? n : TRACE_RING - i;
+    fwrite(&r->rec[i], sizeof(TraceRec), first, tracer.f);
+    if (n > first)
+        fwrite(&r->rec[0], sizeof(TraceRec), n - first, tracer.f);
+
+    atomic_store_explicit(&r->tail, head, memory_order_release);
+    tracer.written += n;
+    return n;
+}
+
+static inline void *trace_writer(void *arg)
+{
+    (void)arg;
+    struct timespec ts = {0, TRACE_DRAIN_US * 1000};
+    while (1)
+    {
+        int stop = atomic_load(&tracer.stop);
+        uint64_t moved = 0;
+        int n = atomic_load(&tracer.nrings);
+        for (int i = 0; i < n; i++)
+        {
+            TraceRing *r = atomic_load_explicit(&tracer.rings[i], memory_order_acquire);
+            if (r)
+                moved += trace_drain(r);
+        }
+        // 종료 요청 이후 한 바퀴 더 돌아 남은 레코드까지 비운 뒤 끝냄
+        if (stop && !moved)
+            break;
+        if (!moved)
+            nanosleep(&ts, NULL);
+    }
+    return NULL;
+}
+
+// ------------------------------ API ------------------------------
+static inline void trace_open(const char *path)
+{
+    tracer.f = fopen(path, "wb");
+    if (!tracer.f)
+        die("fopen trace");
+    tracer.path = path;
+
+    TraceFileHdr h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, TRACE_MAGIC, 8);
+    h.version = 1;
+    h.rec_size = sizeof(TraceRec);
+    fwrite(&h, sizeof(h), 1, tracer.f);
+
+    atomic_init(&tracer.stop, 0);
+    atomic_init(&tracer.nrings, 0);
+    if (pthread_create(&tracer.writer, NULL, trace_writer, NULL) != 0)
+        die("pthread_create trace");
+    tracer.on = 1;
+}
+
+// 이 스레드의 링을 만들어 writer 에 등록 (스레드당 한 번)
+static inline TraceRing *trace_ring_new(void)
+{
+    int i = atomic_fetch_add(&tracer.nrings, 1);
+    if (i >= TRACE_MAX_THREADS)
+        die("trace: too many threads");
+    TraceRing *r = calloc(1, sizeof(*r));
+    if (!r)
+        die("calloc trace ring");
+    r->tid = i;
+    atomic_store_explicit(&tracer.rings[i], r, memory_order_release);
+    return r;
+}
+
+static inline void trace_emit(int ev, uint64_t t, int64_t seq, int64_t ack,
+                              double cwnd, double ssthresh, uint32_t aux)
+{
+    if (!tracer.on)
+        return;
+    TraceRing *r = tr_ring;
+    if (!r)
+        r = tr_ring = trace_ring_new();
+
+    uint64_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    if (head - r->tail_cache >= TRACE_RING)
+    {
+        r->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+        if (head - r->tail_cache >= TRACE_RING)
+        {
+            r->dropped++; // writer 가 못 따라옴: 기다리지 않고 버림
+            return;
+        }
+    }
+
+    TraceRec *p = &r->rec[head & (TRACE_RING - 1)];
+    p->t = t;
+    p->seq = seq;
+    p->ack = ack;
+    p->cwnd = cwnd < 4294967295.0 ? (uint32_t)cwnd : UINT32_MAX;
+    p->ssthresh = ssthresh < 4294967295.0 ? (uint32_t)ssthresh : UINT32_MAX;
+    p->aux = aux;
+    p->tid = r->tid;
+    p->ev = ev;
+    p->pad = 0;
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+}
+
+// writer 를 멈추고 남은 레코드를 모두 쓴 뒤 파일을 닫는다. 기록한 스레드들은 이미 끝났어야 함
+static inline void trace_close(void)
+{
+    if (!tracer.on)
+        return;
+    tracer.on = 0;
+    atomic_store(&tracer.stop, 1);
+    pthread_join(tracer.writer, NULL);
+
+    uint64_t dropped = 0;
+    int n = atomic_load(&tracer.nrings);
+    for (int i = 0; i < n && i < TRACE_MAX_THREADS; i++)
+    {
+        TraceRing *r = atomic_load(&tracer.rings[i]);
+        if (!r)
+            continue;
+        dropped += r->dropped;
+        free(r);
+        tracer.rings[i] = NULL;
+    }
+    tr_ring = NULL;
+    fclose(tracer.f);
+    printf(YELLOW "[TRACE] %llu records → %s (dropped %llu)\n" RESET,
+           (unsigned long long)tracer.written, tracer.path, (unsigned long long)dropped);
+}
+
+// ------------------------------ 출력 (tracedump) ------------------------------
+// 레코드 하나를 송신자의 기존 컬러 출력과 같은 모양으로
+static inline void trace_pretty(FILE *out, const TraceRec *r)
+{
+    double cw = r->cwnd / (double)MSS, th = r->ssthresh / (double)MSS;
+    switch (r->ev)
+    {
+    case TR_ROUND:
+        fprintf(out, MAGENTA "┌──────────────────────────────────────────────────────────┐\n" RESET);
+        fprintf(out, MAGENTA "│  ROUND %u  │  cwnd = %.2f MSS   ssthresh = %.2f MSS          │\n" RESET,
+                r->aux, cw, th);
+        fprintf(out, MAGENTA "├──────────────────────────────────────────────────────────┤\n" RESET);
+        break;
+    case TR_ROUND_END:
+        fprintf(out, MAGENTA "└──────────────────────────────────────────────────────────┘\n" RESET);
+        break;
+    case TR_TX:
+        fprintf(out, BLUE "  [TX] seq=%lld len=%u\n" RESET, (long long)r->seq, r->aux);
+        break;
+    case TR_RETX:
+        fprintf(out, BLUE "  [TX] seq=%lld len=%u (재전송)\n" RESET, (long long)r->seq, r->aux);
+        break;
+    case TR_RCV_DATA:
+        fprintf(out, BLUE "[RCV] DATA 수신   ◀◀◀   " RESET "seq=%lld, len=%u\n", (long long)r->seq, r->aux);
+        break;
+    case TR_ACK:
+        fprintf(out, GREEN "  [RX] ACK %lld" RESET, (long long)r->ack);
+        if (r->aux)
+            fprintf(out, " (RTT %.3fms)", r->aux / 1e3);
+        fprintf(out, "  cwnd=%.2f MSS ssthresh=%.2f MSS\n", cw, th);
+        break;
+    case TR_DUPACK:
+        fprintf(out, YELLOW "    중복 ACK %lld (%u회)\n" RESET, (long long)r->ack, r->aux);
+        break;
+    case TR_GROW_SS:
+        fprintf(out, YELLOW "     ↳ Slow Start 증가 → cwnd=%.2f MSS\n" RESET, cw);
+        break;
+    case TR_GROW_CA:
+        fprintf(out, YELLOW "     ↳ CA 증가 → cwnd=%.2f MSS\n" RESET, cw);
+        break;
+    case TR_DUP3:
+        fprintf(out, BOLDRED "\n*** <<< 3 DUP ACK 사건 발생 >>> ***\n" RESET);
+        fprintf(out, BOLDYEL "    cwnd: %.1f MSS → %.1f MSS\n" RESET, r->aux / (double)MSS, cw);
+        fprintf(out, BOLDMAG "    ssthresh = %.1f MSS\n" RESET, th);
+        break;
+    case TR_RECOVERED:
+        fprintf(out, YELLOW "    빠른 회복 종료 → cwnd=%.2f MSS\n" RESET, cw);
+        break;
+    case TR_TIMER:
+        fprintf(out, BOLDCYN "*** (타이머 시작) seq=%lld ***\n" RESET, (long long)r->seq);
+        break;
+    case TR_TIMEOUT:
+        fprintf(out, BOLDRED "\n*** <<< TIMEOUT 발생 >>> ***\n" RESET);
+        fprintf(out, BOLDMAG "    ssthresh = %.2f MSS\n" RESET, th);
+        fprintf(out, BOLDYEL "    cwnd = %.2f MSS 로 감소\n" RESET, cw);
+        fprintf(out, BOLDCYN "    RTO 백오프 → %.3fms\n" RESET, r->aux / 1e3);
+        break;
+    case TR_END:
+        fprintf(out, BOLDMAG "\n=== [전송 종료] ===\n" RESET);
+        break;
+    default:
+        fprintf(out, RED "  (알 수 없는 레코드 ev=%u)\n" RESET, r->ev);
+    }
+}
+
+static inline void trace_csv_header(FILE *out)
+{
+    fprintf(out, "t_us,tid,event,seq,ack,cwnd,ssthresh,aux\n");
+}
+
+static inline void trace_csv(FILE *out, const TraceRec *r)
+{
+    fprintf(out, "%llu,%u,%s,%lld,%lld,%u,%u,%u\n",
+            (unsigned long long)r->t, r->tid, trace_ev_name(r->ev), (long long)r->seq,
+            (long long)r->ack, r->cwnd, r->ssthresh, r->aux);
+}
+
+#endif
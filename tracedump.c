@@ -0,0 +1,81 @@
+// tracedump.c - sender -q 로 기록한 바이너리 트레이스 해석기
+// 실행 방법:
+//   ./tracedump [-t] <trace.bin>          기존 컬러 출력 형태로 재구성 (-t: 첫 레코드 기준 시각 표시)
+//   ./tracedump -c <trace.bin> > a.csv    CSV (t_us,tid,event,seq,ack,cwnd,ssthresh,aux), cwnd 그래프용
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "trace.h"
+
+int main(int argc, char **argv)
+{
+    int csv = 0;   // -c
+    int stamp = 0; // -t
+    int opt;
+    while ((opt = getopt(argc, argv, "ct")) != -1)
+    {
+        if (opt == 'c')
+            csv = 1;
+        else if (opt == 't')
+            stamp = 1;
+        else
+        {
+            fprintf(stderr, "usage: %s [-c] [-t] <trace.bin>\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc)
+    {
+        fprintf(stderr, "usage: tracedump [-c] [-t] <trace.bin>\n");
+        return 1;
+    }
+
+    FILE *f = fopen(argv[optind], "rb");
+    if (!f)
+        die("fopen");
+
+    TraceFileHdr h;
+    if (fread(&h, sizeof(h), 1, f) != 1 || memcmp(h.magic, TRACE_MAGIC, 8) != 0)
+    {
+        fprintf(stderr, "트레이스 파일이 아닙니다: %s\n", argv[optind]);
+        return 1;
+    }
+    if (h.version != 1 || h.rec_size != sizeof(TraceRec))
+    {
+        fprintf(stderr, "지원하지 않는 트레이스 형식 (version %u, record %u bytes)\n", h.version, h.rec_size);
+        return 1;
+    }
+
+    if (csv)
+        trace_csv_header(stdout);
+
+    TraceRec buf[4096];
+    uint64_t n = 0, t0 = 0;
+    size_t k;
+    while ((k = fread(buf, sizeof(TraceRec), 4096, f)) > 0)
+    {
+        for (size_t i = 0; i < k; i++)
+        {
+            const TraceRec *r = &buf[i];
+            if (n++ == 0)
+                t0 = r->t;
+            if (csv)
+                trace_csv(stdout, r);
+            else
+            {
+                if (stamp)
+                    printf(WHITE "[t=%8.3fs] " RESET, (r->t - t0) / 1e6);
+                trace_pretty(stdout, r);
+            }
+        }
+    }
+
+    if (!csv)
+        printf("\n(%llu records)\n", (unsigned long long)n);
+    fclose(f);
+    return 0;
+}
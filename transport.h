@@ -0,0 +1,455 @@
+// transport.h - 세그먼트 송수신 경로 추상화
+//   TP_UDP: 기존 UDP 소켓 (sendmsg / recvfrom)
+//   TP_SHM: 공유 메모리 세그먼트(shm_open + mmap) 안의 단일 생산자/단일 소비자 lock-free 링 두 개.
+//           DATA 링은 sender → receiver, ACK 링은 receiver → sender. 커널 UDP 스택을 거치지 않으므로
+//           프로토콜 처리 자체의 비용만 남는다.
+// 링은 head(생산자만 씀)와 tail(소비자만 씀)을 서로 다른 캐시 라인에 두고, 슬롯은 [길이 4바이트][데이터].
+// 받는 쪽은 슬롯을 복사하지 않고 가리키는 포인터로 처리한 뒤 tp_recv_done 으로 돌려준다.
+// 링이 가득 차면 UDP 소켓 버퍼가 넘칠 때처럼 버린다 (양쪽이 서로를 기다리다 멈추는 일이 없도록).
+// 비어 있는 링을 기다릴 때는 잠깐 확인을 반복한 뒤 futex 로 잠들고, 생산자는 잠든 소비자가 있을 때만 깨운다.
+// busy-poll(-y) 이면 잠들지 않고 계속 확인한다 (지연은 최소, 코어 하나를 계속 씀).
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#define HAVE_FUTEX 1
+#else
+#define HAVE_FUTEX 0
+#endif
+
+#include "batch_io.h"
+#include "common.h"
+
+#define SHM_MAGIC "CCSHMTP1"
+#define SHM_DATA_SLOTS 8192 // 2의 거듭제곱
+#define SHM_DATA_SLOT 2048  // 길이 + 헤더(텍스트 형식 포함) + MSS
+#define SHM_ACK_SLOTS 8192
+#define SHM_ACK_SLOT 512    // 길이 + 헤더 + SACK 블록
+#define SHM_SPIN 128        // 잠들기 전에 링을 확인하는 횟수 (코어를 나눠 쓰면 길게 돌수록 손해)
+#define SHM_SLEEP_MAX_US 100000 // 한 번에 잠드는 최대 시간 (깨움을 놓쳐도 이 안에 다시 확인)
+
+enum
+{
+    TP_UDP,
+    TP_SHM
+};
+
+typedef struct
+{
+    _Atomic uint64_t head;     // 생산자가 다음에 쓸 위치
+    _Atomic uint32_t waiting;  // 소비자가 futex 로 잠들어 있으면 1
+    uint32_t consumer_polls;   // 소비자가 busy-poll 이면 1 (생산자가 깨움 확인을 생략)
+    char pad0[48];
+    _Atomic uint64_t tail;     // 소비자가 다음에 읽을 위치
+    char pad1[56];
+    uint32_t slots, slot_size;
+    char pad2[56];
+} ShmRing; // 뒤에 slots * slot_size 바이트가 이어짐
+
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t data_off, ack_off; // 세그먼트 시작부터 각 링까지
+    char pad[32];
+} ShmHdr;
+
+typedef struct
+{
+    int kind;
+    int fd;               // TP_UDP: 소켓, TP_SHM: -1
+    uint64_t timeout_us;  // 수신 대기 한도, 0 이면 무한 (SO_RCVTIMEO 와 같은 의미)
+    uint64_t *syscalls;   // 송수신에 쓴 syscall 수를 더할 카운터 (NULL 가능)
+
+    // TP_UDP: tp_recv 가 채우는 버퍼
+    uint8_t *rxbuf;
+    int rxcap;
+    int gro;     // UDP_GRO 가 켜져 있으면 recvmsg 로 cmsg 까지 받음 (tp_udp_gro)
+    int gro_seg; // 직전에 받은 데이터그램의 GRO 세그먼트 크기 (합쳐지지 않았으면 0)
+
+    // TP_SHM
+    void *map;
+    size_t map_len;
+    char name[64];
+    int owner; // 세그먼트를 만든 쪽 (닫을 때 unlink)
+    ShmRing *tx, *rx;
+    uint64_t tx_tail_cache; // 생산자가 마지막으로 본 tail (매번 상대 캐시 라인을 읽지 않도록)
+    uint64_t rx_head_cache; // 소비자가 마지막으로 본 head
+    int busy_poll;
+    uint64_t tx_drops, sleeps;
+} Transport;
+
+static inline const char *tp_name(const Transport *tp)
+{
+    return tp->kind == TP_SHM ? (tp->busy_poll ? "shm ring, busy-poll" : "shm ring") : "udp";
+}
+
+static inline void tp_count(Transport *tp)
+{
+    if (tp->syscalls)
+        (*tp->syscalls)++;
+}
+
+// ------------------------------ UDP ------------------------------
+static inline void tp_udp(Transport *tp, int fd, int rxcap, uint64_t *syscalls)
+{
+    memset(tp, 0, sizeof(*tp));
+    tp->kind = TP_UDP;
+    tp->fd = fd;
+    tp->syscalls = syscalls;
+    tp->rxcap = rxcap;
+    tp->rxbuf = malloc(rxcap);
+    if (!tp->rxbuf)
+        die("malloc transport");
+}
+
+// 소켓에 UDP_GRO 를 켜고 tp_recv 가 합쳐진 묶음의 세그먼트 크기(gro_seg)를 채우게 함. 실패하면 0
+static inline int tp_udp_gro(Transport *tp)
+{
+    tp->gro = udp_gro_enable(tp->fd);
+    return tp->gro;
+}
+
+// ------------------------------ 공유 메모리 링 ------------------------------
+static inline void tp_cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static inline uint8_t *shm_slot(ShmRing *r, uint64_t pos)
+{
+    return (uint8_t *)(r + 1) + (size_t)(pos & (r->slots - 1)) * r->slot_size;
+}
+
+static inline size_t shm_ring_bytes(uint32_t slots, uint32_t slot_size)
+{
+    return sizeof(ShmRing) + (size_t)slots * slot_size;
+}
+
+static inline void shm_futex_wait(_Atomic uint32_t *w, uint32_t val, uint64_t us)
+{
+#if HAVE_FUTEX
+    struct timespec ts = {(time_t)(us / 1000000), (long)(us % 1000000) * 1000};
+    syscall(SYS_futex, (uint32_t *)w, FUTEX_WAIT, val, &ts, NULL, 0);
+#else
+    (void)w;
+    (void)val;
+    usleep(us < 50 ? us : 50); // futex 가 없으면 짧게 자며 확인
+#endif
+}
+
+static inline void shm_futex_wake(_Atomic uint32_t *w)
+{
+#if HAVE_FUTEX
+    syscall(SYS_futex, (uint32_t *)w, FUTEX_WAKE, 1, NULL, NULL, 0);
+#else
+    (void)w;
+#endif
+}
+
+static inline void shm_map(Transport *tp, const char *name, int busy_poll, int create)
+{
+    memset(tp, 0, sizeof(*tp));
+    tp->kind = TP_SHM;
+    tp->fd = -1;
+    tp->busy_poll = busy_poll;
+    snprintf(tp->name, sizeof(tp->name), "%s%s", name[0] == '/' ? "" : "/", name);
+
+    size_t data_off = sizeof(ShmHdr);
+    size_t ack_off = data_off + shm_ring_bytes(SHM_DATA_SLOTS, SHM_DATA_SLOT);
+    size_t len = ack_off + shm_ring_bytes(SHM_ACK_SLOTS, SHM_ACK_SLOT);
+
+    int fd;
+    if (create)
+    {
+        shm_unlink(tp->name); // 이전 실행이 남긴 세그먼트
+        fd = shm_open(tp->name, O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0)
+            die("shm_open");
+        if (ftruncate(fd, len) < 0)
+            die("ftruncate shm");
+    }
+    else
+    {
+        fd = shm_open(tp->name, O_RDWR, 0);
+        if (fd < 0)
+            die("shm_open (receiver 를 먼저 -M 으로 실행하세요)");
+        struct stat st;
+        if (fstat(fd, &st) < 0 || (size_t)st.st_size < len)
+            die("shm 세그먼트 크기가 맞지 않음");
+    }
+    void *m = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED)
+        die("mmap shm");
+    tp->map = m;
+    tp->map_len = len;
+    tp->owner = create;
+
+    ShmHdr *h = m;
+    if (create)
+    {
+        // ftruncate 로 0 이 채워진 상태. 링 크기를 적은 뒤 magic 을 마지막에 써서 준비 완료를 알림
+        h->version = 1;
+        h->data_off = data_off;
+        h->ack_off = ack_off;
+        ShmRing *d = (ShmRing *)((uint8_t *)m + data_off), *a = (ShmRing *)((uint8_t *)m + ack_off);
+        d->slots = SHM_DATA_SLOTS;
+        d->slot_size = SHM_DATA_SLOT;
+        a->slots = SHM_ACK_SLOTS;
+        a->slot_size = SHM_ACK_SLOT;
+        atomic_thread_fence(memory_order_release);
+        memcpy(h->magic, SHM_MAGIC, 8);
+    }
+    else
+    {
+        if (memcmp(h->magic, SHM_MAGIC, 8) != 0 || h->version != 1)
+            die("shm 세그먼트 형식이 다름");
+        atomic_thread_fence(memory_order_acquire);
+    }
+}
+
+// receiver 쪽: 세그먼트를 만들고 DATA 링을 읽고 ACK 링에 쓴다
+static inline void tp_shm_create(Transport *tp, const char *name, int busy_poll, uint64_t *syscalls)
+{
+    shm_map(tp, name, busy_poll, 1);
+    ShmHdr *h = tp->map;
+    tp->rx = (ShmRing *)((uint8_t *)tp->map + h->data_off);
+    tp->tx = (ShmRing *)((uint8_t *)tp->map + h->ack_off);
+    tp->rx->consumer_polls = busy_poll;
+    tp->syscalls = syscalls;
+}
+
+// sender 쪽: receiver 가 만든 세그먼트에 붙어 DATA 링에 쓰고 ACK 링을 읽는다
+static inline void tp_shm_open(Transport *tp, const char *name, int busy_poll, uint64_t *syscalls)
+{
+    shm_map(tp, name, busy_poll, 0);
+    ShmHdr *h = tp->map;
+    tp->tx = (ShmRing *)((uint8_t *)tp->map + h->data_off);
+    tp->rx = (ShmRing *)((uint8_t *)tp->map + h->ack_off);
+    tp->rx->consumer_polls = busy_poll;
+    tp->tx_tail_cache = atomic_load(&tp->tx->tail);
+    tp->syscalls = syscalls;
+}
+
+static inline int shm_send(Transport *tp, const void *hdr, int hl, const void *payload, int len)
+{
+    ShmRing *r = tp->tx;
+    if ((uint32_t)(4 + hl + len) > r->slot_size)
+    {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    uint64_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    if (head - tp->tx_tail_cache >= r->slots)
+    {
+        tp->tx_tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+        if (head - tp->tx_tail_cache >= r->slots)
+        {
+            tp->tx_drops++; // 가득 참: 소켓 버퍼가 넘친 것처럼 버림
+            errno = ENOBUFS;
+            return -1;
+        }
+    }
+
+    uint8_t *s = shm_slot(r, head);
+    memcpy(s + 4, hdr, hl);
+    if (len)
+        memcpy(s + 4 + hl, payload, len);
+    uint32_t n = hl + len;
+    memcpy(s, &n, 4);
+
+    if (r->consumer_polls)
+    {
+        atomic_store_explicit(&r->head, head + 1, memory_order_release);
+        return n;
+    }
+    // 소비자가 잠들 수 있으면: head 공개와 waiting 확인 사이에 순서를 강제 (소비자 쪽과 짝)
+    atomic_store_explicit(&r->head, head + 1, memory_order_seq_cst);
+    if (atomic_load_explicit(&r->waiting, memory_order_seq_cst))
+    {
+        atomic_store(&r->waiting, 0);
+        shm_futex_wake(&r->waiting);
+        tp_count(tp);
+    }
+    return n;
+}
+
+// 데이터가 올 때까지 기다림. timeout 이면 0
+static inline int shm_wait(Transport *tp, ShmRing *r, uint64_t tail)
+{
+    uint64_t deadline = tp->timeout_us ? now_us() + tp->timeout_us : 0;
+    for (uint32_t spin = 0;; spin++)
+    {
+        tp->rx_head_cache = atomic_load_explicit(&r->head, memory_order_acquire);
+        if (tp->rx_head_cache != tail)
+            return 1;
+
+        if (tp->busy_poll || spin < SHM_SPIN)
+        {
+            tp_cpu_relax();
+            if ((spin & 1023) == 1023 && deadline && now_us() >= deadline)
+                return 0;
+            continue;
+        }
+
+        uint64_t sleep_us = SHM_SLEEP_MAX_US;
+        if (deadline)
+        {
+            uint64_t now = now_us();
+            if (now >= deadline)
+                return 0;
+            if (deadline - now < sleep_us)
+                sleep_us = deadline - now;
+        }
+        atomic_store_explicit(&r->waiting, 1, memory_order_seq_cst);
+        if (atomic_load_explicit(&r->head, memory_order_seq_cst) == tail)
+        {
+            shm_futex_wait(&r->waiting, 1, sleep_us);
+            tp_count(tp);
+            tp->sleeps++;
+        }
+        atomic_store_explicit(&r->waiting, 0, memory_order_relaxed);
+    }
+}
+
+// ------------------------------ 공통 API ------------------------------
+// 수신 대기 한도 (us, 0 이면 무한). UDP 는 SO_RCVTIMEO
+static inline void tp_set_timeout(Transport *tp, uint64_t us)
+{
+    tp->timeout_us = us;
+    if (tp->kind == TP_UDP)
+    {
+        struct timeval tv;
+        tv.tv_sec = us / 1000000;
+        tv.tv_usec = us % 1000000;
+        setsockopt(tp->fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+}
+
+// 헤더 + 페이로드를 데이터그램 하나로 전송. 페이로드는 UDP 에서는 복사 없이 iovec 으로 묶음
+static inline int tp_sendv(Transport *tp, const struct sockaddr_in *to, const void *hdr, int hl,
+                           const void *payload, int len)
+{
+    if (tp->kind == TP_SHM)
+        return shm_send(tp, hdr, hl, payload, len);
+
+    struct iovec iov[2];
+    iov[0].iov_base = (void *)hdr;
+    iov[0].iov_len = hl;
+    iov[1].iov_base = (void *)payload;
+    iov[1].iov_len = len;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = (void *)to;
+    msg.msg_namelen = sizeof(*to);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = len ? 2 : 1;
+    tp_count(tp);
+    return (int)sendmsg(tp->fd, &msg, 0);
+}
+
+// 데이터그램 하나를 받아 *data 가 가리키게 하고 길이 반환. 실패/timeout 이면 -1 (errno 유지, timeout 은 EAGAIN).
+// *data 는 tp_recv_done 을 부를 때까지 유효. from 에는 보낸 쪽 주소 (SHM 은 loopback:0 으로 고정)
+static inline int tp_recv(Transport *tp, const uint8_t **data, struct sockaddr_in *from)
+{
+    if (tp->kind == TP_UDP && tp->gro)
+    {
+        struct iovec iov = {tp->rxbuf, (size_t)tp->rxcap};
+        union
+        {
+            char buf[GRO_CTRL];
+            struct cmsghdr align;
+        } ctrl;
+        struct msghdr m;
+        memset(&m, 0, sizeof(m));
+        m.msg_name = from;
+        m.msg_namelen = from ? sizeof(*from) : 0;
+        m.msg_iov = &iov;
+        m.msg_iovlen = 1;
+        m.msg_control = ctrl.buf;
+        m.msg_controllen = sizeof(ctrl.buf);
+        int n = (int)recvmsg(tp->fd, &m, 0);
+        tp_count(tp);
+        tp->gro_seg = n > 0 ? gro_seg_size(&m) : 0;
+        *data = tp->rxbuf;
+        return n;
+    }
+    if (tp->kind == TP_UDP)
+    {
+        socklen_t flen = sizeof(*from);
+        int n = (int)recvfrom(tp->fd, tp->rxbuf, tp->rxcap, 0, (struct sockaddr *)from, from ? &flen : NULL);
+        tp_count(tp);
+        *data = tp->rxbuf;
+        return n;
+    }
+
+    ShmRing *r = tp->rx;
+    uint64_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    if (tail == tp->rx_head_cache && !shm_wait(tp, r, tail))
+    {
+        errno = EAGAIN;
+        return -1;
+    }
+    const uint8_t *s = shm_slot(r, tail);
+    uint32_t n;
+    memcpy(&n, s, 4);
+    *data = s + 4;
+    if (from)
+    {
+        memset(from, 0, sizeof(*from));
+        from->sin_family = AF_INET;
+        from->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    }
+    return (int)n;
+}
+
+// tp_recv 로 받은 슬롯을 생산자에게 돌려줌
+static inline void tp_recv_done(Transport *tp)
+{
+    if (tp->kind != TP_SHM)
+        return;
+    uint64_t tail = atomic_load_explicit(&tp->rx->tail, memory_order_relaxed);
+    atomic_store_explicit(&tp->rx->tail, tail + 1, memory_order_release);
+}
+
+static inline void tp_close(Transport *tp)
+{
+    if (tp->kind == TP_SHM)
+    {
+        munmap(tp->map, tp->map_len);
+        if (tp->owner)
+            shm_unlink(tp->name);
+    }
+    else
+    {
+        free(tp->rxbuf);
+    }
+    tp->map = NULL;
+    tp->rxbuf = NULL;
+}
+
+#endif
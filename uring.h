@@ -0,0 +1,538 @@
+// uring.h - io_uring 수신 경로 (receiver -u / -U)
+// liburing 없이 커널 헤더와 syscall 만으로 링을 만든다.
+//   수신: 등록한 provided buffer 링(IORING_REGISTER_PBUF_RING)에서 커널이 버퍼를 골라 쓰는 multishot
+//         recvmsg SQE 하나가 데이터그램마다 CQE 를 낸다. 처리한 버퍼는 링 tail 만 올려 돌려준다.
+//   송신: ACK 는 슬롯(msghdr + 주소 + 헤더 버퍼)에 인코딩해 SENDMSG SQE 로 쌓아 두고, 다음에 CQE 를
+//         기다릴 때 io_uring_enter 한 번으로 함께 제출한다 (패킷마다의 sendto 가 없음).
+//   SQPOLL(-U): 커널 스레드가 SQ 를 계속 확인하므로 제출에 syscall 이 없고, CQ 가 비었을 때만
+//         잠깐 돌며 확인한 뒤 io_uring_enter 로 잠든다.
+// multishot recvmsg 는 Linux 6.0, provided buffer 링은 5.19 이상. 만들 수 없으면 ur_new 가 NULL 을
+// 돌려주고 receiver 는 기존 경로로 동작한다.
+#ifndef URING_H
+#define URING_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include "batch_io.h"
+#include "common.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <signal.h>
+#include <unistd.h>
+#if defined(IORING_RECV_MULTISHOT) && defined(__NR_io_uring_setup)
+#define HAVE_URING 1
+#endif
+#endif
+#endif
+#ifndef HAVE_URING
+#define HAVE_URING 0
+#endif
+
+#define UR_SQ 1024         // SQ 크기 (한 번에 제출할 수 있는 SQE)
+#define UR_CQ 8192         // CQ 크기 (multishot 수신 CQE 가 몰려도 넘치지 않게)
+#define UR_BUFS 4096       // provided buffer 수 (2의 거듭제곱, 데이터그램 하나씩)
+#define UR_BUF 2048        // 버퍼 하나 (recvmsg_out + 주소 + 헤더 + MSS)
+#define UR_GRO_BUFS 512    // GRO 면 묶음 하나가 64KB 까지
+#define UR_GRO_BUF (DGRAM_BUF + 128)
+#define UR_ACK_SLOTS 2048  // 제출했지만 아직 완료되지 않은 ACK 송신 수의 상한
+#define UR_SPIN_US 50      // SQPOLL 에서 CQ 가 비었을 때 잠들기 전에 확인하는 시간
+#define UR_SQ_IDLE_MS 100  // SQPOLL 커널 스레드가 잠드는 유휴 시간
+
+#define UR_TAG_RECV (1ULL << 63)
+
+// 통계 (receiver 가 워커별로 합산)
+typedef struct
+{
+    uint64_t enters;    // io_uring_enter 호출
+    uint64_t recv_cqes; // 데이터그램 CQE
+    uint64_t rearms;    // multishot recvmsg 를 다시 건 횟수 (버퍼 바닥 등)
+    uint64_t acks_sqe;  // SQE 로 보낸 ACK
+    uint64_t acks_sync; // 슬롯이 모자라 sendmsg 로 바로 보낸 ACK
+    uint64_t wakeups;   // SQPOLL 커널 스레드를 깨운 횟수
+    uint64_t send_errs, truncated;
+} UrStats;
+
+static inline void ur_stats_add(UrStats *d, const UrStats *s)
+{
+    d->enters += s->enters;
+    d->recv_cqes += s->recv_cqes;
+    d->rearms += s->rearms;
+    d->acks_sqe += s->acks_sqe;
+    d->acks_sync += s->acks_sync;
+    d->wakeups += s->wakeups;
+    d->send_errs += s->send_errs;
+    d->truncated += s->truncated;
+}
+
+typedef struct
+{
+    struct msghdr msg;
+    struct iovec iov;
+    struct sockaddr_in to;
+    uint8_t hdr[IO_HDR_MAX];
+} UrSlot;
+
+typedef struct
+{
+    int fd;
+    int sqpoll;
+    int sock;
+    unsigned sq_entries, cq_entries;
+
+    // SQ / CQ 링 (커널과 공유하는 mmap 영역 안의 포인터)
+    void *sq_map, *cq_map;
+    size_t sq_map_len, cq_map_len;
+    _Atomic uint32_t *sq_head, *sq_tail, *sq_flags;
+    uint32_t sq_mask;
+    uint32_t *sq_array;
+#if HAVE_URING
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    struct io_uring_buf_ring *br;
+#endif
+    size_t sqes_len;
+    _Atomic uint32_t *cq_head, *cq_tail;
+    uint32_t cq_mask;
+    uint32_t tail;      // 다음에 채울 SQE 위치 (커널에 알린 것은 *sq_tail)
+    uint32_t submitted; // 커널에 넘긴 위치 (SQPOLL 이 아니면 io_uring_enter 의 to_submit 계산용)
+
+    // provided buffer 링
+    uint8_t *bufs;
+    size_t br_len;
+    uint32_t nbufs, buf_size, br_tail;
+    int armed; // multishot recvmsg 가 살아 있음
+    struct msghdr rmsg; // multishot recvmsg 가 쓰는 형식 (주소/cmsg 길이만)
+
+    // ACK 슬롯
+    UrSlot *slots;
+    int *free_slots;
+    int nfree;
+
+    uint64_t *syscalls;
+    UrStats st;
+} Uring;
+
+#if HAVE_URING
+static inline int ur_enter(Uring *u, unsigned to_submit, unsigned min_complete, unsigned flags, void *arg,
+                           size_t argsz)
+{
+    u->st.enters++;
+    if (u->syscalls)
+        (*u->syscalls)++;
+    return (int)syscall(__NR_io_uring_enter, u->fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+static inline void ur_provide(Uring *u, uint32_t bid)
+{
+    struct io_uring_buf *b = &u->br->bufs[u->br_tail & (u->nbufs - 1)];
+    b->addr = (uint64_t)(uintptr_t)(u->bufs + (size_t)bid * u->buf_size);
+    b->len = u->buf_size;
+    b->bid = (uint16_t)bid;
+    u->br_tail++;
+}
+
+// 돌려준 버퍼들을 커널에 알림
+static inline void ur_provide_commit(Uring *u)
+{
+    atomic_store_explicit((_Atomic uint16_t *)&u->br->tail, (uint16_t)u->br_tail, memory_order_release);
+}
+#endif
+
+// 링, provided buffer, ACK 슬롯을 만든다. gro 면 64KB 버퍼. 실패하면 이유를 출력하고 NULL
+static inline Uring *ur_new(int sock, int sqpoll, int gro, uint64_t *syscalls)
+{
+#if HAVE_URING
+    Uring *u = calloc(1, sizeof(*u));
+    if (!u)
+        die("calloc uring");
+    u->sock = sock;
+    u->syscalls = syscalls;
+
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    p.cq_entries = UR_CQ;
+    if (sqpoll)
+    {
+        p.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SQPOLL;
+        p.sq_thread_idle = UR_SQ_IDLE_MS;
+        u->fd = (int)syscall(__NR_io_uring_setup, UR_SQ, &p);
+        if (u->fd < 0)
+        {
+            fprintf(stderr, "io_uring SQPOLL: %s, SQPOLL 없이 진행\n", strerror(errno));
+            sqpoll = 0;
+        }
+    }
+    if (!sqpoll)
+    {
+        // 완료 처리를 io_uring_enter 때로 미뤄 수신 중 인터럽트성 작업을 줄임 (6.1 이상, 아니면 기본)
+        memset(&p, 0, sizeof(p));
+        p.cq_entries = UR_CQ;
+        p.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+        u->fd = (int)syscall(__NR_io_uring_setup, UR_SQ, &p);
+        if (u->fd < 0)
+        {
+            memset(&p, 0, sizeof(p));
+            p.cq_entries = UR_CQ;
+            p.flags = IORING_SETUP_CQSIZE;
+            u->fd = (int)syscall(__NR_io_uring_setup, UR_SQ, &p);
+        }
+    }
+    if (u->fd < 0)
+    {
+        fprintf(stderr, "io_uring_setup: %s\n", strerror(errno));
+        free(u);
+        return NULL;
+    }
+    if (!(p.features & IORING_FEAT_EXT_ARG))
+    {
+        fprintf(stderr, "io_uring: IORING_FEAT_EXT_ARG 미지원 (Linux 5.11 이상 필요)\n");
+        close(u->fd);
+        free(u);
+        return NULL;
+    }
+    u->sqpoll = sqpoll;
+    u->sq_entries = p.sq_entries;
+    u->cq_entries = p.cq_entries;
+
+    u->sq_map_len = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+    u->cq_map_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    int single = p.features & IORING_FEAT_SINGLE_MMAP;
+    if (single && u->cq_map_len > u->sq_map_len)
+        u->sq_map_len = u->cq_map_len;
+    u->sq_map = mmap(NULL, u->sq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd,
+                     IORING_OFF_SQ_RING);
+    if (u->sq_map == MAP_FAILED)
+        die("mmap io_uring sq");
+    if (single)
+        u->cq_map = u->sq_map;
+    else
+    {
+        u->cq_map = mmap(NULL, u->cq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd,
+                         IORING_OFF_CQ_RING);
+        if (u->cq_map == MAP_FAILED)
+            die("mmap io_uring cq");
+    }
+    u->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    u->sqes = mmap(NULL, u->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd,
+                   IORING_OFF_SQES);
+    if (u->sqes == MAP_FAILED)
+        die("mmap io_uring sqes");
+
+    uint8_t *sq = u->sq_map, *cq = u->cq_map;
+    u->sq_head = (_Atomic uint32_t *)(sq + p.sq_off.head);
+    u->sq_tail = (_Atomic uint32_t *)(sq + p.sq_off.tail);
+    u->sq_flags = (_Atomic uint32_t *)(sq + p.sq_off.flags);
+    u->sq_mask = *(uint32_t *)(sq + p.sq_off.ring_mask);
+    u->sq_array = (uint32_t *)(sq + p.sq_off.array);
+    for (uint32_t i = 0; i < p.sq_entries; i++)
+        u->sq_array[i] = i; // SQE 위치와 배열 순서를 같게 고정
+    u->cq_head = (_Atomic uint32_t *)(cq + p.cq_off.head);
+    u->cq_tail = (_Atomic uint32_t *)(cq + p.cq_off.tail);
+    u->cq_mask = *(uint32_t *)(cq + p.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    u->tail = u->submitted = atomic_load_explicit(u->sq_tail, memory_order_relaxed);
+
+    // provided buffer 링 등록 (그룹 0)
+    u->nbufs = gro ? UR_GRO_BUFS : UR_BUFS;
+    u->buf_size = gro ? UR_GRO_BUF : UR_BUF;
+    u->br_len = u->nbufs * sizeof(struct io_uring_buf);
+    u->br = mmap(NULL, u->br_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (u->br == MAP_FAILED)
+        die("mmap io_uring buf ring");
+    u->bufs = malloc((size_t)u->nbufs * u->buf_size);
+    if (!u->bufs)
+        die("malloc io_uring bufs");
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)u->br;
+    reg.ring_entries = u->nbufs;
+    reg.bgid = 0;
+    if (syscall(__NR_io_uring_register, u->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+    {
+        fprintf(stderr, "io_uring provided buffer ring: %s (Linux 5.19 이상 필요)\n", strerror(errno));
+        munmap(u->br, u->br_len);
+        free(u->bufs);
+        munmap(u->sqes, u->sqes_len);
+        if (u->cq_map != u->sq_map)
+            munmap(u->cq_map, u->cq_map_len);
+        munmap(u->sq_map, u->sq_map_len);
+        close(u->fd);
+        free(u);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < u->nbufs; i++)
+        ur_provide(u, i);
+    ur_provide_commit(u);
+
+    u->rmsg.msg_namelen = sizeof(struct sockaddr_in);
+    u->rmsg.msg_controllen = gro ? GRO_CTRL : 0;
+
+    u->slots = calloc(UR_ACK_SLOTS, sizeof(UrSlot));
+    u->free_slots = malloc(UR_ACK_SLOTS * sizeof(int));
+    if (!u->slots || !u->free_slots)
+        die("calloc io_uring slots");
+    for (int i = 0; i < UR_ACK_SLOTS; i++)
+    {
+        UrSlot *s = &u->slots[i];
+        s->iov.iov_base = s->hdr;
+        s->msg.msg_name = &s->to;
+        s->msg.msg_namelen = sizeof(s->to);
+        s->msg.msg_iov = &s->iov;
+        s->msg.msg_iovlen = 1;
+        u->free_slots[u->nfree++] = UR_ACK_SLOTS - 1 - i;
+    }
+    return u;
+#else
+    (void)sock, (void)sqpoll, (void)gro, (void)syscalls;
+    fprintf(stderr, "io_uring: 이 플랫폼에서는 사용할 수 없음\n");
+    return NULL;
+#endif
+}
+
+static inline void ur_free(Uring *u)
+{
+    if (!u)
+        return;
+#if HAVE_URING
+    munmap(u->br, u->br_len);
+    munmap(u->sqes, u->sqes_len);
+    if (u->cq_map != u->sq_map)
+        munmap(u->cq_map, u->cq_map_len);
+    munmap(u->sq_map, u->sq_map_len);
+    close(u->fd);
+#endif
+    free(u->bufs);
+    free(u->slots);
+    free(u->free_slots);
+    free(u);
+}
+
+#if HAVE_URING
+// 쌓아 둔 SQE 를 커널에 보이게 하고, 제출해야 할 수를 반환 (SQPOLL 이면 필요할 때 커널 스레드를 깨움)
+static inline unsigned ur_publish(Uring *u)
+{
+    atomic_store_explicit(u->sq_tail, u->tail, memory_order_release);
+    unsigned n = u->tail - u->submitted;
+    u->submitted = u->tail;
+    if (u->sqpoll)
+    {
+        // tail 저장과 flags 읽기 사이의 순서를 보장해야 잠든 커널 스레드를 놓치지 않음
+        atomic_thread_fence(memory_order_seq_cst);
+        if (n && atomic_load_explicit(u->sq_flags, memory_order_relaxed) & IORING_SQ_NEED_WAKEUP)
+        {
+            u->st.wakeups++;
+            ur_enter(u, 0, 0, IORING_ENTER_SQ_WAKEUP, NULL, 0);
+        }
+        return 0;
+    }
+    return n;
+}
+
+// 빈 SQE 하나. SQ 가 가득 차면 먼저 제출한다
+static inline struct io_uring_sqe *ur_sqe(Uring *u)
+{
+    while (u->tail - atomic_load_explicit(u->sq_head, memory_order_acquire) >= u->sq_entries)
+    {
+        unsigned n = ur_publish(u);
+        if (n)
+            ur_enter(u, n, 0, 0, NULL, 0);
+        else if (u->sqpoll)
+            sched_yield(); // 커널 스레드가 가져가기를 기다림
+    }
+    struct io_uring_sqe *e = &u->sqes[u->tail & u->sq_mask];
+    memset(e, 0, sizeof(*e));
+    u->tail++;
+    return e;
+}
+#endif
+
+// multishot recvmsg 를 (다시) 건다. 버퍼가 바닥나면(ENOBUFS) 커널이 끝내므로 버퍼를 돌려준 뒤 다시 호출
+static inline void ur_arm_recv(Uring *u)
+{
+#if HAVE_URING
+    struct io_uring_sqe *e = ur_sqe(u);
+    e->opcode = IORING_OP_RECVMSG;
+    e->fd = u->sock;
+    e->addr = (uint64_t)(uintptr_t)&u->rmsg;
+    e->len = 1;
+    e->ioprio = IORING_RECV_MULTISHOT;
+    e->flags = IOSQE_BUFFER_SELECT;
+    e->buf_group = 0;
+    e->user_data = UR_TAG_RECV;
+    u->armed = 1;
+#else
+    (void)u;
+#endif
+}
+
+// ACK 한 개를 넣을 슬롯의 헤더 버퍼. 완료되지 않은 송신이 슬롯을 모두 쓰고 있으면 NULL
+static inline uint8_t *ur_ack_buf(Uring *u)
+{
+    return u->nfree ? u->slots[u->free_slots[u->nfree - 1]].hdr : NULL;
+}
+
+// ur_ack_buf 에 채운 len 바이트 ACK 를 to 로 보내는 SENDMSG SQE 를 쌓음 (제출은 ur_wait 때)
+static inline void ur_ack_commit(Uring *u, const struct sockaddr_in *to, int len)
+{
+#if HAVE_URING
+    int i = u->free_slots[--u->nfree];
+    UrSlot *s = &u->slots[i];
+    s->to = *to;
+    s->iov.iov_len = len;
+    struct io_uring_sqe *e = ur_sqe(u);
+    e->opcode = IORING_OP_SENDMSG;
+    e->fd = u->sock;
+    e->addr = (uint64_t)(uintptr_t)&s->msg;
+    e->len = 1;
+    e->user_data = (uint64_t)i;
+    u->st.acks_sqe++;
+#else
+    (void)u, (void)to, (void)len;
+#endif
+}
+
+// 쌓인 SQE 를 제출하고 CQE 가 하나 이상 생기거나 timeout_us 가 지날 때까지 기다림 (0 이면 무한)
+static inline void ur_wait(Uring *u, uint64_t timeout_us)
+{
+#if HAVE_URING
+    unsigned n = ur_publish(u);
+    if (atomic_load_explicit(u->cq_tail, memory_order_acquire) != *u->cq_head)
+    {
+        if (n)
+            ur_enter(u, n, 0, 0, NULL, 0);
+        return;
+    }
+    if (u->sqpoll)
+    {
+        // 커널 스레드가 계속 돌고 있으니 잠깐은 CQ 만 확인
+        uint64_t t0 = now_us();
+        while (now_us() - t0 < UR_SPIN_US)
+            if (atomic_load_explicit(u->cq_tail, memory_order_acquire) != *u->cq_head)
+                return;
+    }
+    struct __kernel_timespec ts = {(long long)(timeout_us / 1000000), (long long)(timeout_us % 1000000) * 1000};
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = timeout_us ? (uint64_t)(uintptr_t)&ts : 0;
+    if (ur_enter(u, n, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg)) < 0 &&
+        errno != ETIME && errno != EINTR && errno != EBUSY)
+        die("io_uring_enter");
+#else
+    (void)u, (void)timeout_us;
+#endif
+}
+
+// 수신 CQE 하나를 풀어 쓴 결과
+typedef struct
+{
+    const uint8_t *data;
+    int len;
+    int seg; // GRO 세그먼트 크기 (합쳐지지 않았으면 0)
+    struct sockaddr_in from;
+    uint32_t bid;
+} UrRecv;
+
+// 다음 CQE 를 처리. 데이터그램이면 *r 을 채우고 1 (다 쓴 뒤 ur_recycle), ACK 송신 완료 등 다른 것은
+// 내부에서 정리하고 0, CQ 가 비었으면 -1
+static inline int ur_next(Uring *u, UrRecv *r)
+{
+#if HAVE_URING
+    uint32_t head = *u->cq_head;
+    if (head == atomic_load_explicit(u->cq_tail, memory_order_acquire))
+        return -1;
+    struct io_uring_cqe c = u->cqes[head & u->cq_mask];
+    atomic_store_explicit(u->cq_head, head + 1, memory_order_release);
+
+    if (!(c.user_data & UR_TAG_RECV))
+    {
+        u->free_slots[u->nfree++] = (int)c.user_data;
+        if (c.res < 0)
+            u->st.send_errs++; // UDP 처럼 버려진 ACK 로 취급
+        return 0;
+    }
+    if (!(c.flags & IORING_CQE_F_MORE))
+    {
+        u->armed = 0;
+        u->st.rearms++;
+    }
+    if (c.res < 0)
+    {
+        if (c.res == -ENOBUFS)
+            return 0;
+        if (c.res == -EINVAL)
+        {
+            fprintf(stderr, "io_uring: multishot recvmsg 미지원 (Linux 6.0 이상 필요)\n");
+            exit(1);
+        }
+        errno = -c.res;
+        die("io_uring recvmsg");
+    }
+    if (!(c.flags & IORING_CQE_F_BUFFER))
+        return 0;
+    uint32_t bid = c.flags >> IORING_CQE_BUFFER_SHIFT;
+    uint8_t *b = u->bufs + (size_t)bid * u->buf_size;
+    struct io_uring_recvmsg_out *o = (struct io_uring_recvmsg_out *)b;
+    u->st.recv_cqes++;
+    r->bid = bid;
+    if (o->flags & MSG_TRUNC)
+    {
+        u->st.truncated++; // 버퍼보다 큰 데이터그램은 버림
+        ur_provide(u, bid);
+        return 0;
+    }
+    memset(&r->from, 0, sizeof(r->from));
+    memcpy(&r->from, b + sizeof(*o), o->namelen < sizeof(r->from) ? o->namelen : sizeof(r->from));
+    r->seg = 0;
+    if (u->rmsg.msg_controllen && o->controllen)
+    {
+        struct msghdr m;
+        memset(&m, 0, sizeof(m));
+        m.msg_control = b + sizeof(*o) + u->rmsg.msg_namelen;
+        m.msg_controllen = o->controllen;
+        r->seg = gro_seg_size(&m);
+    }
+    r->data = b + sizeof(*o) + u->rmsg.msg_namelen + u->rmsg.msg_controllen;
+    r->len = (int)o->payloadlen;
+    return 1;
+#else
+    (void)u, (void)r;
+    return -1;
+#endif
+}
+
+// 처리한 데이터그램의 버퍼를 돌려줌 (커널에는 ur_refill 때 한꺼번에 알림)
+static inline void ur_recycle(Uring *u, const UrRecv *r)
+{
+#if HAVE_URING
+    ur_provide(u, r->bid);
+#else
+    (void)u, (void)r;
+#endif
+}
+
+// 돌려준 버퍼를 커널에 알리고, multishot 이 끝나 있으면 다시 건다
+static inline void ur_refill(Uring *u)
+{
+#if HAVE_URING
+    ur_provide_commit(u);
+    if (!u->armed)
+        ur_arm_recv(u);
+#else
+    (void)u;
+#endif
+}
+
+#endif